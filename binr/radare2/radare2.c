@@ -724,6 +724,8 @@ int main(int argc, char **argv, char **envp) {
 		r_core_cmd0 (&r, "aaa");
 		r_cons_flush ();
 	}
+	/* the output of -i and -c is not kept, write it as it comes */
+	r_cons_set_stream (true);
 	/* run -i flags */
 	cmdfile[cmdfilei] = 0;
 	for (i=0; i<cmdfilei; i++) {
@@ -743,6 +745,7 @@ int main(int argc, char **argv, char **envp) {
 		r_core_cmd0 (&r, cmdn);
 		r_cons_flush ();
 	}
+	r_cons_set_stream (false);
 	if ((cmdfile[0] || !r_list_empty (cmds)) && quiet)
 		return 0;
 	r_list_free (cmds);
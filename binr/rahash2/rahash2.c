@@ -85,6 +85,17 @@ static void do_hash_print(RHash *ctx, int hash, int dlen, int rad, int ule) {
 	}
 }
 
+static void print_entropy(double e, int rad) {
+	if (rad) {
+		eprintf ("entropy: %10f\n", e);
+	} else {
+		printf ("0x%08"PFMT64x"-0x%08"PFMT64x" %10f: ",
+				from, to-1, e);
+		r_print_progressbar (NULL, 12.5 * e, 60);
+		printf ("\n");
+	}
+}
+
 static int do_hash_internal(RHash *ctx, int hash, const ut8 *buf, int len, int rad, int print, int le) {
 	int dlen;
 	if (len<1)
@@ -93,15 +104,7 @@ static int do_hash_internal(RHash *ctx, int hash, const ut8 *buf, int len, int r
 	if (!dlen) return 0;
 	if (!print) return 1;
 	if (hash == R_HASH_ENTROPY) {
-		double e = r_hash_entropy (buf, len);
-		if (rad) {
-			eprintf ("entropy: %10f\n", e);
-		} else {
-			printf ("0x%08"PFMT64x"-0x%08"PFMT64x" %10f: ",
-					from, to-1, e);
-			r_print_progressbar (NULL, 12.5 * e, 60);
-			printf ("\n");
-		}
+		print_entropy (r_hash_entropy (buf, len), rad);
 	} else {
 		if (iterations>0)
 			r_hash_do_spice (ctx, hash, iterations, _s);
@@ -111,11 +114,77 @@ static int do_hash_internal(RHash *ctx, int hash, const ut8 *buf, int len, int r
 }
 
 
+/* one digest context for each selected algorithm, so every block is
+ * read once and fed to all of them. Large blocks are hashed by all the
+ * algorithms at the same time, one thread each */
+#define THREAD_MIN 0x100000
+
+typedef struct {
+	RHash *ctx;
+	int bit;
+	int dlen;
+	const ut8 *buf;
+	int len;
+} HashJob;
+
+static int hash_job(RThread *th) {
+	HashJob *job = th->user;
+	job->dlen = r_hash_calculate (job->ctx, job->bit, job->buf, job->len);
+	return false;
+}
+
+static void hash_jobs(HashJob *jobs, int n, const ut8 *buf, int len) {
+	RThread *th[32];
+	int i, nth = 0;
+	for (i = 0; i < n; i++) {
+		jobs[i].buf = buf;
+		jobs[i].len = len;
+	}
+	if (n > 1 && len >= THREAD_MIN) {
+		for (i = 1; i < n; i++) {
+			th[nth] = r_th_new (hash_job, &jobs[i], 0);
+			if (th[nth]) nth++;
+			else jobs[i].dlen = r_hash_calculate (jobs[i].ctx,
+				jobs[i].bit, buf, len);
+		}
+		jobs[0].dlen = r_hash_calculate (jobs[0].ctx, jobs[0].bit, buf, len);
+		for (i = 0; i < nth; i++) {
+			r_th_wait (th[i]);
+			r_th_free (th[i]);
+		}
+	} else {
+		for (i = 0; i < n; i++) {
+			jobs[i].dlen = r_hash_calculate (jobs[i].ctx,
+				jobs[i].bit, buf, len);
+		}
+	}
+}
+
+static void hash_job_print(HashJob *job, int rad, int ule) {
+	if (!job->dlen)
+		return;
+	if (job->bit == R_HASH_ENTROPY) {
+		print_entropy (r_hash_entropy (job->buf, job->len), rad);
+		return;
+	}
+	if (iterations>0)
+		r_hash_do_spice (job->ctx, job->bit, iterations, _s);
+	do_hash_print (job->ctx, job->bit, job->dlen, rad, ule);
+}
+
+static void hash_jobs_free(HashJob *jobs, int n) {
+	int i;
+	for (i = 0; i < n; i++) {
+		r_hash_free (jobs[i].ctx);
+	}
+	free (jobs);
+}
+
 static int do_hash(const char *file, const char *algo, RIO *io, int bsize, int rad, int ule) {
 	ut64 j, fsize, algobit = r_hash_name_to_bits (algo);
-	RHash *ctx;
+	HashJob *jobs;
 	ut8 *buf;
-	int i, first = 1;
+	int i, k, n = 0, first = 1;
 	if (algobit == R_HASH_NONE) {
 		eprintf ("rahash2: Invalid hashing algorithm specified\n");
 		return 1;
@@ -139,78 +208,85 @@ static int do_hash(const char *file, const char *algo, RIO *io, int bsize, int r
 	buf = malloc (bsize+1);
 	if (!buf)
 		return 1;
-	ctx = r_hash_new (R_TRUE, algobit);
+	jobs = calloc (32, sizeof (HashJob));
+	if (!jobs) {
+		free (buf);
+		return 1;
+	}
+	for (i=1; i<0x800000; i<<=1) {
+		if (algobit & i) {
+			jobs[n].bit = i;
+			jobs[n].ctx = r_hash_new (R_TRUE, i);
+			n++;
+		}
+	}
 
 	if (rad == 'j')
 		printf ("[");
 	if (incremental) {
-		for (i=1; i<0x800000; i<<=1) {
-			if (algobit & i) {
-				int hashbit = i & algobit;
-				int dlen = r_hash_size (hashbit);
-				r_hash_do_begin (ctx, i);
-				if (rad == 'j') {
-					if (first) {
-						first = 0;
-					} else {
-						printf (",");
-					}
-				}
-				if (s.buf && s.prefix) {
-					do_hash_internal (ctx,
-						hashbit, s.buf, s.len, rad, 0, ule);
-				}
-				for (j=from; j<to; j+=bsize) {
-					int len = ((j+bsize)>to)? (to-j): bsize;
-					r_io_pread (io, j, buf, len);
-					do_hash_internal (ctx, hashbit, buf,
-						len, rad, 0, ule);
-				}
-				if (s.buf && !s.prefix) {
-					do_hash_internal (ctx, hashbit, s.buf,
-						s.len, rad, 0, ule);
+		for (k=0; k<n; k++) {
+			r_hash_do_begin (jobs[k].ctx, jobs[k].bit);
+			if (s.buf && s.prefix) {
+				do_hash_internal (jobs[k].ctx,
+					jobs[k].bit, s.buf, s.len, rad, 0, ule);
+			}
+		}
+		for (j=from; j<to; j+=bsize) {
+			int len = ((j+bsize)>to)? (to-j): bsize;
+			r_io_pread (io, j, buf, len);
+			hash_jobs (jobs, n, buf, len);
+		}
+		for (k=0; k<n; k++) {
+			RHash *ctx = jobs[k].ctx;
+			i = jobs[k].bit;
+			if (s.buf && !s.prefix) {
+				do_hash_internal (ctx, i, s.buf,
+					s.len, rad, 0, ule);
+			}
+			r_hash_do_end (ctx, i);
+			if (iterations>0)
+				r_hash_do_spice (ctx, i, iterations, _s);
+			if (!*r_hash_name (i))
+				continue;
+			if (rad == 'j') {
+				if (first) {
+					first = 0;
+				} else {
+					printf (",");
 				}
-				r_hash_do_end (ctx, i);
-				if (iterations>0)
-					r_hash_do_spice (ctx, i, iterations, _s);
-				if (!*r_hash_name (i))
-					continue;
-				if (!quiet && rad != 'j')
-					printf ("%s: ", file);
-				do_hash_print (ctx, i, dlen, rad, ule);
 			}
+			if (!quiet && rad != 'j')
+				printf ("%s: ", file);
+			do_hash_print (ctx, i, r_hash_size (i), rad, ule);
 		}
 		if (_s)
 			free (_s->buf);
 	} else {
-		/* iterate over all algorithm bits */
+		ut64 ofrom = from, oto = to;
 		if (s.buf)
 			eprintf ("Warning: Seed ignored on per-block hashing.\n");
-		for (i=1; i<0x800000; i<<=1) {
-			ut64 f, t, ofrom, oto;
-			if (algobit & i) {
-				int hashbit = i & algobit;
-				ofrom = from;
-				oto = to;
-				f = from;
-				t = to;
-				for (j=f; j<t; j+=bsize) {
-					int nsize = (j+bsize<fsize)? bsize: (fsize-j);
-					r_io_pread (io, j, buf, bsize);
-					from = j;
-					to = j+bsize;
-					if (to>fsize)
-						to = fsize;
-					do_hash_internal (ctx, hashbit, buf, nsize, rad, 1, ule);
-				}
-				from = ofrom;
-				to = oto;
+		/* one pass for each algorithm to keep their results together,
+		 * the result of each block is printed once it is hashed */
+		for (k=0; k<n; k++) {
+			for (j=ofrom; j<oto; j+=bsize) {
+				int nsize = (j+bsize<fsize)? bsize: (fsize-j);
+				r_io_pread (io, j, buf, bsize);
+				from = j;
+				to = j+bsize;
+				if (to>fsize)
+					to = fsize;
+				if (nsize<1)
+					continue;
+				hash_jobs (&jobs[k], 1, buf, nsize);
+				hash_job_print (&jobs[k], rad, ule);
 			}
 		}
+		from = ofrom;
+		to = oto;
 	}
 	if (rad == 'j')
 		printf ("]\n");
-	r_hash_free (ctx);
+	hash_jobs_free (jobs, n);
 	free (buf);
 	return 0;
 }
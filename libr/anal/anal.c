@@ -102,9 +102,7 @@ R_API RAnal *r_anal_new() {
 	anal->reg = r_reg_new ();
 	anal->lineswidth = 0;
 	anal->fcns = r_anal_fcn_list_new ();
-#if USE_NEW_FCN_STORE
-	anal->fcnstore = r_listrange_new ();
-#endif
+	anal->fcn_tree = r_itree_new (NULL);
 	anal->refs = r_anal_ref_list_new ();
 	anal->types = r_anal_type_list_new ();
 	r_anal_set_bits (anal, 32);
@@ -131,11 +129,13 @@ R_API RAnal *r_anal_free(RAnal *a) {
 	/* TODO: Free anals here */
 	R_FREE (a->cpu);
 	r_list_free (a->plugins);
+	r_itree_free (a->fcn_tree);
 	a->fcns->free = r_anal_fcn_free;
 	r_list_free (a->fcns);
 	r_space_fini (&a->meta_spaces);
 	r_anal_pin_fini (a);
 	r_list_free (a->refs);
+	r_anal_xrefs_fini (a);
 	r_list_free (a->types);
 	r_reg_free (a->reg);
 	r_anal_op_free (a->queued);
@@ -334,14 +334,11 @@ R_API int r_anal_purge (RAnal *anal) {
 	sdb_reset (anal->sdb_fcns);
 	sdb_reset (anal->sdb_meta);
 	sdb_reset (anal->sdb_hints);
-	sdb_reset (anal->sdb_xrefs);
+	r_anal_xrefs_init (anal);
 	sdb_reset (anal->sdb_types);
+	r_anal_fcn_tree_purge (anal);
 	r_list_free (anal->fcns);
 	anal->fcns = r_anal_fcn_list_new ();
-#if USE_NEW_FCN_STORE
-	r_listrange_free (anal->fcnstore);
-	anal->fcnstore = r_listrange_new ();
-#endif
 	r_list_free (anal->refs);
 	anal->refs = r_anal_ref_list_new ();
 	r_list_free (anal->types);
@@ -141,59 +141,256 @@ R_API int r_anal_diff_bb(RAnal *anal, RAnalFunction *fcn, RAnalFunction *fcn2) {
 	return true;
 }
 
-R_API int r_anal_diff_fcn(RAnal *anal, RList *fcns, RList *fcns2) {
-	RAnalFunction *fcn, *fcn2, *mfcn, *mfcn2;
-	RListIter *iter, *iter2;
-	ut64 maxsize, minsize;
-	double t, ot;
+/* functions are matched by name with a hash table of the names in fcns2,
+ * and by code with an index of fcns2 sorted by size: the candidates
+ * within the diff_thfcn size ratio of a function are a contiguous range.
+ * Byte histograms of the fingerprints bound the edit distance from below,
+ * so most of the pairs that can not beat the best match are skipped
+ * before computing the distance. The result is the same as comparing
+ * every pair in list order */
+#define DIFF_THREADS 4
+#define DIFF_THREAD_MIN 0x1000000 // bytes^2 of work to use threads
 
-	if (!anal)
-		return false;
+typedef struct {
+	RAnalFunction *fcn;
+	int idx; // position in fcns2, ties go to the first one
+	ut32 hist[256];
+} DiffCand;
 
-	if (anal->cur && anal->cur->diff_fcn)
-		return (anal->cur->diff_fcn (anal, fcns, fcns2));
+typedef struct {
+	RAnal *anal;
+	RAnalFunction *fcn;
+	const ut32 *hist;
+	DiffCand **cands;
+	int n;
+	/* best match */
+	RAnalFunction *match;
+	double t;
+} DiffJob;
 
-	/* Compare functions with the same name */
-	if (fcns)
+static void diff_hist(ut32 *hist, const ut8 *buf, ut64 len) {
+	ut64 i;
+	memset (hist, 0, 256 * sizeof (ut32));
+	for (i = 0; i < len; i++)
+		hist[buf[i]]++;
+}
+
+/* highest similarity the fingerprints can have: every edit removes at
+ * most one byte in excess from each side of the histograms */
+static double diff_hist_similarity(const ut32 *ha, const ut32 *hb, ut32 la, ut32 lb) {
+	ut64 p = 0, n = 0;
+	int i;
+	for (i = 0; i < 256; i++) {
+		if (ha[i] > hb[i]) p += ha[i] - hb[i];
+		else n += hb[i] - ha[i];
+	}
+	return (double)1 - (double)R_MAX (p, n) / (double)R_MAX (la, lb);
+}
+
+static void diff_job(DiffJob *job) {
+	RAnalFunction *fcn = job->fcn, *fcn2;
+	double t, th, ot = 0;
+	int i;
+	job->match = NULL;
+	for (i = 0; i < job->n; i++) {
+		fcn2 = job->cands[i]->fcn;
+		th = R_MAX (job->anal->diff_thfcn, ot);
+		if (diff_hist_similarity (job->hist, job->cands[i]->hist,
+				fcn->size, fcn2->size) <= th)
+			continue;
+		/* give up as soon as it can not beat the best match */
+		if (!r_diff_buffers_distance_limit (NULL, fcn->fingerprint, fcn->size,
+				fcn2->fingerprint, fcn2->size, NULL, &t, th))
+			continue;
+#if 0
+		eprintf ("FCN: %s - %s => %lli - %lli => %f\n", fcn->name, fcn2->name,
+				fcn->size, fcn2->size, t);
+#endif
+		ot = t;
+		job->match = fcn2;
+		if (t == 1) break;
+	}
+	job->t = ot;
+}
+
+static int diff_job_th(RThread *th) {
+	diff_job (th->user);
+	return false;
+}
+
+/* best candidate, the first one in list order if several score the same */
+static RAnalFunction *diff_best(RAnal *anal, RAnalFunction *fcn, const ut32 *hist,
+		DiffCand **cands, int n, double *ot) {
+	DiffJob jobs[DIFF_THREADS];
+	RThread *th[DIFF_THREADS];
+	RAnalFunction *match = NULL;
+	ut64 work = 0;
+	int i, njobs = 1, nth = 0;
+	for (i = 0; i < n; i++)
+		work += cands[i]->fcn->size;
+	if (n >= DIFF_THREADS * 2 && work * fcn->size >= DIFF_THREAD_MIN)
+		njobs = DIFF_THREADS;
+	for (i = 0; i < njobs; i++) {
+		jobs[i].anal = anal;
+		jobs[i].fcn = fcn;
+		jobs[i].hist = hist;
+		jobs[i].cands = cands + (n * i / njobs);
+		jobs[i].n = (n * (i + 1) / njobs) - (n * i / njobs);
+	}
+	for (i = 1; i < njobs; i++) {
+		th[nth] = r_th_new (diff_job_th, &jobs[i], 0);
+		if (th[nth]) nth++;
+		else diff_job (&jobs[i]);
+	}
+	diff_job (&jobs[0]);
+	for (i = 0; i < nth; i++) {
+		r_th_wait (th[i]);
+		r_th_free (th[i]);
+	}
+	*ot = 0;
+	for (i = 0; i < njobs; i++) {
+		if (jobs[i].match && jobs[i].t > *ot) {
+			*ot = jobs[i].t;
+			match = jobs[i].match;
+		}
+	}
+	return match;
+}
+
+static int diff_cand_size_cmp(const void *a, const void *b) {
+	const DiffCand *ca = *(DiffCand**)a, *cb = *(DiffCand**)b;
+	if (ca->fcn->size != cb->fcn->size)
+		return (ca->fcn->size < cb->fcn->size)? -1: 1;
+	return ca->idx - cb->idx;
+}
+
+static int diff_cand_idx_cmp(const void *a, const void *b) {
+	return (*(DiffCand**)a)->idx - (*(DiffCand**)b)->idx;
+}
+
+static void diff_set_match(RAnal *anal, RAnalFunction *fcn, RAnalFunction *fcn2, double t) {
+	/* Set flag in matched functions */
+	fcn->diff->type = fcn2->diff->type = (t==1)?
+		R_ANAL_DIFF_TYPE_MATCH: R_ANAL_DIFF_TYPE_UNMATCH;
+	fcn->diff->dist = fcn2->diff->dist = t;
+	R_FREE (fcn->fingerprint);
+	R_FREE (fcn2->fingerprint);
+	fcn->diff->addr = fcn2->addr;
+	fcn2->diff->addr = fcn->addr;
+	R_FREE (fcn->diff->name);
+	if (fcn2->name)
+		fcn->diff->name = strdup (fcn2->name);
+	R_FREE (fcn2->diff->name);
+	if (fcn->name)
+		fcn2->diff->name = strdup (fcn->name);
+	r_anal_diff_bb (anal, fcn, fcn2);
+}
+
+static void diff_fcn_names(RAnal *anal, RList *fcns, RList *fcns2) {
+	RHashTable64 *ht = r_hashtable64_new ();
+	RList *buckets = r_list_newf ((RListFree)r_list_free);
+	RAnalFunction *fcn, *fcn2;
+	RListIter *iter, *iter2;
+	RList *bucket;
+	double t;
+	if (!ht || !buckets)
+		goto beach;
+	/* functions of fcns2 by name hash, in list order */
+	r_list_foreach (fcns2, iter, fcn2) {
+		ut64 hash;
+		if (fcn2->type != R_ANAL_FCN_TYPE_SYM || fcn2->name == NULL)
+			continue;
+		hash = r_str_hash64 (fcn2->name);
+		bucket = r_hashtable64_lookup (ht, hash);
+		if (!bucket) {
+			bucket = r_list_new ();
+			if (!bucket) continue;
+			r_list_append (buckets, bucket);
+			r_hashtable64_insert (ht, hash, bucket);
+		}
+		r_list_append (bucket, fcn2);
+	}
 	r_list_foreach (fcns, iter, fcn) {
 		if (fcn->type != R_ANAL_FCN_TYPE_SYM || fcn->name == NULL)
 			continue;
-		r_list_foreach (fcns2, iter2, fcn2) {
-			if (fcn2->type != R_ANAL_FCN_TYPE_SYM || fcn2->name == NULL ||
-				strcmp (fcn->name, fcn2->name))
+		bucket = r_hashtable64_lookup (ht, r_str_hash64 (fcn->name));
+		if (!bucket)
+			continue;
+		r_list_foreach (bucket, iter2, fcn2) {
+			if (strcmp (fcn->name, fcn2->name))
 				continue;
+			t = 0;
 			r_diff_buffers_distance (NULL, fcn->fingerprint, fcn->size,
 					fcn2->fingerprint, fcn2->size, NULL, &t);
 #if 0
 			eprintf ("FCN NAME (NAME): %s - %s => %lli - %lli => %f\n", fcn->name, fcn2->name,
 					fcn->size, fcn2->size, t);
 #endif
-			/* Set flag in matched functions */
-			fcn->diff->type = fcn2->diff->type = (t==1)?
-				R_ANAL_DIFF_TYPE_MATCH: R_ANAL_DIFF_TYPE_UNMATCH;
-			fcn->diff->dist = fcn2->diff->dist = t;
-			R_FREE (fcn->fingerprint);
-			R_FREE (fcn2->fingerprint);
-			fcn->diff->addr = fcn2->addr;
-			fcn2->diff->addr = fcn->addr;
-			R_FREE (fcn->diff->name);
-			if (fcn2->name)
-				fcn->diff->name = strdup (fcn2->name);
-			R_FREE (fcn2->diff->name);
-			if (fcn->name)
-				fcn2->diff->name = strdup (fcn->name);
-			r_anal_diff_bb (anal, fcn, fcn2);
+			diff_set_match (anal, fcn, fcn2, t);
 			break;
 		}
 	}
+beach:
+	r_hashtable64_free (ht);
+	r_list_free (buckets);
+}
+
+R_API int r_anal_diff_fcn(RAnal *anal, RList *fcns, RList *fcns2) {
+	RAnalFunction *fcn, *fcn2, *mfcn2;
+	RListIter *iter;
+	DiffCand *cands = NULL, **bysize = NULL, **found = NULL;
+	ut32 hist[256];
+	ut64 maxsize, minsize, lo, hi;
+	double ot, th;
+	int i, n = 0, nfound, a, b;
+
+	if (!anal)
+		return false;
+
+	if (anal->cur && anal->cur->diff_fcn)
+		return (anal->cur->diff_fcn (anal, fcns, fcns2));
+
+	/* Compare functions with the same name */
+	if (fcns)
+		diff_fcn_names (anal, fcns, fcns2);
+
 	/* Compare remaining functions */
+	i = 0;
+	cands = calloc (r_list_length (fcns2) + 1, sizeof (DiffCand));
+	bysize = calloc (r_list_length (fcns2) + 1, sizeof (DiffCand*));
+	found = calloc (r_list_length (fcns2) + 1, sizeof (DiffCand*));
+	if (!cands || !bysize || !found)
+		goto beach;
+	r_list_foreach (fcns2, iter, fcn2) {
+		i++;
+		if ((fcn2->type != R_ANAL_FCN_TYPE_FCN && fcn2->type != R_ANAL_FCN_TYPE_SYM) ||
+			fcn2->diff->type != R_ANAL_DIFF_TYPE_NULL ||
+			!fcn2->fingerprint || fcn2->size < 1)
+			continue;
+		cands[n].fcn = fcn2;
+		cands[n].idx = i;
+		diff_hist (cands[n].hist, fcn2->fingerprint, fcn2->size);
+		bysize[n] = &cands[n];
+		n++;
+	}
+	qsort (bysize, n, sizeof (DiffCand*), diff_cand_size_cmp);
+	th = anal->diff_thfcn;
 	r_list_foreach (fcns, iter, fcn) {
 		if ((fcn->type != R_ANAL_FCN_TYPE_FCN && fcn->type != R_ANAL_FCN_TYPE_SYM) ||
-			fcn->diff->type != R_ANAL_DIFF_TYPE_NULL)
+			fcn->diff->type != R_ANAL_DIFF_TYPE_NULL ||
+			!fcn->fingerprint || fcn->size < 1)
 			continue;
-		ot = 0;
-		mfcn = mfcn2 = NULL;
-		r_list_foreach (fcns2, iter2, fcn2) {
+		/* sizes in the ratio, refined below with the exact check */
+		lo = (th > 0)? (ut64)(fcn->size * th): 0;
+		hi = (th > 0)? (ut64)(fcn->size / th) + 1: UT64_MAX;
+		for (a = 0, b = n; a < b; ) {
+			int m = (a + b) / 2;
+			if (bysize[m]->fcn->size < lo) a = m + 1;
+			else b = m;
+		}
+		nfound = 0;
+		for (; a < n && bysize[a]->fcn->size <= hi; a++) {
+			fcn2 = bysize[a]->fcn;
 			if (fcn->size > fcn2->size) {
 				maxsize = fcn->size;
 				minsize = fcn2->size;
@@ -201,53 +398,27 @@ R_API int r_anal_diff_fcn(RAnal *anal, RList *fcns, RList *fcns2) {
 				maxsize = fcn2->size;
 				minsize = fcn->size;
 			}
-			if ((fcn2->type != R_ANAL_FCN_TYPE_FCN && fcn2->type != R_ANAL_FCN_TYPE_SYM) ||
-				fcn2->diff->type != R_ANAL_DIFF_TYPE_NULL || (maxsize * anal->diff_thfcn > minsize))
+			if (fcn2->diff->type != R_ANAL_DIFF_TYPE_NULL ||
+				(maxsize * anal->diff_thfcn > minsize))
 				continue;
-			r_diff_buffers_distance (NULL, fcn->fingerprint, fcn->size,
-					fcn2->fingerprint, fcn2->size, NULL, &t);
-			fcn->diff->dist = fcn2->diff->dist = t;
-#if 0
-			int i;
-			eprintf ("FP0 ");
-			for (i=0;i<fcn->size;i++)
-				eprintf ("%02x", fcn->fingerprint[i]);
-			eprintf ("\n");
-
-			eprintf ("FP1 ");
-			for (i=0;i<fcn2->size;i++)
-				eprintf ("%02x", fcn2->fingerprint[i]);
-			eprintf ("\n");
-			eprintf ("FCN: %s - %s => %lli - %lli => %f\n", fcn->name, fcn2->name,
-					fcn->size, fcn2->size, t);
-#endif
-			if (t > anal->diff_thfcn && t > ot) {
-				ot = t;
-				mfcn = fcn;
-				mfcn2 = fcn2;
-				if (t == 1) break;
-			}
+			found[nfound++] = bysize[a];
 		}
-		if (mfcn && mfcn2) {
+		if (!nfound)
+			continue;
+		qsort (found, nfound, sizeof (DiffCand*), diff_cand_idx_cmp);
+		diff_hist (hist, fcn->fingerprint, fcn->size);
+		mfcn2 = diff_best (anal, fcn, hist, found, nfound, &ot);
+		if (mfcn2) {
 #if 0
-			eprintf ("Match => %s - %s\n", mfcn->name, mfcn2->name);
+			eprintf ("Match => %s - %s\n", fcn->name, mfcn2->name);
 #endif
-			/* Set flag in matched functions */
-			mfcn->diff->type = mfcn2->diff->type = (ot==1)?
-				R_ANAL_DIFF_TYPE_MATCH: R_ANAL_DIFF_TYPE_UNMATCH;
-			R_FREE (mfcn->fingerprint);
-			R_FREE (mfcn2->fingerprint);
-			mfcn->diff->addr = mfcn2->addr;
-			mfcn2->diff->addr = mfcn->addr;
-			R_FREE (mfcn->diff->name);
-			if (mfcn2->name)
-				mfcn->diff->name = strdup (mfcn2->name);
-			R_FREE (mfcn2->diff->name);
-			if (mfcn->name)
-				mfcn2->diff->name = strdup (mfcn->name);
-			r_anal_diff_bb (anal, mfcn, mfcn2);
+			diff_set_match (anal, fcn, mfcn2, ot);
 		}
 	}
+beach:
+	free (cands);
+	free (bysize);
+	free (found);
 	return true;
 }
 
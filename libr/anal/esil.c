@@ -35,17 +35,6 @@ static bool isregornum(RAnalEsil *esil, const char *str, ut64 *num) {
 	return true;
 }
 
-/* pop Register or Number */
-static bool popRN(RAnalEsil *esil, ut64 *n) {
-	char *str = r_anal_esil_pop (esil);
-	if (str) {
-		bool ret = isregornum (esil, str, n);
-		free (str);
-		return ret;
-	}
-	return false;
-}
-
 /* R_ANAL_ESIL API */
 
 R_API RAnalEsil *r_anal_esil_new(iotrap) {
@@ -69,6 +58,8 @@ R_API int r_anal_esil_set_op (RAnalEsil *esil, const char *op, RAnalEsilOp code)
 		eprintf ("can't set esil-op %s\n", op);
 		return false;
 	}
+	// compiled expressions may refer to the old op
+	r_anal_esil_cache_flush (esil);
 	return true;
 }
 
@@ -156,6 +147,8 @@ R_API void r_anal_esil_free (RAnalEsil *esil) {
 	sdb_free (esil->stats);
 	esil->stats = NULL;
 	r_anal_esil_stack_free (esil);
+	r_anal_esil_cache_flush (esil);
+	R_FREE (esil->cache);
 	if (esil->anal && esil->anal->cur && esil->anal->cur->esil_fini)
 		esil->anal->cur->esil_fini (esil);
 	free (esil);
@@ -286,15 +279,54 @@ static bool esil_internal_overflow_check (RAnalEsil *esil) {
 		^ esil_internal_carry_check (esil, esil->lastsz-2));
 }
 
+/* the stack holds strings, or words whose string is only made when
+ * someone pops it as such: compiled immediates and registers, and the
+ * numbers pushed by the ops (stack_num, one per stack slot) */
+
+static bool esil_push_word(RAnalEsil *esil, RAnalEsilWord *w) {
+	if (esil->stackptr>30)
+		return false;
+	esil->stack[esil->stackptr] = NULL;
+	esil->stack_word[esil->stackptr++] = w;
+	return true;
+}
+
+static char *esil_stack_str(RAnalEsil *esil, int i) {
+	RAnalEsilWord *w = esil->stack_word[i];
+	if (w) {
+		char str[64];
+		if (!w->str)
+			snprintf (str, sizeof (str), "0x%"PFMT64x, w->num);
+		esil->stack[i] = strdup (w->str? w->str: str);
+		esil->stack_word[i] = NULL;
+	}
+	return esil->stack[i];
+}
+
+/* compiled words must not outlive the code they belong to */
+static void esil_stack_own(RAnalEsil *esil) {
+	int i;
+	for (i=0; i<esil->stackptr; i++) {
+		if (esil->stack_word[i] && esil->stack_word[i]->str)
+			esil_stack_str (esil, i);
+	}
+}
+
 R_API int r_anal_esil_pushnum(RAnalEsil *esil, ut64 num) {
-	char str[64];
-	snprintf (str, sizeof (str)-1, "0x%"PFMT64x, num);
-	return r_anal_esil_push (esil, str);
+	RAnalEsilWord *w;
+	if (!esil || esil->stackptr>30)
+		return false;
+	w = &esil->stack_num[esil->stackptr];
+	w->type = R_ANAL_ESIL_WORD_NUM;
+	w->str = NULL;
+	w->num = num;
+	return esil_push_word (esil, w);
 }
 
 R_API bool r_anal_esil_push(RAnalEsil *esil, const char *str) {
 	if (!str || !esil || !*str || esil->stackptr>30)
 		return false;
+	esil->stack_word[esil->stackptr] = NULL;
 	esil->stack[esil->stackptr++] = strdup (str);
 	return true;
 }
@@ -302,7 +334,7 @@ R_API bool r_anal_esil_push(RAnalEsil *esil, const char *str) {
 R_API char *r_anal_esil_pop(RAnalEsil *esil) {
 	if (!esil || esil->stackptr<1)
 		return NULL;
-	return esil->stack[--esil->stackptr];
+	return esil_stack_str (esil, --esil->stackptr);
 }
 
 R_API int r_anal_esil_get_parm_type (RAnalEsil *esil, const char *str) {
@@ -430,65 +462,182 @@ R_API int r_anal_esil_reg_read (RAnalEsil *esil, const char *regname, ut64 *num,
 	return ret;
 }
 
+/* operand popped by the ops below, read from the word when it was
+ * compiled or pushed as a number, else from its string */
+typedef struct {
+	bool valid;
+	int type; // R_ANAL_ESIL_WORD_PUSH for strings
+	ut64 num;
+	RRegItem *reg;
+	const char *name; // NULL until esil_arg_name() for numbers
+	char *str;
+	char buf[32];
+} EsilArg;
+
+static EsilArg esil_arg_pop(RAnalEsil *esil) {
+	EsilArg a = {0};
+	RAnalEsilWord *w;
+	int i;
+	if (!esil || esil->stackptr<1)
+		return a;
+	i = --esil->stackptr;
+	w = esil->stack_word[i];
+	if (w) {
+		esil->stack_word[i] = NULL;
+		a.type = w->type;
+		a.num = w->num;
+		a.reg = w->reg;
+		a.name = w->str;
+	} else {
+		a.type = R_ANAL_ESIL_WORD_PUSH;
+		a.str = esil->stack[i];
+		a.name = a.str;
+	}
+	esil->stack[i] = NULL;
+	a.valid = true;
+	return a;
+}
+
+static const char *esil_arg_name(EsilArg *a) {
+	if (!a->name && a->valid) {
+		snprintf (a->buf, sizeof (a->buf), "0x%"PFMT64x, a->num);
+		a->name = a->buf;
+	}
+	return a->name;
+}
+
+static void esil_arg_free(EsilArg *a) {
+	free (a->str);
+}
+
+/* registers can be accessed by item when nobody hooks them */
+static bool esil_reg_direct(RAnalEsil *esil) {
+	return !esil->cb.hook_reg_read && esil->cb.reg_read == internal_esil_reg_read;
+}
+
+/* r_anal_esil_get_parm() */
+static bool esil_arg_get(RAnalEsil *esil, EsilArg *a, ut64 *num) {
+	if (a->type == R_ANAL_ESIL_WORD_NUM) {
+		*num = a->num;
+		return true;
+	}
+	if (a->type == R_ANAL_ESIL_WORD_REG && esil_reg_direct (esil)) {
+		*num = r_reg_get_value (esil->anal->reg, a->reg);
+		return true;
+	}
+	return a->valid && r_anal_esil_get_parm (esil, esil_arg_name (a), num);
+}
+
+/* isregornum() */
+static bool esil_arg_rn(RAnalEsil *esil, EsilArg *a, ut64 *num) {
+	if (a->type != R_ANAL_ESIL_WORD_PUSH && esil_reg_direct (esil))
+		return esil_arg_get (esil, a, num);
+	return a->valid && isregornum (esil, esil_arg_name (a), num);
+}
+
+/* r_anal_esil_reg_read() */
+static bool esil_arg_reg(RAnalEsil *esil, EsilArg *a, ut64 *num) {
+	if (a->type == R_ANAL_ESIL_WORD_REG && esil_reg_direct (esil)) {
+		*num = r_reg_get_value (esil->anal->reg, a->reg);
+		return true;
+	}
+	return r_anal_esil_reg_read (esil, esil_arg_name (a), num, NULL);
+}
+
+/* r_anal_esil_reg_write() */
+static int esil_arg_write(RAnalEsil *esil, EsilArg *a, ut64 num) {
+	if (a->type == R_ANAL_ESIL_WORD_REG && !esil->debug && !esil->cb.hook_reg_write
+			&& esil->cb.reg_write == internal_esil_reg_write) {
+		r_reg_set_value (esil->anal->reg, a->reg, num);
+		return true;
+	}
+	return r_anal_esil_reg_write (esil, esil_arg_name (a), num);
+}
+
+static bool esil_arg_internal(RAnalEsil *esil, EsilArg *a) {
+	return a->type == R_ANAL_ESIL_WORD_PUSH &&
+		r_anal_esil_get_parm_type (esil, a->name) == R_ANAL_ESIL_PARM_INTERNAL;
+}
+
+static bool esil_arg_isreg(RAnalEsil *esil, EsilArg *a) {
+	if (a->type != R_ANAL_ESIL_WORD_PUSH)
+		return a->type == R_ANAL_ESIL_WORD_REG;
+	return r_anal_esil_get_parm_type (esil, a->name) == R_ANAL_ESIL_PARM_REG;
+}
+
+static ut8 esil_arg_size(RAnalEsil *esil, EsilArg *a) {
+	if (a->type == R_ANAL_ESIL_WORD_REG)
+		return a->reg->size;
+	return esil_internal_sizeof_reg (esil, esil_arg_name (a));
+}
+
+/* pop Register or Number */
+static bool popRN(RAnalEsil *esil, ut64 *n) {
+	EsilArg a = esil_arg_pop (esil);
+	bool ret = a.valid && esil_arg_rn (esil, &a, n);
+	esil_arg_free (&a);
+	return ret;
+}
+
 static int esil_eq (RAnalEsil *esil) {
 	int ret = 0;
 	ut64 num, num2;
-	char *dst = r_anal_esil_pop (esil);
-	char *src = r_anal_esil_pop (esil);
-	if (src && dst && r_anal_esil_reg_read (esil, dst, &num, NULL)) {
-		if (r_anal_esil_get_parm (esil, src, &num2)) {
-			if (r_anal_esil_get_parm_type (esil, src) != R_ANAL_ESIL_PARM_INTERNAL) {	//necessary for some flag-things
+	EsilArg dst = esil_arg_pop (esil);
+	EsilArg src = esil_arg_pop (esil);
+	if (src.valid && dst.valid && esil_arg_reg (esil, &dst, &num)) {
+		if (esil_arg_get (esil, &src, &num2)) {
+			if (!esil_arg_internal (esil, &src)) {	//necessary for some flag-things
 				esil->cur = num2;
 				esil->old = num;
-				esil->lastsz = esil_internal_sizeof_reg (esil, dst);
+				esil->lastsz = esil_arg_size (esil, &dst);
 			}
-			ret = r_anal_esil_reg_write (esil, dst, num2);
+			ret = esil_arg_write (esil, &dst, num2);
 		} else {
 			IFDBG eprintf ("esil_eq: invalid src\n");
 		}
 	} else {
 		IFDBG eprintf ("esil_eq: invalid parameters\n");
 	}
-	free (src);
-	free (dst);
+	esil_arg_free (&src);
+	esil_arg_free (&dst);
 	return ret;
 }
 
 static int esil_neg(RAnalEsil *esil) {
 	int ret = 0;
 	ut64 num;
-	char *src = r_anal_esil_pop (esil);
-	if (src) {
-		if (r_anal_esil_get_parm (esil, src, &num)) {
+	EsilArg src = esil_arg_pop (esil);
+	if (src.valid) {
+		if (esil_arg_get (esil, &src, &num)) {
 			r_anal_esil_pushnum (esil, !!!num);
 			ret = 1;
 		} else {
-			if (isregornum (esil, src, &num)) {
+			if (esil_arg_rn (esil, &src, &num)) {
 				ret = 1;
 				r_anal_esil_pushnum (esil, !!!num);
 			} else {
-				eprintf ("esil_neg: unknown reg %s\n", src);
+				eprintf ("esil_neg: unknown reg %s\n", esil_arg_name (&src));
 			}
 		}
 	} else {
 		eprintf ("esil_neg: empty stack\n");
 	}
-	free (src);
+	esil_arg_free (&src);
 	return ret;
 }
 
 static int esil_negeq(RAnalEsil *esil) {
 	int ret = 0;
 	ut64 num;
-	char *src = r_anal_esil_pop (esil);
-	if (src && r_anal_esil_reg_read (esil, src, &num, NULL)) {
+	EsilArg src = esil_arg_pop (esil);
+	if (src.valid && esil_arg_reg (esil, &src, &num)) {
 		num = !num;
-		r_anal_esil_reg_write (esil, src, num);
+		esil_arg_write (esil, &src, num);
 		ret = 1;
 	} else {
 		eprintf ("esil_negeq: empty stack\n");
 	}
-	free (src);
+	esil_arg_free (&src);
 	//r_anal_esil_pushnum (esil, ret);
 	return ret;
 }
@@ -500,69 +649,69 @@ static int esil_nop(RAnalEsil *esil) {
 static int esil_andeq(RAnalEsil *esil) {
 	int ret = 0;
 	ut64 num, num2;
-	char *dst = r_anal_esil_pop (esil);
-	char *src = r_anal_esil_pop (esil);
-	if (dst && r_anal_esil_reg_read (esil, dst, &num, NULL)) {
-		if (src && r_anal_esil_get_parm (esil, src, &num2)) {
-			if (r_anal_esil_get_parm_type (esil, src) != R_ANAL_ESIL_PARM_INTERNAL) {
+	EsilArg dst = esil_arg_pop (esil);
+	EsilArg src = esil_arg_pop (esil);
+	if (dst.valid && esil_arg_reg (esil, &dst, &num)) {
+		if (src.valid && esil_arg_get (esil, &src, &num2)) {
+			if (!esil_arg_internal (esil, &src)) {
 				esil->old = num;
 				esil->cur = num & num2;
-				esil->lastsz = esil_internal_sizeof_reg (esil, dst);
+				esil->lastsz = esil_arg_size (esil, &dst);
 			}
-			r_anal_esil_reg_write (esil, dst, num & num2);
+			esil_arg_write (esil, &dst, num & num2);
 			ret = 1;
 		} else {
 			eprintf ("esil_andeq: empty stack\n");
 		}
 	}
-	free (src);
-	free (dst);
+	esil_arg_free (&src);
+	esil_arg_free (&dst);
 	return ret;
 }
 
 static int esil_oreq(RAnalEsil *esil) {
 	int ret = 0;
 	ut64 num, num2;
-	char *dst = r_anal_esil_pop (esil);
-	char *src = r_anal_esil_pop (esil);
-	if (dst && r_anal_esil_reg_read (esil, dst, &num, NULL)) {
-		if (src && r_anal_esil_get_parm (esil, src, &num2)) {
-			if (r_anal_esil_get_parm_type (esil, src) != R_ANAL_ESIL_PARM_INTERNAL) {
+	EsilArg dst = esil_arg_pop (esil);
+	EsilArg src = esil_arg_pop (esil);
+	if (dst.valid && esil_arg_reg (esil, &dst, &num)) {
+		if (src.valid && esil_arg_get (esil, &src, &num2)) {
+			if (!esil_arg_internal (esil, &src)) {
 				esil->old = num;
 				esil->cur = num | num2;
-				esil->lastsz = esil_internal_sizeof_reg (esil, dst);
+				esil->lastsz = esil_arg_size (esil, &dst);
 			}
-			r_anal_esil_reg_write (esil, dst, num | num2);
+			esil_arg_write (esil, &dst, num | num2);
 			ret = 1;
 		} else {
 			eprintf ("esil_ordeq: empty stack\n");
 		}
 	}
-	free (src);
-	free (dst);
+	esil_arg_free (&src);
+	esil_arg_free (&dst);
 	return ret;
 }
 
 static int esil_xoreq(RAnalEsil *esil) {
 	int ret = 0;
 	ut64 num, num2;
-	char *dst = r_anal_esil_pop (esil);
-	char *src = r_anal_esil_pop (esil);
-	if (dst && r_anal_esil_reg_read (esil, dst, &num, NULL)) {
-		if (src && r_anal_esil_get_parm (esil, src, &num2)) {
-			if (r_anal_esil_get_parm_type (esil, src) != R_ANAL_ESIL_PARM_INTERNAL) {
+	EsilArg dst = esil_arg_pop (esil);
+	EsilArg src = esil_arg_pop (esil);
+	if (dst.valid && esil_arg_reg (esil, &dst, &num)) {
+		if (src.valid && esil_arg_get (esil, &src, &num2)) {
+			if (!esil_arg_internal (esil, &src)) {
 				esil->old = num;
 				esil->cur = num ^ num2;
-				esil->lastsz = esil_internal_sizeof_reg (esil, dst);
+				esil->lastsz = esil_arg_size (esil, &dst);
 			}
-			r_anal_esil_reg_write (esil, dst, num ^ num2);
+			esil_arg_write (esil, &dst, num ^ num2);
 			ret = 1;
 		} else {
 			eprintf ("esil_xoreq: empty stack\n");
 		}
 	}
-	free (src);
-	free (dst);
+	esil_arg_free (&src);
+	esil_arg_free (&dst);
 	return ret;
 }
 
@@ -644,22 +793,22 @@ static int esil_interrupt(RAnalEsil *esil) {
 static int esil_cmp(RAnalEsil *esil) {
 	ut64 num, num2;
 	int ret = 0;
-	char *dst = r_anal_esil_pop (esil);
-	char *src = r_anal_esil_pop (esil);
-	if (dst && r_anal_esil_get_parm (esil, dst, &num)) {
-		if (src && r_anal_esil_get_parm (esil, src, &num2)) {
+	EsilArg dst = esil_arg_pop (esil);
+	EsilArg src = esil_arg_pop (esil);
+	if (dst.valid && esil_arg_get (esil, &dst, &num)) {
+		if (src.valid && esil_arg_get (esil, &src, &num2)) {
 			esil->old = num;
 			esil->cur = num - num2;
 			ret = 1;
-			if (r_reg_get (esil->anal->reg, dst, -1)) {
-				esil->lastsz = esil_internal_sizeof_reg (esil, dst);
-			} else if (r_reg_get (esil->anal->reg, src, -1)) {
-				esil->lastsz = esil_internal_sizeof_reg (esil, src);
+			if (esil_arg_isreg (esil, &dst)) {
+				esil->lastsz = esil_arg_size (esil, &dst);
+			} else if (esil_arg_isreg (esil, &src)) {
+				esil->lastsz = esil_arg_size (esil, &src);
 			}
 		}
 	}
-	free (dst);
-	free (src);
+	esil_arg_free (&dst);
+	esil_arg_free (&src);
 	//r_anal_esil_pushnum (esil, ret);
 	return ret;
 }
@@ -725,10 +874,10 @@ static int esil_ifset(RAnalEsil *esil) {
 
 static int esil_if(RAnalEsil *esil) {
 	ut64 num;
-	char *src = r_anal_esil_pop (esil);
-	if (src) {
+	EsilArg src = esil_arg_pop (esil);
+	if (src.valid) {
 		// TODO: check return value
-		(void)r_anal_esil_get_parm (esil, src, &num);
+		(void)esil_arg_get (esil, &src, &num);
 			// condition not matching, skipping until }
 		if (!num)
 			esil->skip = true;
@@ -740,10 +889,10 @@ static int esil_if(RAnalEsil *esil) {
 static int esil_lsl(RAnalEsil *esil) {
 	int ret = 0;
 	ut64 num, num2;
-	char *dst = r_anal_esil_pop (esil);
-	char *src = r_anal_esil_pop (esil);
-	if (dst && r_anal_esil_get_parm (esil, dst, &num)) {
-		if (src && r_anal_esil_get_parm (esil, src, &num2)) {
+	EsilArg dst = esil_arg_pop (esil);
+	EsilArg src = esil_arg_pop (esil);
+	if (dst.valid && esil_arg_get (esil, &dst, &num)) {
+		if (src.valid && esil_arg_get (esil, &src, &num2)) {
 			ut64 res = num << num2;
 			r_anal_esil_pushnum (esil, res);
 			ret = 1;
@@ -751,40 +900,40 @@ static int esil_lsl(RAnalEsil *esil) {
 			eprintf ("esil_lsl: empty stack\n");
 		}
 	}
-	free (src);
-	free (dst);
+	esil_arg_free (&src);
+	esil_arg_free (&dst);
 	return ret;
 }
 
 static int esil_lsleq(RAnalEsil *esil) {
 	int ret = 0;
 	ut64 num, num2;
-	char *dst = r_anal_esil_pop (esil);
-	char *src = r_anal_esil_pop (esil);
-	if (dst && r_anal_esil_reg_read (esil, dst, &num, NULL)) {
-		if (src && r_anal_esil_get_parm (esil, src, &num2)) {
+	EsilArg dst = esil_arg_pop (esil);
+	EsilArg src = esil_arg_pop (esil);
+	if (dst.valid && esil_arg_reg (esil, &dst, &num)) {
+		if (src.valid && esil_arg_get (esil, &src, &num2)) {
 			esil->old = num;
 			num <<= num2;
 			esil->cur = num;
-			esil->lastsz = esil_internal_sizeof_reg (esil, dst);
-			r_anal_esil_reg_write (esil, dst, num);
+			esil->lastsz = esil_arg_size (esil, &dst);
+			esil_arg_write (esil, &dst, num);
 			ret = 1;
 		} else {
 			eprintf ("esil_lsleq: empty stack\n");
 		}
 	}
-	free (src);
-	free (dst);
+	esil_arg_free (&src);
+	esil_arg_free (&dst);
 	return ret;
 }
 
 static int esil_lsr(RAnalEsil *esil) {
 	int ret = 0;
 	ut64 num, num2;
-	char *dst = r_anal_esil_pop (esil);
-	char *src = r_anal_esil_pop (esil);
-	if (dst && r_anal_esil_get_parm (esil, dst, &num)) {
-		if (src && r_anal_esil_get_parm (esil, src, &num2)) {
+	EsilArg dst = esil_arg_pop (esil);
+	EsilArg src = esil_arg_pop (esil);
+	if (dst.valid && esil_arg_get (esil, &dst, &num)) {
+		if (src.valid && esil_arg_get (esil, &src, &num2)) {
 			ut64 res = num >> num2;
 			r_anal_esil_pushnum (esil, res);
 			ret = 1;
@@ -792,30 +941,30 @@ static int esil_lsr(RAnalEsil *esil) {
 			eprintf ("esil_lsr: empty stack\n");
 		}
 	}
-	free (src);
-	free (dst);
+	esil_arg_free (&src);
+	esil_arg_free (&dst);
 	return ret;
 }
 
 static int esil_lsreq(RAnalEsil *esil) {
 	int ret = 0;
 	ut64 num, num2;
-	char *dst = r_anal_esil_pop (esil);
-	char *src = r_anal_esil_pop (esil);
-	if (dst && r_anal_esil_reg_read (esil, dst, &num, NULL)) {
-		if (src && r_anal_esil_get_parm (esil, src, &num2)) {
+	EsilArg dst = esil_arg_pop (esil);
+	EsilArg src = esil_arg_pop (esil);
+	if (dst.valid && esil_arg_reg (esil, &dst, &num)) {
+		if (src.valid && esil_arg_get (esil, &src, &num2)) {
 			esil->old = num;
 			num >>= num2;
 			esil->cur = num;
-			esil->lastsz = esil_internal_sizeof_reg (esil, dst);
-			r_anal_esil_reg_write (esil, dst, num);
+			esil->lastsz = esil_arg_size (esil, &dst);
+			esil_arg_write (esil, &dst, num);
 			ret = 1;
 		} else {
 			eprintf ("esil_lsreq: empty stack\n");
 		}
 	}
-	free (src);
-	free (dst);
+	esil_arg_free (&src);
+	esil_arg_free (&dst);
 	return ret;
 }
 
@@ -864,10 +1013,10 @@ static int esil_rol(RAnalEsil *esil) {
 static int esil_and(RAnalEsil *esil) {
 	int ret = 0;
 	ut64 num, num2;
-	char *dst = r_anal_esil_pop (esil);
-	char *src = r_anal_esil_pop (esil);
-	if (dst && r_anal_esil_get_parm (esil, dst, &num)) {
-		if (src && r_anal_esil_get_parm (esil, src, &num2)) {
+	EsilArg dst = esil_arg_pop (esil);
+	EsilArg src = esil_arg_pop (esil);
+	if (dst.valid && esil_arg_get (esil, &dst, &num)) {
+		if (src.valid && esil_arg_get (esil, &src, &num2)) {
 			num &= num2;
 			r_anal_esil_pushnum (esil, num);
 			ret = 1;
@@ -875,18 +1024,18 @@ static int esil_and(RAnalEsil *esil) {
 			eprintf ("esil_and: empty stack\n");
 		}
 	}
-	free (src);
-	free (dst);
+	esil_arg_free (&src);
+	esil_arg_free (&dst);
 	return ret;
 }
 
 static int esil_xor(RAnalEsil *esil) {
 	int ret = 0;
 	ut64 num, num2;
-	char *dst = r_anal_esil_pop (esil);
-	char *src = r_anal_esil_pop (esil);
-	if (dst && r_anal_esil_get_parm (esil, dst, &num)) {
-		if (src && r_anal_esil_get_parm (esil, src, &num2)) {
+	EsilArg dst = esil_arg_pop (esil);
+	EsilArg src = esil_arg_pop (esil);
+	if (dst.valid && esil_arg_get (esil, &dst, &num)) {
+		if (src.valid && esil_arg_get (esil, &src, &num2)) {
 			num ^= num2;
 			r_anal_esil_pushnum (esil, num);
 			ret = 1;
@@ -894,18 +1043,18 @@ static int esil_xor(RAnalEsil *esil) {
 			eprintf ("esil_xor: empty stack\n");
 		}
 	}
-	free (src);
-	free (dst);
+	esil_arg_free (&src);
+	esil_arg_free (&dst);
 	return ret;
 }
 
 static int esil_or(RAnalEsil *esil) {
 	int ret = 0;
 	ut64 num, num2;
-	char *dst = r_anal_esil_pop (esil);
-	char *src = r_anal_esil_pop (esil);
-	if (dst && r_anal_esil_get_parm (esil, dst, &num)) {
-		if (src && r_anal_esil_get_parm (esil, src, &num2)) {
+	EsilArg dst = esil_arg_pop (esil);
+	EsilArg src = esil_arg_pop (esil);
+	if (dst.valid && esil_arg_get (esil, &dst, &num)) {
+		if (src.valid && esil_arg_get (esil, &src, &num2)) {
 			num |= num2;
 			r_anal_esil_pushnum (esil, num);
 			ret = 1;
@@ -913,8 +1062,8 @@ static int esil_or(RAnalEsil *esil) {
 			eprintf ("esil_xor: empty stack\n");
 		}
 	}
-	free (src);
-	free (dst);
+	esil_arg_free (&src);
+	esil_arg_free (&dst);
 	return ret;
 }
 
@@ -930,7 +1079,7 @@ R_API int r_anal_esil_dumpstack (RAnalEsil *esil) {
 		return 0;
 	//eprintf ("StackDump:\n");
 	for (i=esil->stackptr-1; i>=0; i--) {
-		esil->anal->cb_printf ("%s\n", esil->stack[i]);
+		esil->anal->cb_printf ("%s\n", esil_stack_str (esil, i));
 	}
 	return 1;
 }
@@ -954,11 +1103,11 @@ static int esil_todo(RAnalEsil *esil) {
 
 static int esil_goto(RAnalEsil *esil) {
 	ut64 num = 0;
-	char *src = r_anal_esil_pop (esil);
-	if (src && *src && r_anal_esil_get_parm (esil, src, &num)) {
+	EsilArg src = esil_arg_pop (esil);
+	if (src.valid && esil_arg_get (esil, &src, &num)) {
 		esil->parse_goto = num;
 	}
-	free (src);
+	esil_arg_free (&src);
 	return 1;
 }
 
@@ -971,10 +1120,10 @@ static int esil_pop(RAnalEsil *esil) {
 static int esil_mod(RAnalEsil *esil) {
 	int ret = 0;
 	ut64 s, d;
-	char *dst = r_anal_esil_pop (esil);
-	char *src = r_anal_esil_pop (esil);
-	if (src && r_anal_esil_get_parm (esil, src, &s)) {
-		if (dst && r_anal_esil_get_parm (esil, dst, &d)) {
+	EsilArg dst = esil_arg_pop (esil);
+	EsilArg src = esil_arg_pop (esil);
+	if (src.valid && esil_arg_get (esil, &src, &s)) {
+		if (dst.valid && esil_arg_get (esil, &dst, &d)) {
 			if (s == 0) {
 				eprintf ("esil_mod: Division by zero!\n");
 				esil->trap = R_ANAL_TRAP_DIVBYZERO;
@@ -987,25 +1136,25 @@ static int esil_mod(RAnalEsil *esil) {
 	} else {
 		eprintf ("esil_mod: invalid parameters");
 	}
-	free (dst);
-	free (src);
+	esil_arg_free (&dst);
+	esil_arg_free (&src);
 	return ret;
 }
 
 static int esil_modeq(RAnalEsil *esil) {
 	int ret = 0;
 	ut64 s, d;
-	char *dst = r_anal_esil_pop (esil);
-	char *src = r_anal_esil_pop (esil);
-	if (src && r_anal_esil_get_parm (esil, src, &s)) {
-		if (dst && r_anal_esil_reg_read (esil, dst, &d, NULL)) {
+	EsilArg dst = esil_arg_pop (esil);
+	EsilArg src = esil_arg_pop (esil);
+	if (src.valid && esil_arg_get (esil, &src, &s)) {
+		if (dst.valid && esil_arg_reg (esil, &dst, &d)) {
 			if (s) {
-				if (r_anal_esil_get_parm_type (esil, src) != R_ANAL_ESIL_PARM_INTERNAL) {
+				if (!esil_arg_internal (esil, &src)) {
 					esil->old = d;
 					esil->cur = d%s;
-					esil->lastsz = esil_internal_sizeof_reg (esil, dst);
+					esil->lastsz = esil_arg_size (esil, &dst);
 				}
-				r_anal_esil_reg_write (esil, dst, d%s);
+				esil_arg_write (esil, &dst, d%s);
 			} else {
 				eprintf ("esil_modeq: Division by zero!\n");
 				esil->trap = R_ANAL_TRAP_DIVBYZERO;
@@ -1018,18 +1167,18 @@ static int esil_modeq(RAnalEsil *esil) {
 	} else {
 		eprintf ("esil_modeq: invalid parameters");
 	}
-	free (src);
-	free (dst);
+	esil_arg_free (&src);
+	esil_arg_free (&dst);
 	return ret;
 }
 
 static int esil_div(RAnalEsil *esil) {
 	int ret = 0;
 	ut64 s, d;
-	char *dst = r_anal_esil_pop (esil);
-	char *src = r_anal_esil_pop (esil);
-	if (src && r_anal_esil_get_parm (esil, src, &s)) {
-		if (dst && r_anal_esil_get_parm (esil, dst, &d)) {
+	EsilArg dst = esil_arg_pop (esil);
+	EsilArg src = esil_arg_pop (esil);
+	if (src.valid && esil_arg_get (esil, &src, &s)) {
+		if (dst.valid && esil_arg_get (esil, &dst, &d)) {
 			if (s == 0) {
 				eprintf ("esil_div: Division by zero!\n");
 				esil->trap = R_ANAL_TRAP_DIVBYZERO;
@@ -1042,25 +1191,25 @@ static int esil_div(RAnalEsil *esil) {
 	} else {
 		eprintf ("esil_div: invalid parameters");
 	}
-	free (src);
-	free (dst);
+	esil_arg_free (&src);
+	esil_arg_free (&dst);
 	return ret;
 }
 
 static int esil_diveq (RAnalEsil *esil) {
 	int ret = 0;
 	ut64 s, d;
-	char *dst = r_anal_esil_pop (esil);
-	char *src = r_anal_esil_pop (esil);
-	if (src && r_anal_esil_get_parm (esil, src, &s)) {
-		if (dst && r_anal_esil_reg_read (esil, dst, &d, NULL)) {
+	EsilArg dst = esil_arg_pop (esil);
+	EsilArg src = esil_arg_pop (esil);
+	if (src.valid && esil_arg_get (esil, &src, &s)) {
+		if (dst.valid && esil_arg_reg (esil, &dst, &d)) {
 			if (s) {
-				if (r_anal_esil_get_parm_type (esil, src) != R_ANAL_ESIL_PARM_INTERNAL) {
+				if (!esil_arg_internal (esil, &src)) {
 					esil->old = d;
 					esil->cur = d/s;
-					esil->lastsz = esil_internal_sizeof_reg (esil, dst);
+					esil->lastsz = esil_arg_size (esil, &dst);
 				}
-				r_anal_esil_reg_write (esil, dst, d/s);
+				esil_arg_write (esil, &dst, d/s);
 			} else {
 				eprintf ("esil_diveq: Division by zero!\n");
 				esil->trap = R_ANAL_TRAP_DIVBYZERO;
@@ -1073,18 +1222,18 @@ static int esil_diveq (RAnalEsil *esil) {
 	} else {
 		eprintf ("esil_diveq: invalid parameters");
 	}
-	free (src);
-	free (dst);
+	esil_arg_free (&src);
+	esil_arg_free (&dst);
 	return ret;
 }
 
 static int esil_mul(RAnalEsil *esil) {
 	int ret = 0;
 	ut64 s, d;
-	char *dst = r_anal_esil_pop (esil);
-	char *src = r_anal_esil_pop (esil);
-	if (src && r_anal_esil_get_parm (esil, src, &s)) {
-		if (dst && r_anal_esil_get_parm (esil, dst, &d)) {
+	EsilArg dst = esil_arg_pop (esil);
+	EsilArg src = esil_arg_pop (esil);
+	if (src.valid && esil_arg_get (esil, &src, &s)) {
+		if (dst.valid && esil_arg_get (esil, &dst, &d)) {
 			r_anal_esil_pushnum (esil, d*s);
 			ret = 1;
 		} else {
@@ -1093,24 +1242,24 @@ static int esil_mul(RAnalEsil *esil) {
 	} else {
 		eprintf ("esil_mul: invalid parameters");
 	}
-	free (src);
-	free (dst);
+	esil_arg_free (&src);
+	esil_arg_free (&dst);
 	return ret;
 }
 
 static int esil_muleq (RAnalEsil *esil) {
 	int ret = 0;
 	ut64 s, d;
-	char *dst = r_anal_esil_pop (esil);
-	char *src = r_anal_esil_pop (esil);
-	if (src && r_anal_esil_get_parm (esil, src, &s)) {
-		if (dst && r_anal_esil_reg_read (esil, dst, &d, NULL)) {
-			if (r_anal_esil_get_parm_type (esil, src) != R_ANAL_ESIL_PARM_INTERNAL) {
+	EsilArg dst = esil_arg_pop (esil);
+	EsilArg src = esil_arg_pop (esil);
+	if (src.valid && esil_arg_get (esil, &src, &s)) {
+		if (dst.valid && esil_arg_reg (esil, &dst, &d)) {
+			if (!esil_arg_internal (esil, &src)) {
 				esil->old = d;
 				esil->cur = d*s;
-				esil->lastsz = esil_internal_sizeof_reg (esil, dst);
+				esil->lastsz = esil_arg_size (esil, &dst);
 			}
-			r_anal_esil_reg_write (esil, dst, s*d);
+			esil_arg_write (esil, &dst, s*d);
 			ret = true;
 		} else {
 			eprintf ("esil_muleq: empty stack\n");
@@ -1118,82 +1267,82 @@ static int esil_muleq (RAnalEsil *esil) {
 	} else {
 		eprintf ("esil_muleq: invalid parameters\n");
 	}
-	free (dst);
-	free (src);
+	esil_arg_free (&dst);
+	esil_arg_free (&src);
 	return ret;
 }
 
 static int esil_add (RAnalEsil *esil) {
 	int ret = 0;
 	ut64 s, d;
-	char *dst = r_anal_esil_pop (esil);
-	char *src = r_anal_esil_pop (esil);
-	if (src && r_anal_esil_get_parm (esil, src, &s)) {
-		if (dst && r_anal_esil_get_parm (esil, dst, &d)) {
+	EsilArg dst = esil_arg_pop (esil);
+	EsilArg src = esil_arg_pop (esil);
+	if (src.valid && esil_arg_get (esil, &src, &s)) {
+		if (dst.valid && esil_arg_get (esil, &dst, &d)) {
 			r_anal_esil_pushnum (esil, s+d);
 			ret = true;
 		}
 	} else {
 		eprintf ("esil_add: invalid parameters\n");
 	}
-	free (src);
-	free (dst);
+	esil_arg_free (&src);
+	esil_arg_free (&dst);
 	return ret;
 }
 
 static int esil_addeq (RAnalEsil *esil) {
 	int ret = 0;
 	ut64 s, d;
-	char *dst = r_anal_esil_pop (esil);
-	char *src = r_anal_esil_pop (esil);
-	if (src && r_anal_esil_get_parm (esil, src, &s)) {
-		if (dst && r_anal_esil_reg_read (esil, dst, &d, NULL)) {
-			if (r_anal_esil_get_parm_type (esil, src) != R_ANAL_ESIL_PARM_INTERNAL) {
+	EsilArg dst = esil_arg_pop (esil);
+	EsilArg src = esil_arg_pop (esil);
+	if (src.valid && esil_arg_get (esil, &src, &s)) {
+		if (dst.valid && esil_arg_reg (esil, &dst, &d)) {
+			if (!esil_arg_internal (esil, &src)) {
 				esil->old = d;
 				esil->cur = d+s;
-				esil->lastsz = esil_internal_sizeof_reg (esil, dst);
+				esil->lastsz = esil_arg_size (esil, &dst);
 			}
-			r_anal_esil_reg_write (esil, dst, s+d);
+			esil_arg_write (esil, &dst, s+d);
 			ret = true;
 		}
 	} else {
 		eprintf ("esil_addeq: invalid parameters\n");
 	}
-	free (src);
-	free (dst);
+	esil_arg_free (&src);
+	esil_arg_free (&dst);
 	return ret;
 }
 
 static int esil_inc (RAnalEsil *esil) {
 	int ret = 0;
 	ut64 s;
-	char *src = r_anal_esil_pop (esil);
-	if (src && r_anal_esil_get_parm (esil, src, &s)) {
+	EsilArg src = esil_arg_pop (esil);
+	if (src.valid && esil_arg_get (esil, &src, &s)) {
 		s++;
 		r_anal_esil_pushnum (esil, s);
 		ret = true;
 	} else {
 		eprintf ("esil_inc: invalid parameters\n");
 	}
-	free (src);
+	esil_arg_free (&src);
 	return ret;
 }
 
 static int esil_inceq (RAnalEsil *esil) {
 	int ret = 0;
 	ut64 sd;
-	char *src_dst = r_anal_esil_pop (esil);
-	if (src_dst && (r_anal_esil_get_parm_type (esil, src_dst) == R_ANAL_ESIL_PARM_REG) && r_anal_esil_get_parm (esil, src_dst, &sd)) {
+	EsilArg src_dst = esil_arg_pop (esil);
+	if (src_dst.valid && esil_arg_isreg (esil, &src_dst) && esil_arg_get (esil, &src_dst, &sd)) {
 		esil->old = sd;
 		sd++;
 		esil->cur = sd;
-		r_anal_esil_reg_write (esil, src_dst, sd);
-		esil->lastsz = esil_internal_sizeof_reg (esil, src_dst);
+		esil_arg_write (esil, &src_dst, sd);
+		esil->lastsz = esil_arg_size (esil, &src_dst);
 		ret = true;
 	} else {
 		eprintf ("esil_inceq: invalid parameters\n");
 	}
-	free (src_dst);
+	esil_arg_free (&src_dst);
 	return ret;
 }
 
@@ -1233,56 +1382,56 @@ static int esil_sub (RAnalEsil *esil) {
 static int esil_subeq (RAnalEsil *esil) {
 	int ret = 0;
 	ut64 s, d;
-	char *dst = r_anal_esil_pop (esil);
-	char *src = r_anal_esil_pop (esil);
-	if (src && r_anal_esil_get_parm (esil, src, &s)) {
-		if (dst && r_anal_esil_reg_read (esil, dst, &d, NULL)) {
-			if (r_anal_esil_get_parm_type (esil, src) != R_ANAL_ESIL_PARM_INTERNAL) {
+	EsilArg dst = esil_arg_pop (esil);
+	EsilArg src = esil_arg_pop (esil);
+	if (src.valid && esil_arg_get (esil, &src, &s)) {
+		if (dst.valid && esil_arg_reg (esil, &dst, &d)) {
+			if (!esil_arg_internal (esil, &src)) {
 				esil->old = d;
 				esil->cur = d-s;
-				esil->lastsz = esil_internal_sizeof_reg (esil, dst);
+				esil->lastsz = esil_arg_size (esil, &dst);
 			}
-			r_anal_esil_reg_write (esil, dst, d-s);
+			esil_arg_write (esil, &dst, d-s);
 			ret = true;
 		}
 	} else {
 		eprintf ("esil_subeq: invalid parameters\n");
 	}
-	free (src);
-	free (dst);
+	esil_arg_free (&src);
+	esil_arg_free (&dst);
 	return ret;
 }
 
 static int esil_dec (RAnalEsil *esil) {
 	int ret = 0;
 	ut64 s;
-	char *src = r_anal_esil_pop (esil);
-	if (src && r_anal_esil_get_parm (esil, src, &s)) {
+	EsilArg src = esil_arg_pop (esil);
+	if (src.valid && esil_arg_get (esil, &src, &s)) {
 		s--;
 		r_anal_esil_pushnum (esil, s);
 		ret = true;
 	} else {
 		eprintf ("esil_dec: invalid parameters\n");
 	}
-	free (src);
+	esil_arg_free (&src);
 	return ret;
 }
 
 static int esil_deceq (RAnalEsil *esil) {
 	int ret = 0;
 	ut64 sd;
-	char *src_dst = r_anal_esil_pop (esil);
-	if (src_dst && (r_anal_esil_get_parm_type (esil, src_dst) == R_ANAL_ESIL_PARM_REG) && r_anal_esil_get_parm (esil, src_dst, &sd)) {
+	EsilArg src_dst = esil_arg_pop (esil);
+	if (src_dst.valid && esil_arg_isreg (esil, &src_dst) && esil_arg_get (esil, &src_dst, &sd)) {
 		esil->old = sd;
 		sd--;
 		esil->cur = sd;
-		r_anal_esil_reg_write (esil, src_dst, sd);
-		esil->lastsz = esil_internal_sizeof_reg (esil, src_dst);
+		esil_arg_write (esil, &src_dst, sd);
+		esil->lastsz = esil_arg_size (esil, &src_dst);
 		ret = true;
 	} else {
 		eprintf ("esil_deceq: invalid parameters\n");
 	}
-	free (src_dst);
+	esil_arg_free (&src_dst);
 	return ret;
 }
 
@@ -1296,19 +1445,18 @@ static int esil_poke_n(RAnalEsil *esil, int bits) {
 		ut32 dword;
 		ut64 qword;
 	} n, n2;
-	char *dst = r_anal_esil_pop (esil);
-	char *src = r_anal_esil_pop (esil);
+	EsilArg dst = esil_arg_pop (esil);
+	EsilArg src = esil_arg_pop (esil);
 	int bytes = bits / 8, ret = 0;
 	if (bits % 8) {
-		free (src);
-		free (dst);
+		esil_arg_free (&src);
+		esil_arg_free (&dst);
 		return 0;
 	}
 	//eprintf ("GONA POKE %d src:%s dst:%s\n", bits, src, dst);
-	if (src && r_anal_esil_get_parm (esil, src, &num)) {
-		if (dst && r_anal_esil_get_parm (esil, dst, &addr)) {
-			int type = r_anal_esil_get_parm_type (esil, src);
-			if (type != R_ANAL_ESIL_PARM_INTERNAL) {
+	if (src.valid && esil_arg_get (esil, &src, &num)) {
+		if (dst.valid && esil_arg_get (esil, &dst, &addr)) {
+			if (!esil_arg_internal (esil, &src)) {
 				n.qword = n2.qword = 0;
 				r_anal_esil_mem_read (esil, addr, (ut8 *)&n, bytes);
 				r_mem_copyendian ((ut8 *)&n2, (ut8 *)&n, bytes, !esil->anal->big_endian);
@@ -1373,12 +1521,12 @@ static int esil_peek_n(RAnalEsil *esil, int bits) {
 	char res[32];
 	ut64 addr;
 	int ret = 0, bytes = bits / 8;
-	char *dst = r_anal_esil_pop (esil);
+	EsilArg dst = esil_arg_pop (esil);
 	if (bits & 7) {
-		free (dst);
+		esil_arg_free (&dst);
 		return 0;
 	}
-	if (dst && isregornum (esil, dst, &addr)) {
+	if (dst.valid && esil_arg_rn (esil, &dst, &addr)) {
 		ut64 a, b, bitmask = genmask (bits-1);
 		ret = r_anal_esil_mem_read (esil, addr, (ut8*)&a, bytes);
 		r_mem_copyendian ((ut8 *)&b, (const ut8*)&a, bytes ,!esil->anal->big_endian);
@@ -1386,7 +1534,7 @@ static int esil_peek_n(RAnalEsil *esil, int bits) {
 		r_anal_esil_push (esil, res);
 		esil->lastsz = bits;
 	}
-	free (dst);
+	esil_arg_free (&dst);
 	return ret;
 }
 
@@ -1989,7 +2137,7 @@ static int evalWord (RAnalEsil *esil, const char *ostr, const char **str) {
 	return 3;
 }
 
-R_API int r_anal_esil_parse(RAnalEsil *esil, const char *str) {
+static int esil_parse_str(RAnalEsil *esil, const char *str) {
 	int wordi = 0;
 	int dorunword;
 	char word[64];
@@ -2056,11 +2204,262 @@ repeat:
 	return 1;
 }
 
+/* compiled expressions
+ *
+ * The words of the expression are split once and the operators are
+ * looked up in esil->ops at compile time, so running it again does not
+ * need to copy and hash every word. Immediates are parsed and registers
+ * resolved to their items too, and pushed as such, so the ops read them
+ * without going through their string (see EsilArg). Expressions the
+ * string parser handles in a special way (';', empty words) are not
+ * compiled and keep using it. */
+
+R_API void r_anal_esil_code_free(RAnalEsilCode *code) {
+	if (!code) return;
+	free (code->expr);
+	free (code->buf);
+	free (code->words);
+	free (code);
+}
+
+/* numbers r_anal_esil_get_parm() and isregornum() agree on */
+static bool isimm(const char *str) {
+	if (*str < '0' || *str > '9')
+		return false;
+	if (str[0] == '0' && str[1] == 'x')
+		return true;
+	for (str++; *str; str++) {
+		if (*str < '0' || *str > '9')
+			return false;
+	}
+	return true;
+}
+
+/* the register items of the code are still those of the profile */
+static bool esil_code_regs(RAnalEsil *esil, RAnalEsilCode *code) {
+	RReg *reg = esil->anal? esil->anal->reg: NULL;
+	return reg && code->reg == reg && code->reg_gen == reg->gen;
+}
+
+R_API RAnalEsilCode *r_anal_esil_compile(RAnalEsil *esil, const char *str) {
+	RAnalEsilCode *code;
+	RAnalEsilWord *w;
+	RAnalEsilOp op;
+	RRegItem *ri;
+	RReg *reg;
+	char *p, *next;
+	int n, len;
+	if (!esil || !str || !*str || *str == ',' || strchr (str, ';') || strstr (str, ",,"))
+		return NULL;
+	code = R_NEW0 (RAnalEsilCode);
+	if (!code) return NULL;
+	code->addr = esil->address;
+	reg = esil->anal? esil->anal->reg: NULL;
+	code->reg = reg;
+	code->reg_gen = reg? reg->gen: 0;
+	code->expr = strdup (str);
+	code->buf = strdup (str);
+	len = strlen (str);
+	code->trailing = (str[len - 1] == ',');
+	for (n = 1, p = code->buf; *p; p++) {
+		if (*p == ',') n++;
+	}
+	code->words = calloc (n, sizeof (RAnalEsilWord));
+	if (!code->expr || !code->buf || !code->words) {
+		r_anal_esil_code_free (code);
+		return NULL;
+	}
+	for (p = code->buf; p && *p; p = next) {
+		next = strchr (p, ',');
+		if (next) *next++ = 0;
+		if (strlen (p) > 62) {
+			// too long for the string parser, let it fail
+			r_anal_esil_code_free (code);
+			return NULL;
+		}
+		w = &code->words[code->length++];
+		w->str = p;
+		w->end = next? next - code->buf: len;
+		if (!strcmp (p, "}{")) {
+			w->type = R_ANAL_ESIL_WORD_ELSE;
+		} else if (!strcmp (p, "}")) {
+			w->type = R_ANAL_ESIL_WORD_ENDIF;
+		} else if (iscommand (esil, p, &op) && op) {
+			w->type = R_ANAL_ESIL_WORD_OP;
+			w->op = op;
+		} else if (isimm (p)) {
+			w->type = R_ANAL_ESIL_WORD_NUM;
+			w->num = r_num_get (NULL, p);
+		} else if (reg && (ri = r_reg_get (reg, p, -1))) {
+			w->type = R_ANAL_ESIL_WORD_REG;
+			w->reg = ri;
+		} else {
+			w->type = R_ANAL_ESIL_WORD_PUSH;
+		}
+	}
+	return code;
+}
+
+/* same as runword() for a compiled word */
+static int runcode(RAnalEsil *esil, RAnalEsilWord *w, int regs) {
+	int ret;
+	esil->parse_goto_count--;
+	if (esil->parse_goto_count<1) {
+		eprintf ("ESIL infinite loop detected\n");
+		esil->trap = 1; // INTERNAL ERROR
+		esil->parse_stop = 1; // INTERNAL ERROR
+		return 0;
+	}
+	switch (w->type) {
+	case R_ANAL_ESIL_WORD_ELSE:
+		esil->skip = esil->skip? 0: 1;
+		return 1;
+	case R_ANAL_ESIL_WORD_ENDIF:
+		esil->skip = 0;
+		return 1;
+	}
+	if (esil->skip) {
+		return 1;
+	}
+	if (w->type == R_ANAL_ESIL_WORD_OP) {
+		if (esil->cb.hook_command) {
+			if (esil->cb.hook_command (esil, w->str))
+				return 1; // XXX cannot return != 1
+		}
+		return w->op (esil);
+	}
+	if (w->type == R_ANAL_ESIL_WORD_NUM || (w->type == R_ANAL_ESIL_WORD_REG && regs)) {
+		ret = esil_push_word (esil, w);
+	} else {
+		ret = r_anal_esil_push (esil, w->str);
+	}
+	if (!ret) {
+		eprintf ("ESIL stack is full\n");
+		esil->trap = 1;
+		esil->trap_code = 1;
+	}
+	return 1;
+}
+
+static int code_run(RAnalEsil *esil, RAnalEsilCode *code) {
+	int i, regs = esil_code_regs (esil, code);
+	esil->trap = 0;
+loop:
+	esil->repeat = 0;
+	esil->skip = 0;
+	esil->parse_goto = -1;
+	esil->parse_stop = 0;
+	if (esil->anal) {
+		esil->parse_goto_count = esil->anal->esil_goto_limit;
+	} else {
+		esil->parse_goto_count = R_ANAL_ESIL_GOTO_LIMIT;
+	}
+	for (i = 0; i < code->length; ) {
+		if (!runcode (esil, &code->words[i], regs)) {
+			return 0;
+		}
+		// same actions evalWord() takes after each word
+		if (esil->repeat) {
+			goto loop;
+		}
+		if (esil->parse_goto != -1) {
+			int n = esil->parse_goto;
+			if (n >= 0 && (n < code->length || (n == code->length && code->trailing))) {
+				esil->parse_goto = -1;
+				i = n;
+				continue;
+			}
+			eprintf ("Cannot find word %d\n", esil->parse_goto);
+			return 0;
+		}
+		if (esil->parse_stop) {
+			if (esil->parse_stop == 2) {
+				int end = code->words[i].end;
+				eprintf ("ESIL TODO: %s\n", (i + 1 < code->length)?
+					code->expr + end: "");
+			}
+			return 0;
+		}
+		i++;
+	}
+	return 1;
+}
+
+R_API int r_anal_esil_code_run(RAnalEsil *esil, RAnalEsilCode *code) {
+	int ret;
+	if (!esil || !code || !code->length)
+		return 0;
+	ret = code_run (esil, code);
+	esil_stack_own (esil);
+	return ret;
+}
+
+static void esil_cache_drop(RAnalEsilCode *code) {
+	if (!code) return;
+	code->cached = false;
+	if (!code->running) {
+		r_anal_esil_code_free (code);
+	}
+}
+
+R_API void r_anal_esil_cache_flush(RAnalEsil *esil) {
+	int i;
+	if (!esil || !esil->cache) return;
+	for (i = 0; i < R_ANAL_ESIL_CACHE_SIZE; i++) {
+		esil_cache_drop (esil->cache[i]);
+		esil->cache[i] = NULL;
+	}
+}
+
+static RAnalEsilCode *esil_cache_get(RAnalEsil *esil, const char *str) {
+	RAnalEsilCode **slot, *code;
+	ut64 addr = esil->address;
+	if (!esil->cache) {
+		esil->cache = calloc (R_ANAL_ESIL_CACHE_SIZE, sizeof (RAnalEsilCode*));
+		if (!esil->cache) return NULL;
+	}
+	slot = &esil->cache[(addr ^ (addr >> 10)) % R_ANAL_ESIL_CACHE_SIZE];
+	code = *slot;
+	if (code && code->addr == addr && !strcmp (code->expr, str) && esil_code_regs (esil, code)) {
+		return code;
+	}
+	code = r_anal_esil_compile (esil, str);
+	if (code) {
+		esil_cache_drop (*slot);
+		*slot = code;
+		code->cached = true;
+	}
+	return code;
+}
+
+R_API int r_anal_esil_parse(RAnalEsil *esil, const char *str) {
+	RAnalEsilCode *code;
+	int ret;
+	if (!esil || !str || !*str)
+		return 0;
+	// reil translation needs to see every word as a string
+	if (!esil->Reil) {
+		code = esil_cache_get (esil, str);
+		if (code) {
+			code->running++;
+			ret = r_anal_esil_code_run (esil, code);
+			code->running--;
+			if (!code->cached && !code->running) {
+				r_anal_esil_code_free (code);
+			}
+			return ret;
+		}
+	}
+	return esil_parse_str (esil, str);
+}
+
 R_API void  r_anal_esil_stack_free (RAnalEsil *esil) {
 	int i;
 	if (esil) {
-		for (i=0; i<esil->stackptr; i++)
+		for (i=0; i<esil->stackptr; i++) {
 			R_FREE (esil->stack[i]);
+			esil->stack_word[i] = NULL;
+		}
 		esil->stackptr = 0;
 	}
 }
@@ -33,14 +33,20 @@ R_API const char *r_anal_fcn_type_tostring(int type) {
 	return "unk";
 }
 
-R_API int r_anal_fcn_resize (RAnalFunction *fcn, int newsize) {
+R_API void r_anal_fcn_set_size (RAnal *anal, RAnalFunction *fcn, ut32 size) {
+	if (!fcn) return;
+	fcn->size = size;
+	r_anal_fcn_tree_update (anal, fcn);
+}
+
+R_API int r_anal_fcn_resize (RAnal *anal, RAnalFunction *fcn, int newsize) {
 	ut64 eof; /* end of function */
 	RAnalBlock *bb;
 	RListIter *iter, *iter2;
 	if (!fcn || newsize<1)
 		return false;
-	fcn->size = newsize;
-	eof = fcn->addr = fcn->size;
+	r_anal_fcn_set_size (anal, fcn, newsize);
+	eof = fcn->addr + fcn->size;
 	r_list_foreach_safe (fcn->bbs, iter, iter2, bb) {
 		if (bb->addr >= eof) {
 			// already called by r_list_delete r_anal_bb_free (bb);
@@ -609,7 +615,7 @@ static void fcnfit (RAnal *a, RAnalFunction *f) {
 	RAnalFunction *next = r_anal_fcn_next (a, f->addr);
 	if (next) {
 		if ((f->addr + f->size)> next->addr) {
-			r_anal_fcn_resize (f, (next->addr - f->addr));
+			r_anal_fcn_resize (a, f, (next->addr - f->addr));
 		}
 	}
 }
@@ -643,12 +649,9 @@ R_API int r_anal_fcn_insert(RAnal *anal, RAnalFunction *fcn) {
 	RAnalFunction *f = r_anal_get_fcn_in (anal, fcn->addr,
 		R_ANAL_FCN_TYPE_ROOT);
 	if (f) return false;
-#if USE_NEW_FCN_STORE
-	r_listrange_add (anal->fcnstore, fcn);
-	// HUH? store it here .. for backweird compatibility
-#endif
 	/* TODO: sdbization */
 	r_list_append (anal->fcns, fcn);
+	r_anal_fcn_tree_insert (anal, fcn);
 	if (anal->cb.on_fcn_new) {
 		anal->cb.on_fcn_new (anal, anal->user, fcn);
 	}
@@ -668,7 +671,7 @@ R_API int r_anal_fcn_add(RAnal *a, ut64 addr, ut64 size, const char *name, int t
 		append = 1;
 	}
 	fcn->addr = addr;
-	fcn->size = size;
+	r_anal_fcn_set_size (a, fcn, size);
 	free (fcn->name);
 	if (!name || !strncmp (name, "fcn.", 4)) {
 		fcn->name = r_str_newf ("fcn.%08"PFMT64x, fcn->addr);
@@ -693,15 +696,14 @@ R_API int r_anal_fcn_del_locs(RAnal *anal, ut64 addr) {
 	RListIter *iter, *iter2;
 	RAnalFunction *fcn, *f = r_anal_get_fcn_in (anal, addr,
 		R_ANAL_FCN_TYPE_ROOT);
-#if USE_NEW_FCN_STORE
-#warning TODO: r_anal_fcn_del_locs not implemented for newstore
-#endif
 	if (!f) return false;
 	r_list_foreach_safe (anal->fcns, iter, iter2, fcn) {
 		if (fcn->type != R_ANAL_FCN_TYPE_LOC)
 			continue;
-		if (fcn->addr >= f->addr && fcn->addr < (f->addr+f->size))
+		if (fcn->addr >= f->addr && fcn->addr < (f->addr+f->size)) {
+			r_anal_fcn_tree_delete (anal, fcn);
 			r_list_delete (anal->fcns, iter);
+		}
 	}
 	r_anal_fcn_del (anal, addr);
 	return true;
@@ -709,20 +711,11 @@ R_API int r_anal_fcn_del_locs(RAnal *anal, ut64 addr) {
 
 R_API int r_anal_fcn_del(RAnal *a, ut64 addr) {
 	if (addr == UT64_MAX) {
-#if USE_NEW_FCN_STORE
-		r_listrange_free (a->fcnstore);
-		a->fcnstore = r_listrange_new ();
-#else
+		r_anal_fcn_tree_purge (a);
 		r_list_free (a->fcns);
 		if (!(a->fcns = r_anal_fcn_list_new ()))
 			return false;
-#endif
 	} else {
-#if USE_NEW_FCN_STORE
-		// XXX: must only get the function if starting at 0?
-		RAnalFunction *f = r_listrange_find_in_range (a->fcnstore, addr);
-		if (f) r_listrange_del (a->fcnstore, f);
-#else
 		RAnalFunction *fcni;
 		RListIter *iter, *iter_tmp;
 		r_list_foreach_safe (a->fcns, iter, iter_tmp, fcni) {
@@ -730,38 +723,16 @@ R_API int r_anal_fcn_del(RAnal *a, ut64 addr) {
 				if (a->cb.on_fcn_delete) {
 					a->cb.on_fcn_delete (a, a->user, fcni);
 				}
+				r_anal_fcn_tree_delete (a, fcni);
 				r_list_delete (a->fcns, iter);
 			}
 		}
-#endif
 	}
 	return true;
 }
 
 R_API RAnalFunction *r_anal_get_fcn_in(RAnal *anal, ut64 addr, int type) {
-#if USE_NEW_FCN_STORE
-	// TODO: type is ignored here? wtf.. we need more work on fcnstore
-	//if (root) return r_listrange_find_root (anal->fcnstore, addr);
-	return r_listrange_find_in_range (anal->fcnstore, addr);
-#else
-	RAnalFunction *fcn, *ret = NULL;
-	RListIter *iter;
-	if (type == R_ANAL_FCN_TYPE_ROOT) {
-		r_list_foreach (anal->fcns, iter, fcn) {
-			if (addr == fcn->addr)
-				return fcn;
-		}
-		return NULL;
-	}
-	r_list_foreach (anal->fcns, iter, fcn) {
-		if (!type || (fcn->type & type)) {
-			if (addr == fcn->addr || (ret == NULL &&
-			   ((addr > fcn->addr) && (addr < fcn->addr+fcn->size))))
-				ret = fcn;
-		}
-	}
-	return ret;
-#endif
+	return r_anal_fcn_tree_in (anal, addr, type);
 }
 
 R_API RAnalFunction *r_anal_fcn_find_name(RAnal *anal, const char *name) {
@@ -953,41 +924,11 @@ R_API int r_anal_str_to_fcn(RAnal *a, RAnalFunction *f, const char *sig) {
 }
 
 R_API RAnalFunction *r_anal_get_fcn_at(RAnal *anal, ut64 addr, int type) {
-#if USE_NEW_FCN_STORE
-	// TODO: type is ignored here? wtf.. we need more work on fcnstore
-	//if (root) return r_listrange_find_root (anal->fcnstore, addr);
-	return r_listrange_find_root (anal->fcnstore, addr);
-#else
-	RAnalFunction *fcn, *ret = NULL;
-	RListIter *iter;
-	if (type == R_ANAL_FCN_TYPE_ROOT) {
-		r_list_foreach (anal->fcns, iter, fcn) {
-			if (addr == fcn->addr)
-				return fcn;
-		}
-		return NULL;
-	}
-	r_list_foreach (anal->fcns, iter, fcn) {
-		if (!type || (fcn->type & type)) {
-			if (addr == fcn->addr)
-				ret = fcn;
-		}
-	}
-	return ret;
-#endif
+	return r_anal_fcn_tree_at (anal, addr, type);
 }
 
 R_API RAnalFunction *r_anal_fcn_next(RAnal *anal, ut64 addr) {
-	RAnalFunction *fcni;
-	RListIter *iter;
-	RAnalFunction *closer = NULL;
-	r_list_foreach (anal->fcns, iter, fcni) {
-		//if (fcni->addr == addr)
-		if (fcni->addr > addr && (!closer || fcni->addr<closer->addr)) {
-			closer = fcni;
-		}
-	}
-	return closer;
+	return r_anal_fcn_tree_next (anal, addr);
 }
 
 /* getters */
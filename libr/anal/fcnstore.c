@@ -1,117 +1,106 @@
-/* radare - LGPL - Copyright 2011 -- pancake<nopcode.org> */
-/* this file contains a test implementation of the ~O(1) function search */
+/* radare - LGPL - Copyright 2011-2015 -- pancake<nopcode.org> */
 
-// TODO: REFACTOR: This must be a generic data structure named RListRange
-// TODO: We need a standard struct named Surface1D {.addr, .size}, so we can
-// simplify all this by just passing the offset of the field of the given ptr
-// TODO: RListComparator does not supports *user
-// TODO: RRef - reference counting
+/* interval index of the functions stored in anal->fcns, so the
+ * r_anal_get_fcn_* lookups do not need to walk the whole list.
+ * Every change of fcn->addr or fcn->size done after r_anal_fcn_insert
+ * must be notified with r_anal_fcn_tree_delete/insert or done through
+ * r_anal_fcn_set_size and r_anal_fcn_resize */
 
-#define RANGEBITS 10
-// 1024
-#define RANGE (1<<RANGEBITS)
 #include <r_anal.h>
-#if USE_NEW_FCN_STORE
 
-static int cmpfun(void *a, void *b) {
-	RAnalFunction *fa = (RAnalFunction*)a;
-	RAnalFunction *fb = (RAnalFunction*)b;
-	// TODO: swap sort order here or wtf?
-	return (fb->addr - fa->addr);
+static ut64 fcn_end(RAnalFunction *fcn) {
+	// empty functions still own their entrypoint
+	return fcn->addr + (fcn->size? fcn->size: 1);
 }
 
-R_API RListRange* r_listrange_new () {
-	RListRange *s = R_NEW (RListRange);
-	s->h = r_hashtable64_new ();
-	s->l = r_list_new ();
-	return s;
+R_API void r_anal_fcn_tree_insert(RAnal *anal, RAnalFunction *fcn) {
+	if (!anal || !fcn) return;
+	r_itree_insert (anal->fcn_tree, fcn->addr, fcn_end (fcn), fcn);
 }
 
-// FIXME: Do not hardcode such things/values!!!
-static inline ut64 r_listrange_key(ut64 addr) {
-	const ut64 KXOR = 0x18abc3e127d549ac; // XXX wrong for mingw32
-	ut64 key = addr & 0xfffffffffffff400;
-	key ^= KXOR;
-	//eprintf ("%llx = %llx\n", addr, key);
-	return key;
-	//return (addr >> RANGEBITS);
+R_API void r_anal_fcn_tree_delete(RAnal *anal, RAnalFunction *fcn) {
+	if (!anal || !fcn) return;
+	r_itree_delete (anal->fcn_tree, fcn->addr, fcn);
 }
 
-static inline ut64 r_listrange_next(ut64 addr) {
-	return (addr + RANGE);
+R_API void r_anal_fcn_tree_update(RAnal *anal, RAnalFunction *fcn) {
+	RITreeNode *node;
+	if (!anal || !fcn) return;
+	node = r_itree_find (anal->fcn_tree, fcn->addr, fcn);
+	if (node) {
+		r_itree_resize (anal->fcn_tree, node, fcn_end (fcn));
+	}
 }
 
-R_API void r_listrange_free(RListRange *s) {
-	if (!s) return;
-	r_hashtable64_free (s->h);
-	r_list_free (s->l);
-	free (s);
+R_API void r_anal_fcn_tree_purge(RAnal *anal) {
+	if (!anal) return;
+	r_itree_purge (anal->fcn_tree);
 }
 
-R_API void r_listrange_add(RListRange *s, RAnalFunction *f) {
-	ut64 addr;
-	RList *list;
-	ut64 from = f->addr;
-	ut64 to = f->addr + f->size;
-	for (addr = from; addr<to; addr = r_listrange_next (addr)) {
-		ut64 key = r_listrange_key (addr);
-		list = r_hashtable64_lookup (s->h, key);
-		if (list) {
-			if (!r_list_contains (list, f))
-			//r_list_add_sorted (list, f, cmpfun);
-			r_list_append (list, f);
-		} else {
-			list = r_list_new ();
-			//r_list_add_sorted (list, f, cmpfun);
-			r_list_append (list, f);
-			r_hashtable64_insert (s->h, key, list);
-		}
-	}
-	r_list_add_sorted (s->l, f, cmpfun);
+static inline int fcn_match_type(RAnalFunction *fcn, int type) {
+	return !type || (fcn->type & type);
 }
 
-R_API void r_listrange_del(RListRange *s, RAnalFunction *f) {
-	RList *list;
-	ut64 addr, from, to;
-	if (!f) return;
-	from = f->addr;
-	to = f->addr + f->size;
-	for (addr = from; addr<to; addr = r_listrange_next (addr)) {
-		list = r_hashtable64_lookup (s->h, r_listrange_key (addr));
-		if (list) r_list_delete_data (list, f);
+/* last function starting at addr, or the first one if root is set */
+static RAnalFunction *fcn_tree_at(RAnal *anal, ut64 addr, int type, int root) {
+	RAnalFunction *fcn, *ret = NULL;
+	RITreeNode *node;
+	for (node = r_itree_first (anal->fcn_tree, addr);
+			node && node->from == addr;
+			node = r_itree_next (anal->fcn_tree, node)) {
+		fcn = node->data;
+		if (root) {
+			return fcn;
+		}
+		if (fcn_match_type (fcn, type)) {
+			ret = fcn;
+		}
 	}
-	r_list_delete_data (s->l, f);
+	return ret;
 }
 
-R_API void r_listrange_resize(RListRange *s, RAnalFunction *f, int newsize) {
-	if (!f) return;
-	r_listrange_del (s, f);
-	f->size = newsize;
-	r_listrange_add (s, f);
-}
+typedef struct {
+	RITreeNode *node;
+	ut64 addr;
+	int type;
+} FcnTreeQuery;
 
-R_API RAnalFunction *r_listrange_find_in_range(RListRange* s, ut64 addr) {
-	RAnalFunction *f;
-	RListIter *iter;
-	RList *list = r_hashtable64_lookup (s->h, r_listrange_key (addr));
-	if (list)
-	r_list_foreach (list, iter, f) {
-		if (R_BETWEEN (f->addr, addr, f->addr+f->size))
-			return f;
+static int fcn_tree_in_cb(RITreeNode *node, void *user) {
+	FcnTreeQuery *q = user;
+	RAnalFunction *fcn = node->data;
+	if (q->addr > fcn->addr && q->addr < fcn->addr + fcn->size
+			&& fcn_match_type (fcn, q->type)) {
+		// keep the one inserted first, like the old list walk did
+		if (!q->node || node->seq < q->node->seq) {
+			q->node = node;
+		}
 	}
-	return NULL;
+	return true;
 }
 
-R_API RAnalFunction *r_listrange_find_root(RListRange* s, ut64 addr) {
-	RAnalFunction *f;
-	RListIter *iter;
-	RList *list = r_hashtable64_lookup (s->h, r_listrange_key (addr));
-	if (list)
-	r_list_foreach (list, iter, f) {
-		if (addr == f->addr)
-			return f;
+R_API RAnalFunction *r_anal_fcn_tree_in(RAnal *anal, ut64 addr, int type) {
+	FcnTreeQuery q = { NULL, addr, type };
+	RAnalFunction *fcn;
+	if (!anal) return NULL;
+	if (type == R_ANAL_FCN_TYPE_ROOT) {
+		return fcn_tree_at (anal, addr, type, true);
+	}
+	fcn = fcn_tree_at (anal, addr, type, false);
+	if (fcn) {
+		return fcn;
 	}
-	return NULL;
+	r_itree_stab (anal->fcn_tree, addr, fcn_tree_in_cb, &q);
+	return q.node? q.node->data: NULL;
 }
 
-#endif
+R_API RAnalFunction *r_anal_fcn_tree_at(RAnal *anal, ut64 addr, int type) {
+	if (!anal) return NULL;
+	return fcn_tree_at (anal, addr, type, type == R_ANAL_FCN_TYPE_ROOT);
+}
+
+R_API RAnalFunction *r_anal_fcn_tree_next(RAnal *anal, ut64 addr) {
+	RITreeNode *node;
+	if (!anal || addr == UT64_MAX) return NULL;
+	node = r_itree_first (anal->fcn_tree, addr + 1);
+	return node? node->data: NULL;
+}
@@ -654,8 +654,8 @@ static int java_analyze_fns_from_buffer( RAnal *anal, ut64 start, ut64 end, int
 			// XXX - TO Stop or not to Stop ??
 			break;
 		}
-		//r_listrange_add (anal->fcnstore, fcn);
 		r_list_append (anal->fcns, fcn);
+		r_anal_fcn_tree_insert (anal, fcn);
 		offset += fcn->size;
 		if (!analyze_all) break;
 	}
@@ -707,8 +707,8 @@ static int java_analyze_fns( RAnal *anal, ut64 start, ut64 end, int reftype, int
 						eprintf ("Failed to parse java fn: %s @ 0x%04"PFMT64x"\n", fcn->name, fcn->addr);
 						// XXX - TO Stop or not to Stop ??
 					}
-					//r_listrange_add (anal->fcnstore, fcn);
 					r_list_append (anal->fcns, fcn);
+					r_anal_fcn_tree_insert (anal, fcn);
 				}
 			} // End of methods loop
 		}// end of methods_list is valid conditional
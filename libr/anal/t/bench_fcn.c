@@ -0,0 +1,67 @@
+/* times function lookups against the number of analyzed functions */
+
+#include <r_anal.h>
+
+#define LOOKUPS 200000
+
+static RAnalFunction *list_fcn_in(RAnal *anal, ut64 addr) {
+	RAnalFunction *fcn, *ret = NULL;
+	RListIter *iter;
+	r_list_foreach (anal->fcns, iter, fcn) {
+		if (addr == fcn->addr || (!ret &&
+		   addr > fcn->addr && addr < fcn->addr + fcn->size))
+			ret = fcn;
+	}
+	return ret;
+}
+
+static void bench(int nfcns) {
+	RAnal *anal = r_anal_new ();
+	RProfile prof;
+	ut64 *addrs, end = 0x1000 + (ut64)nfcns * 0x100;
+	double t_tree, t_list;
+	int i, hits = 0, miss = 0;
+
+	for (i = 0; i < nfcns; i++) {
+		ut64 at = 0x1000 + (ut64)i * 0x100;
+		r_anal_fcn_add (anal, at, 0xc0, NULL, R_ANAL_FCN_TYPE_FCN, NULL);
+		/* some overlapping local labels */
+		if (!(i % 8)) {
+			r_anal_fcn_add (anal, at + 0x20, 0x10, NULL, R_ANAL_FCN_TYPE_LOC, NULL);
+		}
+	}
+	addrs = malloc (sizeof (ut64) * LOOKUPS);
+	for (i = 0; i < LOOKUPS; i++) {
+		addrs[i] = 0x1000 + ((ut64)rand () * rand ()) % (end - 0x1000);
+	}
+
+	r_prof_start (&prof);
+	for (i = 0; i < LOOKUPS; i++) {
+		if (r_anal_get_fcn_in (anal, addrs[i], 0)) hits++;
+	}
+	r_prof_end (&prof);
+	t_tree = prof.result;
+
+	/* the linear walk is too slow to run on every lookup */
+	r_prof_start (&prof);
+	for (i = 0; i < LOOKUPS / 100; i++) {
+		if (list_fcn_in (anal, addrs[i]) != r_anal_get_fcn_in (anal, addrs[i], 0))
+			miss++;
+	}
+	r_prof_end (&prof);
+	t_list = prof.result * 100;
+
+	printf ("%8d fcns  tree %8.3f us/lookup  list %10.3f us/lookup  (%d hits, %d mismatches)\n",
+		r_list_length (anal->fcns), t_tree * 1000000 / LOOKUPS,
+		t_list * 1000000 / LOOKUPS, hits, miss);
+	free (addrs);
+	r_anal_free (anal);
+}
+
+int main(int argc, char **argv) {
+	int n, max = (argc > 1)? atoi (argv[1]): 100000;
+	for (n = 1000; n <= max; n *= 10) {
+		bench (n);
+	}
+	return 0;
+}
@@ -1,9 +1,15 @@
-/* radare - LGPL - Copyright 2009-2014 - pancake, nibble */
+/* radare - LGPL - Copyright 2009-2015 - pancake, nibble */
+
+/* xrefs are kept in two sorted arrays of (addr, type, other) items, one
+ * keyed by the source address and the other by the destination. New
+ * items are appended unsorted and merged in bulk on the next lookup.
+ * sdb_xrefs is only filled on export to keep the project format */
 
 #include <r_anal.h>
 #include <sdb.h>
 
 #define DB anal->sdb_xrefs
+#define PENDING_MAX 0x10000
 
 static void XREFKEY(char * const key, const size_t key_len,
 	char const * const kind, const RAnalRefType type, const ut64 addr) {
@@ -28,6 +34,188 @@ static void XREFKEY(char * const key, const size_t key_len,
 	snprintf (key, key_len, "%s.%s.0x%"PFMT64x, kind, _sdb_type, addr);
 }
 
+/* order of the types in the lists, same as the old per-type lookups */
+static int type_rank(int type) {
+	switch (type) {
+	case R_ANAL_REF_TYPE_CODE: return 1;
+	case R_ANAL_REF_TYPE_CALL: return 2;
+	case R_ANAL_REF_TYPE_DATA: return 3;
+	case R_ANAL_REF_TYPE_STRING: return 4;
+	}
+	return 0;
+}
+
+static int type_fix(int type) {
+	// unknown types are stored as "unk" and read back as null
+	return type_rank (type)? type: R_ANAL_REF_TYPE_NULL;
+}
+
+static int item_cmp(const RAnalXrefsItem *a, const RAnalXrefsItem *b) {
+	int ra, rb;
+	if (a->addr != b->addr) {
+		return (a->addr < b->addr)? -1: 1;
+	}
+	ra = type_rank (a->type);
+	rb = type_rank (b->type);
+	if (ra != rb) {
+		return (ra < rb)? -1: 1;
+	}
+	if (a->other != b->other) {
+		return (a->other < b->other)? -1: 1;
+	}
+	return 0;
+}
+
+static int item_qcmp(const void *a, const void *b) {
+	return item_cmp (a, b);
+}
+
+static void index_reset(RAnalXrefsIndex *idx) {
+	R_FREE (idx->items);
+	idx->length = idx->sorted = idx->size = 0;
+}
+
+/* sort the pending items and merge them into the sorted ones */
+static int index_flush(RAnalXrefsIndex *idx) {
+	RAnalXrefsItem *a, *b, *out, *tmp;
+	int i, n, alen, blen;
+	if (idx->sorted == idx->length) {
+		return true;
+	}
+	b = idx->items + idx->sorted;
+	blen = idx->length - idx->sorted;
+	qsort (b, blen, sizeof (RAnalXrefsItem), item_qcmp);
+	for (i = n = 1; i < blen; i++) {
+		if (item_cmp (&b[n - 1], &b[i])) {
+			b[n++] = b[i];
+		}
+	}
+	blen = n;
+	a = idx->items;
+	alen = idx->sorted;
+	if (!alen || item_cmp (&a[alen - 1], b) < 0) {
+		// appended in order, nothing to merge
+		idx->length = idx->sorted = alen + blen;
+		return true;
+	}
+	tmp = malloc (sizeof (RAnalXrefsItem) * idx->size);
+	if (!tmp) {
+		return false;
+	}
+	out = tmp;
+	for (i = n = 0; i < alen || n < blen; ) {
+		int cmp = (i == alen)? 1: (n == blen)? -1: item_cmp (&a[i], &b[n]);
+		if (cmp < 0) {
+			*out++ = a[i++];
+		} else {
+			*out++ = b[n++];
+			if (!cmp) i++;
+		}
+	}
+	free (idx->items);
+	idx->items = tmp;
+	idx->length = idx->sorted = out - tmp;
+	return true;
+}
+
+static int index_add(RAnalXrefsIndex *idx, ut64 addr, ut64 other, int type) {
+	RAnalXrefsItem *it;
+	if (idx->length > 0) {
+		it = &idx->items[idx->length - 1];
+		if (it->addr == addr && it->other == other && it->type == type) {
+			return true;
+		}
+	}
+	if (idx->length - idx->sorted >= R_MAX (PENDING_MAX, idx->sorted)) {
+		// do not let repeated refs grow the pending list forever
+		index_flush (idx);
+	}
+	if (idx->length >= idx->size) {
+		int size = idx->size? idx->size * 2: 1024;
+		it = realloc (idx->items, sizeof (RAnalXrefsItem) * size);
+		if (!it) {
+			return false;
+		}
+		idx->items = it;
+		idx->size = size;
+	}
+	it = &idx->items[idx->length++];
+	it->addr = addr;
+	it->other = other;
+	it->type = type;
+	return true;
+}
+
+/* index of the first item not lower than (addr, type, other) */
+static int index_lower(RAnalXrefsIndex *idx, ut64 addr, int type, ut64 other) {
+	RAnalXrefsItem key = { addr, other, type };
+	int lo = 0, hi;
+	index_flush (idx);
+	hi = idx->length;
+	while (lo < hi) {
+		int mid = lo + (hi - lo) / 2;
+		if (item_cmp (&idx->items[mid], &key) < 0) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+static int index_del(RAnalXrefsIndex *idx, ut64 addr, ut64 other, int type) {
+	int i = index_lower (idx, addr, type, other);
+	RAnalXrefsItem *it = idx->items + i;
+	if (i >= idx->length || it->addr != addr || it->other != other
+			|| type_rank (it->type) != type_rank (type)) {
+		return false;
+	}
+	memmove (it, it + 1, sizeof (RAnalXrefsItem) * (idx->length - i - 1));
+	idx->length--;
+	idx->sorted--;
+	return true;
+}
+
+static RAnalRef *item_ref(RAnalXrefsItem *it) {
+	RAnalRef *ref = r_anal_ref_new ();
+	if (ref) {
+		ref->addr = it->other;
+		ref->at = it->addr;
+		ref->type = it->type;
+	}
+	return ref;
+}
+
+/* append to list the refs whose key is in [from, to) */
+static int index_get(RAnalXrefsIndex *idx, RList *list, ut64 from, ut64 to) {
+	int i, count = 0;
+	RAnalRef *ref;
+	for (i = index_lower (idx, from, R_ANAL_REF_TYPE_NULL, 0); i < idx->length; i++) {
+		if (idx->items[i].addr >= to) {
+			break;
+		}
+		if (!(ref = item_ref (&idx->items[i]))) {
+			break;
+		}
+		r_list_append (list, ref);
+		count++;
+	}
+	return count;
+}
+
+static RList *xrefs_get(RAnalXrefsIndex *idx, ut64 from, ut64 to) {
+	RList *list;
+	if (!idx) return NULL;
+	list = r_list_new ();
+	if (!list) return NULL;
+	list->free = NULL; // XXX
+	if (!index_get (idx, list, from, to)) {
+		r_list_free (list);
+		return NULL;
+	}
+	return list;
+}
+
 R_API int r_anal_xrefs_load(RAnal *anal, const char *prjfile) {
 	char *path, *db = r_str_newf (R2_HOMEDIR"/projects/%s.d", prjfile);
 	ut8 found = 0;
@@ -57,100 +245,208 @@ R_API int r_anal_xrefs_load(RAnal *anal, const char *prjfile) {
 	sdb_ns_set (anal->sdb, "xrefs", DB);
 	free (path);
 	free (db);
-	return true;
+	return r_anal_xrefs_import (anal);
 }
 
 R_API void r_anal_xrefs_save(RAnal *anal, const char *prjfile) {
+	r_anal_xrefs_export (anal);
 	sdb_sync (anal->sdb_xrefs);
 }
 
 R_API int r_anal_xrefs_set (RAnal *anal, const RAnalRefType type,
 			     ut64 from, ut64 to) {
-	char key[32];
-	if (!anal || !DB)
+	int t = type_fix (type);
+	if (!anal || !anal->xrefs_from)
 		return false;
 	// unknown refs should not be stored. seems wrong
 	if (type == R_ANAL_REF_TYPE_NULL) {
 		return false;
 	}
-	XREFKEY (key, sizeof (key), "ref", type, from);
-	sdb_array_add_num (DB, key, to, 0);
-	XREFKEY (key, sizeof (key), "xref", type, to);
-	sdb_array_add_num (DB, key, from, 0);
-	return true;
+	return index_add (anal->xrefs_from, from, to, t)
+		&& index_add (anal->xrefs_to, to, from, t);
 }
 
 R_API int r_anal_xrefs_deln (RAnal *anal, const RAnalRefType type, ut64 from, ut64 to) {
-	char key[32];
-	if (!anal || !DB)
+	int t = type_fix (type);
+	if (!anal || !anal->xrefs_from)
 		return false;
-	XREFKEY (key, sizeof (key), "ref", type, from);
-	sdb_array_remove_num (DB, key, to, 0);
-	XREFKEY (key, sizeof (key), "xref", type, to);
-	sdb_array_remove_num (DB, key, from, 0);
+	index_del (anal->xrefs_from, from, to, t);
+	index_del (anal->xrefs_to, to, from, t);
 	return true;
 }
 
 R_API int r_anal_xrefs_from (RAnal *anal, RList *list, const char *kind, const RAnalRefType type, ut64 addr) {
-	char *next, *s, *str, *ptr, key[256];
-	RAnalRef *ref = NULL;
-	XREFKEY(key, sizeof (key), kind, type, addr);
-	str = sdb_get (DB, key, 0);
-	if (!str) return false;
-	for (ptr=str; ; ptr = next) {
-		s = sdb_anext (ptr, &next);
-		if (!(ref = r_anal_ref_new ()))
-			return false;
-		ref->addr = r_num_get (NULL, s);
-		ref->at = addr;
-		ref->type = type;
-		r_list_append (list, ref);
-		if (!next)
+	RAnalXrefsIndex *idx;
+	RAnalRef *ref;
+	int i, t = type_fix (type), count = 0;
+	if (!anal || !kind) return false;
+	idx = strcmp (kind, "xref")? anal->xrefs_from: anal->xrefs_to;
+	if (!idx) return false;
+	for (i = index_lower (idx, addr, t, 0); i < idx->length; i++) {
+		RAnalXrefsItem *it = &idx->items[i];
+		if (it->addr != addr || it->type != t) {
+			break;
+		}
+		if (!(ref = item_ref (it))) {
 			break;
+		}
+		r_list_append (list, ref);
+		count++;
 	}
-	free (str);
-	return true;
+	return count > 0;
 }
 
 R_API RList *r_anal_xrefs_get (RAnal *anal, ut64 to) {
-	RList *list = r_list_new ();
-	if (!list) return NULL;
-	list->free = NULL; // XXX
-	r_anal_xrefs_from (anal, list, "xref", R_ANAL_REF_TYPE_NULL, to);
-	r_anal_xrefs_from (anal, list, "xref", R_ANAL_REF_TYPE_CODE, to);
-	r_anal_xrefs_from (anal, list, "xref", R_ANAL_REF_TYPE_CALL, to);
-	r_anal_xrefs_from (anal, list, "xref", R_ANAL_REF_TYPE_DATA, to);
-	r_anal_xrefs_from (anal, list, "xref", R_ANAL_REF_TYPE_STRING, to);
-	if (r_list_empty (list)) {
-		r_list_free (list);
-		list = NULL;
+	if (!anal || to == UT64_MAX) return NULL;
+	return xrefs_get (anal->xrefs_to, to, to + 1);
+}
+
+R_API RList *r_anal_xrefs_get_from (RAnal *anal, ut64 from) {
+	if (!anal || from == UT64_MAX) return NULL;
+	return xrefs_get (anal->xrefs_from, from, from + 1);
+}
+
+/* refs pointing into [from, to) */
+R_API RList *r_anal_xrefs_get_range (RAnal *anal, ut64 from, ut64 to) {
+	if (!anal) return NULL;
+	return xrefs_get (anal->xrefs_to, from, to);
+}
+
+/* refs done from code in [from, to) */
+R_API RList *r_anal_xrefs_get_from_range (RAnal *anal, ut64 from, ut64 to) {
+	if (!anal) return NULL;
+	return xrefs_get (anal->xrefs_from, from, to);
+}
+
+R_API int r_anal_xrefs_count (RAnal *anal) {
+	if (!anal || !anal->xrefs_from) return 0;
+	index_flush (anal->xrefs_from);
+	return anal->xrefs_from->length;
+}
+
+static int xrefs_export_index(RAnal *anal, RAnalXrefsIndex *idx, const char *kind) {
+	char key[64], num[64], *n, *str = NULL;
+	int i, len, size = 0;
+	index_flush (idx);
+	for (i = 0; i < idx->length; ) {
+		RAnalXrefsItem *it = &idx->items[i];
+		// all the items of the same key are contiguous
+		for (len = 0; i < idx->length; i++) {
+			RAnalXrefsItem *jt = &idx->items[i];
+			if (jt->addr != it->addr || jt->type != it->type) {
+				break;
+			}
+			if (len + 24 > size) {
+				size = size? size * 2: 1024;
+				n = realloc (str, size);
+				if (!n) {
+					free (str);
+					return false;
+				}
+				str = n;
+			}
+			if (len) str[len++] = SDB_RS;
+			n = sdb_itoa (jt->other, num, 16);
+			strcpy (str + len, n);
+			len += strlen (n);
+		}
+		XREFKEY (key, sizeof (key), kind, it->type, it->addr);
+		sdb_set (DB, key, str, 0);
 	}
-	return list;
+	free (str);
+	return true;
 }
 
-R_API RList *r_anal_xrefs_get_from (RAnal *anal, ut64 to) {
-	RList *list = r_list_new ();
-	if (!list) return NULL;
-	list->free = NULL; // XXX
-	r_anal_xrefs_from (anal, list, "ref", R_ANAL_REF_TYPE_NULL, to);
-	r_anal_xrefs_from (anal, list, "ref", R_ANAL_REF_TYPE_CODE, to);
-	r_anal_xrefs_from (anal, list, "ref", R_ANAL_REF_TYPE_CALL, to);
-	r_anal_xrefs_from (anal, list, "ref", R_ANAL_REF_TYPE_DATA, to);
-	r_anal_xrefs_from (anal, list, "ref", R_ANAL_REF_TYPE_STRING, to);
-	if (r_list_length (list)<1) {
-		r_list_free (list);
-		list = NULL;
+/* write the index into sdb_xrefs using the same keys the project files have */
+R_API int r_anal_xrefs_export(RAnal *anal) {
+	if (!anal || !DB || !anal->xrefs_from)
+		return false;
+	sdb_reset (DB);
+	sdb_array_set (DB, "types", -1, "code.jmp,code.call,data.mem,data.string", 0);
+	return xrefs_export_index (anal, anal->xrefs_from, "ref")
+		&& xrefs_export_index (anal, anal->xrefs_to, "xref");
+}
+
+static int xrefs_import_cb(void *user, const char *k, const char *v) {
+	RAnal *anal = user;
+	const char *p;
+	char *str, *ptr, *next;
+	int type = R_ANAL_REF_TYPE_NULL;
+	ut64 from, to;
+	// the xref.* keys are the same data seen from the other side
+	if (strncmp (k, "ref.", 4)) {
+		return 1;
 	}
-	return list;
+	k += 4;
+	if (!strncmp (k, "code.jmp.", 9)) {
+		type = R_ANAL_REF_TYPE_CODE;
+	} else if (!strncmp (k, "code.call.", 10)) {
+		type = R_ANAL_REF_TYPE_CALL;
+	} else if (!strncmp (k, "data.mem.", 9)) {
+		type = R_ANAL_REF_TYPE_DATA;
+	} else if (!strncmp (k, "data.string.", 12)) {
+		type = R_ANAL_REF_TYPE_STRING;
+	}
+	p = strstr (k, ".0x");
+	if (!p) {
+		return 1;
+	}
+	from = r_num_get (NULL, p + 1);
+	str = strdup (v);
+	if (!str) {
+		return 0;
+	}
+	for (ptr = str; ptr; ptr = next) {
+		to = r_num_get (NULL, sdb_anext (ptr, &next));
+		index_add (anal->xrefs_from, from, to, type);
+		index_add (anal->xrefs_to, to, from, type);
+	}
+	free (str);
+	return 1;
+}
+
+/* replace the index with the contents of sdb_xrefs */
+R_API int r_anal_xrefs_import(RAnal *anal) {
+	if (!anal || !DB || !anal->xrefs_from)
+		return false;
+	index_reset (anal->xrefs_from);
+	index_reset (anal->xrefs_to);
+	sdb_foreach (DB, xrefs_import_cb, anal);
+	index_flush (anal->xrefs_from);
+	index_flush (anal->xrefs_to);
+	return true;
 }
 
 R_API int r_anal_xrefs_init (RAnal *anal) {
+	if (!anal) return false;
+	if (!anal->xrefs_from) {
+		anal->xrefs_from = R_NEW0 (RAnalXrefsIndex);
+		anal->xrefs_to = R_NEW0 (RAnalXrefsIndex);
+		if (!anal->xrefs_from || !anal->xrefs_to) {
+			r_anal_xrefs_fini (anal);
+			return false;
+		}
+	}
+	index_reset (anal->xrefs_from);
+	index_reset (anal->xrefs_to);
 	sdb_reset (DB);
 	if (!DB) return false;
 	sdb_array_set (DB, "types", -1, "code.jmp,code.call,data.mem,data.string", 0);
 	return true;
 }
 
+R_API void r_anal_xrefs_fini (RAnal *anal) {
+	if (!anal) return;
+	if (anal->xrefs_from) {
+		index_reset (anal->xrefs_from);
+		R_FREE (anal->xrefs_from);
+	}
+	if (anal->xrefs_to) {
+		index_reset (anal->xrefs_to);
+		R_FREE (anal->xrefs_to);
+	}
+}
+
 static int xrefs_list_cb_rad(RAnal *anal, const char *k, const char *v) {
 	ut64 dst, src = r_num_get (NULL, v);
 	if (!strncmp (k, "ref.", 4)) {
@@ -181,7 +477,10 @@ static int xrefs_list_cb_plain(RAnal *anal, const char *k, const char *v) {
 	return 1;
 }
 
+/* listed from the sdb snapshot of the index */
 R_API void r_anal_xrefs_list(RAnal *anal, int rad) {
+	if (!r_anal_xrefs_export (anal))
+		return;
 	switch (rad) {
 	case 1:
 	case '*':
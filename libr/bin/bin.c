@@ -33,23 +33,23 @@ static RList* get_strings(RBinFile *a, int min, int dump);
 static void r_bin_object_delete_items (RBinObject *o);
 static void r_bin_object_free (void /*RBinObject*/ *o_);
 static int r_bin_object_set_items(RBinFile *binfile, RBinObject *o);
-static int r_bin_file_set_bytes (RBinFile *binfile, const ut8 * bytes, ut64 sz);
 //static int remove_bin_file_by_binfile (RBin *bin, RBinFile * binfile);
 //static void r_bin_free_bin_files (RBin *bin);
 static void r_bin_file_free (void /*RBinFile*/ *bf_);
-static RBinFile * r_bin_file_create_append (RBin *bin, const char *file, const ut8 * bytes, ut64 sz, ut64 file_sz, int rawstr, int fd, const char *xtrname);
+static RBinFile * r_bin_file_create_append (RBin *bin, const char *file, RBuffer *buf, ut64 file_sz, int rawstr, int fd, const char *xtrname);
 
 static int r_bin_file_object_new_from_xtr_data (RBin *bin, RBinFile *bf, ut64 baseaddr, ut64 loadaddr, RBinXtrData *xtr_data);
 static int r_bin_files_populate_from_xtrlist (RBin *bin, RBinFile *binfile, ut64 baseaddr, ut64 loadaddr, RList *xtr_data_list);
-static RBinFile * r_bin_file_xtr_load_bytes (RBin *bin, RBinXtrPlugin *xtr, const char *filename, const ut8 *bytes, ut64 sz, ut64 file_sz, ut64 baseaddr, ut64 loadaddr, int idx, int fd, int rawstr);
+static RBinFile * r_bin_file_xtr_load_buffer (RBin *bin, RBinXtrPlugin *xtr, const char *filename, RBuffer *buf, ut64 file_sz, ut64 baseaddr, ut64 loadaddr, int idx, int fd, int rawstr);
 int r_bin_load_io_at_offset_as_sz(RBin *bin, RIODesc *desc, ut64 baseaddr, ut64 loadaddr, int xtr_idx, ut64 offset, const char *name, ut64 sz);
 
 static RBinPlugin * r_bin_get_binplugin_by_name (RBin *bin, const char *name);
 static RBinXtrPlugin * r_bin_get_xtrplugin_by_name (RBin *bin, const char *name);
 static RBinPlugin * r_bin_get_binplugin_any (RBin *bin);
 static RBinObject * r_bin_object_new (RBinFile *binfile, RBinPlugin *plugin, ut64 baseaddr, ut64 loadaddr, ut64 offset, ut64 sz);
-static RBinFile * r_bin_file_new (RBin *bin, const char *file, const ut8 * bytes, ut64 sz, ut64 file_sz, int rawstr, int fd, const char *xtrname, Sdb *sdb);
-static RBinFile * r_bin_file_new_from_bytes (RBin *bin, const char *file, const ut8 * bytes, ut64 sz, ut64 file_sz, int rawstr, ut64 baseaddr, ut64 loadaddr, int fd, const char *pluginname, const char *xtrname, ut64 offset);
+static RBinFile * r_bin_file_new (RBin *bin, const char *file, RBuffer *buf, ut64 file_sz, int rawstr, int fd, const char *xtrname, Sdb *sdb);
+static RBinFile * r_bin_file_new_from_buffer (RBin *bin, const char *file, RBuffer *buf, ut64 file_sz, int rawstr, ut64 baseaddr, ut64 loadaddr, int fd, const char *pluginname, const char *xtrname, ut64 offset);
+static RBuffer * r_bin_buf_from_bytes (ut8 *bytes, ut64 sz);
 static int getoffset (RBin *bin, int type, int idx);
 static const char *getname (RBin *bin, int off);
 static int r_bin_file_object_add (RBinFile *binfile, RBinObject *o);
@@ -111,7 +111,6 @@ R_API int r_bin_file_cur_set_plugin (RBinFile *binfile, RBinPlugin *plugin) {
 }
 
 enum {
-	R_STRING_TYPE_DETECT = '?',
 	R_STRING_TYPE_ASCII = 'a',
 	R_STRING_TYPE_UTF8 = 'u',
 	R_STRING_TYPE_WIDE = 'w',
@@ -119,103 +118,83 @@ enum {
 
 #define R_STRING_SCAN_BUFFER_SIZE 2048
 
-static int string_scan_range (RList *list, const ut8 *buf, int min, const ut64 from, const ut64 to, int type) {
+typedef struct {
+	RList *list;
+	const ut8 *buf;
+	ut64 from;
+	int len;
+	int count;
+} StringScan;
+
+/* r_str_scan callback, unescapes and stores the run or dumps it */
+static int string_found(void *user, int off, int len, int size, int enc) {
+	StringScan *ss = user;
+	const ut8 *p = ss->buf + off;
 	ut8 tmp[R_STRING_SCAN_BUFFER_SIZE];
-	ut64 needle = from, str_start;
-	int count = 0, i, rc, runes, str_type = R_STRING_TYPE_DETECT;
-	if (type == -1)
-		type = R_STRING_TYPE_DETECT;
-
-	if (!buf || !min)
-		return -1;
-
-	while (needle < to) {
-		rc = r_utf8_decode (buf+needle, to-needle, NULL);
-		if (!rc) {
-			needle++;
-			continue;
-		}
-
-		str_type = type;
-
-		if (str_type == R_STRING_TYPE_DETECT) {
-			if (needle+rc+2 < to &&
-				buf[needle+rc+0] == 0x00 &&
-				buf[needle+rc+1] != 0x00 &&
-				buf[needle+rc+2] == 0x00)
-				str_type = R_STRING_TYPE_WIDE;
-			else
-				str_type = R_STRING_TYPE_ASCII;
-		}
-
-		runes = 0;
-		str_start = needle;
-
-		/* Eat a whole C string */
-		for (rc = i = 0; i < sizeof (tmp) - 3 && needle < to; i += rc) {
-			RRune r;
-
-			if (str_type == R_STRING_TYPE_WIDE) {
-				if (needle+1<to) {
-					r = buf[needle+1] << 8 | buf[needle];
-					rc = 2;
-				} else {
-					break;
-				}
-			} else {
-				rc = r_utf8_decode (buf+needle, to-needle, &r);
-				if (rc > 1) str_type = R_STRING_TYPE_UTF8;
-			}
-
-			/* Invalid sequence detected */
-			if (!rc) {
-				needle++;
+	int i = 0, j, rc, type = R_STRING_TYPE_ASCII;
+	int term = (enc == R_STRSCAN_UTF16LE)? 2: 1;
+	RRune r;
+
+	if (enc == R_STRSCAN_UTF16LE)
+		type = R_STRING_TYPE_WIDE;
+	for (j = 0; j < size && i < sizeof (tmp) - 4; j += rc) {
+		if (type == R_STRING_TYPE_WIDE) {
+			r = p[j] | p[j+1] << 8;
+			rc = 2;
+		} else {
+			rc = r_utf8_decode (p + j, size - j, &r);
+			if (!rc)
 				break;
-			}
-
-			needle += rc;
-
-			if (r_isprint (r)) {
-				rc = r_utf8_encode (&tmp[i], r);
-				runes++;
-			}
+			if (rc > 1)
+				type = R_STRING_TYPE_UTF8;
+		}
+		if (r < ' ') {
 			/* Print the escape code */
-			else if (r && r < 0x100 && strchr ("\b\v\f\n\r\t\a\e", (char)r)) {
-				if ((i+32) < sizeof (tmp) && r < 28) {
-					tmp[i+0] = '\\';
-					tmp[i+1] = "       abtnvfr             e"[r];
-				} else {
-					// string too long
-					break;
-				}
-				rc = 2;
-				runes++;
-			}
-			/* \0 marks the end of C-strings */
-			else break;
+			tmp[i++] = '\\';
+			tmp[i++] = "       abtnvfr             e"[r];
+		} else {
+			i += r_utf8_encode (&tmp[i], r);
 		}
+	}
+	tmp[i++] = '\0';
 
-		tmp[i++] = '\0';
-
-		if (runes >= min) {
-			if (list) {
-				RBinString *new = R_NEW0 (RBinString);
-				new->type = str_type;
-				new->length = runes;
-				new->size = needle - str_start;
-				new->ordinal = count++;
-				new->paddr = new->vaddr = str_start;
-				if (i < sizeof (new->string))
-					memcpy (new->string, tmp, i);
-				r_list_append (list, new);
-			} else {
-				// DUMP TO STDOUT. raw dumping for rabin2 -zzz
-				printf ("0x%08"PFMT64x" %s\n", str_start, tmp);
-			}
-		}
+	if (ss->list) {
+		RBinString *new = R_NEW0 (RBinString);
+		if (!new)
+			return false;
+		new->type = type;
+		new->length = len;
+		/* the size takes the terminator too */
+		new->size = size + R_MIN (term, ss->len - off - size);
+		new->ordinal = ss->count++;
+		new->paddr = new->vaddr = ss->from + off;
+		if (i < sizeof (new->string))
+			memcpy (new->string, tmp, i);
+		r_list_append (ss->list, new);
+	} else {
+		// DUMP TO STDOUT. raw dumping for rabin2 -zzz
+		printf ("0x%08"PFMT64x" %s\n", ss->from + off, tmp);
 	}
+	return true;
+}
 
-	return count;
+/* the runs are found by r_str_scan, utf-8 and utf-16le ones */
+static int string_scan_range (RList *list, const ut8 *buf, int min, ut64 from, const ut64 to) {
+	StringScan ss = { list, NULL, 0, 0, 0 };
+	int len;
+
+	if (!buf || !min)
+		return -1;
+	for (; from < to; from += len) {
+		len = R_MIN (to - from, ST32_MAX);
+		ss.buf = buf + from;
+		ss.from = from;
+		ss.len = len;
+		if (r_str_scan (ss.buf, len, min, 0, R_STRSCAN_UTF8 | R_STRSCAN_UTF16LE,
+				string_found, &ss) < 0)
+			return -1;
+	}
+	return ss.count;
 }
 
 static void get_strings_range(RBinFile *arch, RList *list, int min, ut64 from, ut64 to) {
@@ -255,7 +234,7 @@ static void get_strings_range(RBinFile *arch, RList *list, int min, ut64 from, u
 		}
 	}
 
-	if (string_scan_range (list, arch->buf->buf, min, from, to, -1) < 0)
+	if (string_scan_range (list, arch->buf->buf, min, from, to) < 0)
 		return;
 
 	r_list_foreach (list, it, ptr) {
@@ -401,13 +380,19 @@ static void r_bin_object_free (void /*RBinObject*/ *o_) {
 	free (o);
 }
 
+/* only what the header gives and most users need is loaded with the
+ * object, the rest of the lists are loaded on the first access through
+ * the r_bin_get_* accessors. The callbacks keep their old relative order,
+ * since some plugins use state left by the previous ones: elf and mach0
+ * relocs point to imports and symbols by ordinal, mach0 info is filled
+ * while reading the symbols, and the language is guessed from them */
 // XXX - change this to RBinObject instead of RBinFile
 // makes no sense to pass in a binfile and set the RBinObject
 // kinda a clunky functions
 static int r_bin_object_set_items(RBinFile *binfile, RBinObject *o) {
 	RBinObject *old_o;
 	RBinPlugin *cp;
-	int i, minlen;
+	int i;
 	RBin *bin;
 
 	if (!binfile || !o || !o->plugin)
@@ -417,11 +402,6 @@ static int r_bin_object_set_items(RBinFile *binfile, RBinObject *o) {
 	old_o = binfile->o;
 	cp = o->plugin;
 
-	if (binfile->rbin->minstrlen>0) {
-		minlen = binfile->rbin->minstrlen;
-	} else {
-		minlen = cp->minstrlen;
-	}
 	binfile->o = o;
 	if (cp->baddr) {
 		ut64 old_baddr = o->baddr;
@@ -460,36 +440,91 @@ static int r_bin_object_set_items(RBinFile *binfile, RBinObject *o) {
 			r_bin_filter_symbols (o->symbols);
 	}
 	o->info = cp->info? cp->info (binfile): NULL;
-	if (cp->libs) o->libs = cp->libs (binfile);
-	if (cp->relocs) {
-		o->relocs = cp->relocs (binfile);
-		REBASE_PADDR (o, o->relocs, RBinReloc);
-	}
 	if (cp->sections) {
 		o->sections = cp->sections (binfile);
 		REBASE_PADDR (o, o->sections, RBinSection);
 		if (bin->filter)
 			r_bin_filter_sections (o->sections);
 	}
-	if (cp->strings) {
-		o->strings = cp->strings (binfile);
+	if (cp->get_sdb) o->kv = cp->get_sdb (o);
+	o->loaded = 0;
+	binfile->o = old_o;
+	return true;
+}
+
+R_API int r_bin_object_load_items(RBinFile *binfile, RBinObject *o, int items) {
+	RBinObject *old_o;
+	RBinPlugin *cp;
+	int minlen;
+	RBin *bin;
+
+	if (!binfile || !o || !o->plugin)
+		return false;
+	if (items & R_BIN_ITEM_LANG)
+		items |= R_BIN_ITEM_LIBS | R_BIN_ITEM_CLASSES;
+	items &= ~o->loaded;
+	if (!items)
+		return true;
+	// marked first, so the callbacks can use the accessors
+	o->loaded |= items;
+
+	bin = binfile->rbin;
+	old_o = binfile->o;
+	cp = o->plugin;
+
+	if (binfile->rbin->minstrlen>0) {
+		minlen = binfile->rbin->minstrlen;
 	} else {
-		o->strings = get_strings (binfile, minlen, 0);
+		minlen = cp->minstrlen;
+	}
+	binfile->o = o;
+	if ((items & R_BIN_ITEM_LIBS) && cp->libs) {
+		r_list_free (o->libs);
+		o->libs = cp->libs (binfile);
+	}
+	if ((items & R_BIN_ITEM_RELOCS) && cp->relocs) {
+		r_list_free (o->relocs);
+		o->relocs = cp->relocs (binfile);
+		REBASE_PADDR (o, o->relocs, RBinReloc);
+	}
+	if (items & R_BIN_ITEM_STRINGS) {
+		r_list_free (o->strings);
+		if (cp->strings) {
+			o->strings = cp->strings (binfile);
+		} else {
+			o->strings = get_strings (binfile, minlen, 0);
+		}
+		REBASE_PADDR (o, o->strings, RBinString);
 	}
-	REBASE_PADDR (o, o->strings, RBinString);
-	if (cp->classes) {
+	if ((items & R_BIN_ITEM_CLASSES) && cp->classes) {
+		r_list_free (o->classes);
 		o->classes = cp->classes (binfile);
 		if (bin->filter)
 			r_bin_filter_classes (o->classes);
 	}
-	if (cp->lines) o->lines = cp->lines (binfile);
-	if (cp->get_sdb) o->kv = cp->get_sdb (o);
-	if (cp->mem) o->mem = cp->mem (binfile);
-	o->lang = r_bin_load_languages (binfile);
+	if ((items & R_BIN_ITEM_LINES) && cp->lines) {
+		r_list_free (o->lines);
+		o->lines = cp->lines (binfile);
+	}
+	if ((items & R_BIN_ITEM_MEM) && cp->mem) {
+		if (o->mem) o->mem->free = mem_free;
+		r_list_free (o->mem);
+		o->mem = cp->mem (binfile);
+	}
+	if (items & R_BIN_ITEM_LANG)
+		o->lang = r_bin_load_languages (binfile);
 	binfile->o = old_o;
 	return true;
 }
 
+/* current object with the given items loaded */
+static RBinObject *r_bin_cur_object_items(RBin *bin, int items) {
+	RBinFile *binfile = r_bin_cur (bin);
+	RBinObject *o = binfile? binfile->o: NULL;
+	r_bin_object_load_items (binfile, o, items);
+	return o;
+}
+
 // XXX - this is a rather hacky way to do things, there may need to be a better way.
 R_API int r_bin_load(RBin *bin, const char *file, ut64 baseaddr, ut64 loadaddr, int xtr_idx, int fd, int rawstr) {
 // ALIAS?	return r_bin_load_as (bin, file, baseaddr, loadaddr, xtr_idx, fd, rawstr, 0, file);
@@ -582,8 +617,9 @@ R_API int r_bin_reload(RBin *bin, RIODesc *desc, ut64 baseaddr) {
 		return false;
 	}
 
-	r_bin_file_set_bytes (bf, buf_bytes, sz);
-	free (buf_bytes);
+	r_buf_free (bf->buf);
+	bf->buf = r_bin_buf_from_bytes (buf_bytes, sz);
+	bf->size = sz;
 
 	if (r_list_length (the_obj_list) == 1) {
 		RBinObject *old_o = (RBinObject *) r_list_get_n (the_obj_list, 0);
@@ -611,6 +647,7 @@ R_API int r_bin_load_io_at_offset_as_sz(RBin *bin, RIODesc *desc, ut64 baseaddr,
 	RIO *io = iob ? iob->get_io(iob) : NULL;
 	RListIter *it;
 	ut8* buf_bytes = NULL;
+	RBuffer *buf = NULL;
 	RBinXtrPlugin *xtr;
 	ut64 file_sz = UT64_MAX;
 	RBinFile *binfile = NULL;
@@ -661,18 +698,24 @@ R_API int r_bin_load_io_at_offset_as_sz(RBin *bin, RIODesc *desc, ut64 baseaddr,
 		ut64 seekaddr = is_debugger ? baseaddr : loadaddr;
 
 		if (seekaddr == UT64_MAX) seekaddr = 0;
-		iob->desc_seek (io, desc, seekaddr);
-		buf_bytes = iob->desc_read (io, desc, &sz);
+		// map whole local files instead of copying them to the heap
+		if (!is_debugger && !seekaddr && sz == file_sz && iob->desc_mmap)
+			buf = iob->desc_mmap (io, desc);
+		if (!buf) {
+			iob->desc_seek (io, desc, seekaddr);
+			buf_bytes = iob->desc_read (io, desc, &sz);
+		}
 	}
+	if (!buf) buf = r_bin_buf_from_bytes (buf_bytes, sz);
 
 	if (!name) {
 		// XXX - for the time being this is fine, but we may want to change the name to something like
 		// <xtr_name>:<bin_type_name>
 		r_list_foreach (bin->binxtrs, it, xtr) {
-			if (xtr->check && xtr->check_bytes (buf_bytes, sz)) {
+			if (xtr->check && xtr->check_bytes (r_buf_buffer (buf), sz)) {
 				if (xtr && (xtr->extract_from_bytes || xtr->extractall_from_bytes)) {
 					if (is_debugger && sz != file_sz) {
-						free (buf_bytes);
+						r_buf_free (buf);
 						RIODesc *tdesc = iob->desc_open (io, desc->name, desc->flags, R_IO_READ);
 						if (!tdesc) return false;
 						sz = iob->desc_size (io, tdesc);
@@ -680,31 +723,30 @@ R_API int r_bin_load_io_at_offset_as_sz(RBin *bin, RIODesc *desc, ut64 baseaddr,
 							iob->desc_close (io, tdesc);
 							return false;
 						}
-						buf_bytes = iob->desc_read (io, tdesc, &sz);
+						buf = r_bin_buf_from_bytes (iob->desc_read (io, tdesc, &sz), sz);
 						iob->desc_close (io, tdesc);
 					} else if (sz != file_sz) {
-						free (buf_bytes);
-						buf_bytes = iob->desc_read (io, desc, &sz);
+						r_buf_free (buf);
+						buf = r_bin_buf_from_bytes (iob->desc_read (io, desc, &sz), sz);
 					}
 
-					binfile = r_bin_file_xtr_load_bytes (bin, xtr,
-						desc->name, buf_bytes, sz, file_sz,
+					binfile = r_bin_file_xtr_load_buffer (bin, xtr,
+						desc->name, buf, file_sz,
 						baseaddr, loadaddr, xtr_idx,
 						desc->fd, bin->rawstr);
+					buf = NULL;
+					break;
 				}
-				xtr = NULL;
 			}
 		}
 	}
 
 	if (!binfile) {
-		binfile = r_bin_file_new_from_bytes (bin, desc->name,
-			buf_bytes, sz, file_sz, bin->rawstr, baseaddr, loadaddr,
+		binfile = r_bin_file_new_from_buffer (bin, desc->name,
+			buf, file_sz, bin->rawstr, baseaddr, loadaddr,
 			desc->fd, name, NULL, offset);
 	}
 
-	free (buf_bytes);
-
 	if (binfile) return r_bin_file_set_cur_binfile (bin, binfile);
 	return false;
 }
@@ -812,6 +854,7 @@ static void r_bin_file_free (void /*RBinFile*/ *bf_) {
 		sdb_free (a->sdb_addrinfo);
 		a->sdb_addrinfo = NULL;
 	}
+	r_bin_addrlines_free (a->addrlines);
 	free (a->file);
 	r_list_free (a->objs);
 	memset (a, 0, sizeof (RBinFile));
@@ -824,9 +867,9 @@ static int r_bin_file_object_add (RBinFile *binfile, RBinObject *o) {
 	return true;
 }
 
-static RBinFile * r_bin_file_create_append (RBin *bin, const char *file, const ut8 * bytes, ut64 sz, ut64 file_sz, int rawstr, int fd, const char *xtrname) {
+static RBinFile * r_bin_file_create_append (RBin *bin, const char *file, RBuffer *buf, ut64 file_sz, int rawstr, int fd, const char *xtrname) {
 	RBinFile *bf = NULL;
-	bf = r_bin_file_new (bin, file, bytes, sz, file_sz, rawstr, fd, xtrname, bin->sdb);
+	bf = r_bin_file_new (bin, file, buf, file_sz, rawstr, fd, xtrname, bin->sdb);
 	if (bf) r_list_append (bin->binfiles, bf);
 	return bf;
 }
@@ -842,11 +885,19 @@ static int r_bin_files_populate_from_xtrlist (RBin *bin, RBinFile *binfile, ut64
 	return res;
 }
 
-static RBinFile * r_bin_file_xtr_load_bytes (RBin *bin, RBinXtrPlugin *xtr, const char *filename, const ut8 *bytes, ut64 sz, ut64 file_sz, ut64 baseaddr, ut64 loadaddr, int idx, int fd, int rawstr) {
+/* takes ownership of buf */
+static RBinFile * r_bin_file_xtr_load_buffer (RBin *bin, RBinXtrPlugin *xtr, const char *filename, RBuffer *buf, ut64 file_sz, ut64 baseaddr, ut64 loadaddr, int idx, int fd, int rawstr) {
 	RBinFile * bf = bin? r_bin_file_find_by_name (bin, filename) : NULL;
+	const ut8 *bytes = r_buf_buffer (buf);
+	ut64 sz = r_buf_size (buf);
+	RBuffer *unused = buf;
 	if (!bf) {
-		if (!bin) return NULL;
-		bf = r_bin_file_create_append (bin, filename, bytes, sz, file_sz, rawstr, fd, xtr->name);
+		if (!bin) {
+			r_buf_free (buf);
+			return NULL;
+		}
+		unused = NULL;
+		bf = r_bin_file_create_append (bin, filename, buf, file_sz, rawstr, fd, xtr->name);
 		if (!bf) return bf;
 	}
 	if (idx == 0 && xtr && bytes) {
@@ -870,6 +921,7 @@ static RBinFile * r_bin_file_xtr_load_bytes (RBin *bin, RBinXtrPlugin *xtr, cons
 		RBinObject *obj = r_list_get_n (bf->objs, 0);
 		r_bin_file_set_cur_binfile_obj (bf->rbin, bf, obj);
 	}
+	r_buf_free (unused);
 	return bf;
 }
 
@@ -1003,19 +1055,24 @@ static RBinObject * r_bin_object_new (RBinFile *binfile, RBinPlugin *plugin, ut6
 	return o;
 }
 
-static int r_bin_file_set_bytes (RBinFile *binfile, const ut8 * bytes, ut64 sz) {
-	if (!bytes) return false;
-	if (binfile->buf) r_buf_free (binfile->buf);
-	binfile->buf = r_buf_new ();
-	r_buf_set_bytes (binfile->buf, bytes, sz);
-	binfile->size = sz;
-	return true;
+/* wrap heap bytes in a buffer without copying them, takes ownership */
+static RBuffer * r_bin_buf_from_bytes (ut8 *bytes, ut64 sz) {
+	RBuffer *b;
+	if (!bytes) return NULL;
+	if (!(b = r_buf_new ())) {
+		free (bytes);
+		return NULL;
+	}
+	b->buf = bytes;
+	b->length = sz;
+	return b;
 }
 
-static RBinFile * r_bin_file_new (RBin *bin, const char *file, const ut8 * bytes, ut64 sz, ut64 file_sz, int rawstr, int fd, const char *xtrname, Sdb *sdb) {
+/* the file takes ownership of buf */
+static RBinFile * r_bin_file_new (RBin *bin, const char *file, RBuffer *buf, ut64 file_sz, int rawstr, int fd, const char *xtrname, Sdb *sdb) {
 	RBinFile *binfile = R_NEW0 (RBinFile);
 
-	r_bin_file_set_bytes (binfile, bytes, sz);
+	binfile->buf = buf;
 
 	binfile->rbin = bin;
 	binfile->file = strdup (file);
@@ -1074,24 +1131,27 @@ static int r_bin_file_object_new_from_xtr_data (RBin *bin, RBinFile *bf, ut64 ba
 	return true;
 }
 
-static RBinFile * r_bin_file_new_from_bytes (RBin *bin, const char *file, const ut8 * bytes, ut64 sz, ut64 file_sz, int rawstr, ut64 baseaddr,
+/* takes ownership of buf */
+static RBinFile * r_bin_file_new_from_buffer (RBin *bin, const char *file, RBuffer *buf, ut64 file_sz, int rawstr, ut64 baseaddr,
 		 ut64 loadaddr, int fd, const char *pluginname, const char *xtrname, ut64 offset) {
 	RBinPlugin *plugin = NULL;
 	RBinXtrPlugin *xtr = NULL;
 	RBinFile *bf = NULL;
 	RBinObject *o = NULL;
 	ut8 binfile_created = false;
+	const ut8 *bytes = r_buf_buffer (buf);
+	ut64 sz = r_buf_size (buf);
 
 	if (xtrname) xtr = r_bin_get_xtrplugin_by_name (bin, xtrname);
 
 	if (xtr && xtr->check && xtr->check_bytes (bytes, sz)) {
-		return r_bin_file_xtr_load_bytes (bin, xtr, file,
-			bytes, sz, file_sz, baseaddr, loadaddr, 0,
+		return r_bin_file_xtr_load_buffer (bin, xtr, file,
+			buf, file_sz, baseaddr, loadaddr, 0,
 			fd, rawstr);
 	}
 
 	if (!bf) {
-		bf = r_bin_file_create_append (bin, file, bytes, sz, file_sz, rawstr, fd, xtrname);
+		bf = r_bin_file_create_append (bin, file, buf, file_sz, rawstr, fd, xtrname);
 		if (!bf) return NULL;
 		binfile_created = true;
 	}
@@ -1162,6 +1222,7 @@ R_API void* r_bin_free(RBin *bin) {
 	r_list_free (bin->binxtrs);
 	r_list_free (bin->plugins);
 	sdb_free (bin->sdb);
+	r_bin_demangle_cache_free (bin->demangle_cache);
 	memset (bin, 0, sizeof (RBin));
 	free (bin);
 	return NULL;
@@ -1251,18 +1312,18 @@ R_API RList* r_bin_get_imports(RBin *bin) {
 }
 
 R_API RBinInfo* r_bin_get_info(RBin *bin) {
-	RBinObject *o = r_bin_cur_object (bin);
+	RBinObject *o = r_bin_cur_object_items (bin, R_BIN_ITEM_LANG);
 	return o ? o->info : NULL;
 }
 
 R_API RList* r_bin_get_libs(RBin *bin) {
-	RBinObject *o = r_bin_cur_object (bin);
+	RBinObject *o = r_bin_cur_object_items (bin, R_BIN_ITEM_LIBS);
 	if (o) return o->libs;
 	return NULL;
 }
 
 R_API RList* r_bin_get_relocs(RBin *bin) {
-	RBinObject *o = r_bin_cur_object (bin);
+	RBinObject *o = r_bin_cur_object_items (bin, R_BIN_ITEM_RELOCS);
 	if (o) return o->relocs;
 	return NULL;
 }
@@ -1303,6 +1364,7 @@ R_API RList* r_bin_reset_strings(RBin *bin) {
 		o->strings = NULL;
 	}
 
+	o->loaded |= R_BIN_ITEM_STRINGS;
 	if (bin->minstrlen <= 0)
 		return NULL;
 	a->rawstr = bin->rawstr;
@@ -1314,7 +1376,7 @@ R_API RList* r_bin_reset_strings(RBin *bin) {
 }
 
 R_API RList* r_bin_get_strings(RBin *bin) {
-	RBinObject *o = r_bin_cur_object (bin);
+	RBinObject *o = r_bin_cur_object_items (bin, R_BIN_ITEM_STRINGS);
 	return o? o->strings: NULL;
 }
 
@@ -1324,10 +1386,15 @@ R_API RList* r_bin_get_symbols(RBin *bin) {
 }
 
 R_API RList* r_bin_get_mem(RBin *bin) {
-	RBinObject *o = r_bin_cur_object (bin);
+	RBinObject *o = r_bin_cur_object_items (bin, R_BIN_ITEM_MEM);
 	return o? o->mem: NULL;
 }
 
+R_API RList* r_bin_get_lines(RBin *bin) {
+	RBinObject *o = r_bin_cur_object_items (bin, R_BIN_ITEM_LINES);
+	return o? o->lines: NULL;
+}
+
 R_API int r_bin_is_big_endian (RBin *bin) {
 	RBinObject *o = r_bin_cur_object (bin);
 	return o? o->info->big_endian: false;
@@ -1339,7 +1406,7 @@ R_API int r_bin_is_stripped (RBin *bin) {
 }
 
 R_API int r_bin_is_static (RBin *bin) {
-	RBinObject *o = r_bin_cur_object (bin);
+	RBinObject *o = r_bin_cur_object_items (bin, R_BIN_ITEM_LIBS);
 	if (o && r_list_length (o->libs)>0)
 		return R_BIN_DBG_STATIC & o->info->dbg_info;
 	return true;
@@ -1368,6 +1435,7 @@ R_API RBin* r_bin_new() {
 	if (!bin) return NULL;
 	bin->force = NULL;
 	bin->sdb = sdb_new0 ();
+	bin->demangle_cache = r_bin_demangle_cache_new ();
 	bin->cb_printf = (PrintfCallback)printf;
 	bin->plugins = r_list_new();
 	bin->plugins->free = free;
@@ -1398,7 +1466,7 @@ R_API int r_bin_use_arch(RBin *bin, const char *arch, int bits, const char *name
 		if (plugin) {
 			if (bin->cur)
 				bin->cur->curplugin = plugin;
-			binfile = r_bin_file_new (bin, "-", NULL, 0, 0, 0, 999, NULL, NULL);
+			binfile = r_bin_file_new (bin, "-", NULL, 0, 0, 999, NULL, NULL);
 			// create object and set arch/bits
 			obj = r_bin_object_new (binfile, plugin, 0, 0, 0, 1024);
 			binfile->o = obj;
@@ -1710,7 +1778,7 @@ R_API RBinObject *r_bin_get_object(RBin *bin) {
 }
 
 R_API RList* /*<RBinClass>*/r_bin_get_classes(RBin *bin) {
-	RBinObject *o = r_bin_cur_object (bin);
+	RBinObject *o = r_bin_cur_object_items (bin, R_BIN_ITEM_CLASSES | R_BIN_ITEM_LANG);
 	if (o) return o->classes;
 	return NULL;
 }
@@ -54,3 +54,183 @@ R_API char *r_bin_addr2fileline(RBin *bin, ut64 addr) {
 	}
 	return out;
 }
+
+R_API RBinAddrlines *r_bin_addrlines_new() {
+	RBinAddrlines *al = R_NEW0 (RBinAddrlines);
+	if (!al) return NULL;
+	al->ht = r_hashtable64_new ();
+	if (!al->ht) {
+		free (al);
+		return NULL;
+	}
+	return al;
+}
+
+R_API void r_bin_addrlines_reset(RBinAddrlines *al) {
+	int i;
+	if (!al) return;
+	for (i = 0; i < al->nfiles; i++) {
+		free (al->files[i]);
+		free (al->paths[i]);
+	}
+	R_FREE (al->files);
+	R_FREE (al->paths);
+	R_FREE (al->rows);
+	R_FREE (al->sorted);
+	al->nfiles = al->count = al->size = 0;
+	al->exported = 0;
+	r_hashtable64_free (al->ht);
+	al->ht = r_hashtable64_new ();
+}
+
+R_API void r_bin_addrlines_free(RBinAddrlines *al) {
+	if (!al) return;
+	r_bin_addrlines_reset (al);
+	r_hashtable64_free (al->ht);
+	free (al);
+}
+
+/* index of the file with the given path, the name shown is the full
+ * path when it exists or the basename, so each path is checked once */
+R_API int r_bin_addrlines_file(RBinAddrlines *al, const char *path) {
+	ut64 hash;
+	const char *p;
+	int i;
+	char **tmp;
+
+	if (!al || !al->ht || !path)
+		return -1;
+	hash = r_str_hash64 (path);
+	i = (int)(size_t)r_hashtable64_lookup (al->ht, hash) - 1;
+	if (i >= 0 && strcmp (al->paths[i], path)) {
+		// hash collision, the table keeps the first one
+		for (i = 0; i < al->nfiles; i++) {
+			if (!strcmp (al->paths[i], path))
+				break;
+		}
+		if (i == al->nfiles)
+			i = -1;
+	}
+	if (i >= 0)
+		return i;
+	if (!(al->nfiles & 63)) {
+		tmp = realloc (al->files, (al->nfiles + 64) * sizeof (char*));
+		if (!tmp) return -1;
+		al->files = tmp;
+		tmp = realloc (al->paths, (al->nfiles + 64) * sizeof (char*));
+		if (!tmp) return -1;
+		al->paths = tmp;
+	}
+	if (r_file_exists (path)) {
+		p = path;
+	} else {
+		p = r_str_rchr (path, NULL, '/');
+		p = p? p + 1: path;
+	}
+	i = al->nfiles++;
+	al->files[i] = strdup (p);
+	al->paths[i] = strdup (path);
+	if (!r_hashtable64_lookup (al->ht, hash))
+		r_hashtable64_insert (al->ht, hash, (void*)(size_t)(i + 1));
+	return i;
+}
+
+R_API int r_bin_addrlines_add(RBinAddrlines *al, ut64 addr, int file, ut32 line) {
+	RBinAddrline *row;
+	if (!al || file < 0 || file >= al->nfiles)
+		return false;
+	if (al->count == al->size) {
+		int size = al->size? al->size * 2: 1024;
+		row = realloc (al->rows, size * sizeof (RBinAddrline));
+		if (!row) return false;
+		al->rows = row;
+		al->size = size;
+	}
+	row = &al->rows[al->count++];
+	row->addr = addr;
+	row->file = file;
+	row->line = line;
+	R_FREE (al->sorted);
+	return true;
+}
+
+typedef struct {
+	ut64 addr;
+	ut32 idx;
+} AddrIdx;
+
+static int addridx_cmp(const void *a, const void *b) {
+	const AddrIdx *x = a, *y = b;
+	if (x->addr != y->addr)
+		return (x->addr < y->addr)? -1: 1;
+	return (x->idx < y->idx)? -1: (x->idx > y->idx);
+}
+
+/* sort the row indexes by address, rows for the same address are kept
+ * in parse order so the last one is the one in effect */
+R_API int r_bin_addrlines_sort(RBinAddrlines *al) {
+	AddrIdx *tmp;
+	int i;
+	if (!al) return false;
+	if (al->sorted || !al->count)
+		return true;
+	tmp = malloc (al->count * sizeof (AddrIdx));
+	al->sorted = malloc (al->count * sizeof (ut32));
+	if (!tmp || !al->sorted) {
+		free (tmp);
+		R_FREE (al->sorted);
+		return false;
+	}
+	for (i = 0; i < al->count; i++) {
+		tmp[i].addr = al->rows[i].addr;
+		tmp[i].idx = i;
+	}
+	qsort (tmp, al->count, sizeof (AddrIdx), addridx_cmp);
+	for (i = 0; i < al->count; i++) {
+		al->sorted[i] = tmp[i].idx;
+	}
+	free (tmp);
+	return true;
+}
+
+/* last row parsed for exactly this address */
+R_API RBinAddrline *r_bin_addrlines_get(RBinAddrlines *al, ut64 addr) {
+	int lo = 0, hi, mid;
+	if (!al || !al->count || !r_bin_addrlines_sort (al))
+		return NULL;
+	hi = al->count;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (al->rows[al->sorted[mid]].addr <= addr) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	if (lo && al->rows[al->sorted[lo - 1]].addr == addr)
+		return &al->rows[al->sorted[lo - 1]];
+	return NULL;
+}
+
+/* copy the rows to the sdb_addrinfo namespace, which is used from then
+ * on so the CL commands can change it */
+R_API void r_bin_addrlines_sync(RBinFile *bf) {
+	RBinAddrlines *al = bf? bf->addrlines: NULL;
+	char fileline[1024], offset[64], *offset_ptr;
+	Sdb *s = bf? bf->sdb_addrinfo: NULL;
+	if (!al || !s)
+		return;
+	for (; al->exported < al->count; al->exported++) {
+		RBinAddrline *row = &al->rows[al->exported];
+		snprintf (fileline, sizeof (fileline), "%s|%d",
+			al->files[row->file], (int)row->line);
+		offset_ptr = sdb_itoa (row->addr, offset, 16);
+		if (!sdb_add (s, offset_ptr, fileline, 0)) {
+			sdb_set (s, offset_ptr, fileline, 0);
+		}
+		if (!sdb_add (s, fileline, offset_ptr, 0)) {
+			sdb_set (s, fileline, offset_ptr, 0);
+		}
+	}
+	al->synced = true;
+}
@@ -329,6 +329,7 @@ R_API int r_bin_lang_type(RBinFile *binfile, const char *def) {
 	if (plugin && plugin->demangle_type)
 		type = plugin->demangle_type (def);
 	else {
+		r_bin_object_load_items (binfile, binfile->o, R_BIN_ITEM_LANG);
 		if (binfile->o && binfile->o->info) {
 			type = r_bin_demangle_type (binfile->o->info->lang);
 		}
@@ -338,9 +339,76 @@ R_API int r_bin_lang_type(RBinFile *binfile, const char *def) {
 	return type;
 }
 
-R_API char *r_bin_demangle (RBinFile *binfile, const char *def, const char *str) {
-	RBin *bin = binfile->rbin;
-	int type = r_bin_lang_type (binfile, def);
+#define DEMANGLE_THREADS 4
+#define DEMANGLE_THREAD_MIN 4096
+
+enum { EMPTY, BATCH, READY };
+
+typedef struct demangled_t {
+	int type;
+	int len;
+	int state;       // EMPTY, BATCH while a batch worker fills it, READY
+	char *out;       // NULL if the name can not be demangled
+	struct demangled_t *next;
+	char name[1];
+} Demangled;
+
+typedef struct {
+	RBin *bin;
+	int type;
+	Demangled **items;
+	int n;
+} DemangleJob;
+
+R_API RBinDemangleCache *r_bin_demangle_cache_new() {
+	RBinDemangleCache *dc = R_NEW0 (RBinDemangleCache);
+	if (!dc) return NULL;
+	dc->ht = r_hashtable64_new ();
+	dc->lock = r_th_lock_new ();
+	if (!dc->ht || !dc->lock) {
+		r_bin_demangle_cache_free (dc);
+		return NULL;
+	}
+	return dc;
+}
+
+R_API void r_bin_demangle_cache_free(RBinDemangleCache *dc) {
+	RHashTable64Entry *e;
+	Demangled *d, *next;
+	ut64 i;
+	if (!dc) return;
+	if (dc->ht) {
+		// nothing is ever removed, so all the used slots hold a chain
+		for (i = 0; i < dc->ht->size; i++) {
+			e = &dc->ht->table[i];
+			if (!e->data)
+				continue;
+			for (d = e->data; d; d = next) {
+				next = d->next;
+				free (d->out);
+				free (d);
+			}
+		}
+		r_hashtable64_free (dc->ht);
+	}
+	if (dc->lock)
+		r_th_lock_free (dc->lock);
+	free (dc);
+}
+
+/* only the demanglers that keep no state can run on the batch workers */
+static int demangle_reentrant(int type) {
+	switch (type) {
+	case R_BIN_NM_JAVA:
+	case R_BIN_NM_RUST:
+	case R_BIN_NM_CXX:
+	case R_BIN_NM_OBJC:
+		return true;
+	}
+	return false;
+}
+
+static char *demangle_type(RBin *bin, int type, const char *str) {
 	switch (type) {
 	case R_BIN_NM_JAVA: return r_bin_demangle_java (str);
 	/* rust uses the same mangling as c++ and appends a uniqueid */
@@ -353,6 +421,167 @@ R_API char *r_bin_demangle (RBinFile *binfile, const char *def, const char *str)
 	return NULL;
 }
 
+/* mangled c++ names are long, so hash them 8 bytes at a time */
+static ut64 name_hash(const char *str, int len) {
+	ut64 v, h = 0xcbf29ce484222325ULL ^ len;
+	int i;
+	for (i = 0; i + 8 <= len; i += 8) {
+		memcpy (&v, str + i, sizeof (v));
+		h = (h ^ v) * 0x100000001b3ULL;
+		h ^= h >> 29;
+	}
+	for (; i < len; i++) {
+		h = (h ^ (ut8)str[i]) * 0x100000001b3ULL;
+	}
+	return h ^ (h >> 32);
+}
+
+/* the entry for type and str, called with the lock held. Adds an empty
+ * one when missing and add is set */
+static Demangled *cache_get(RBinDemangleCache *dc, int type, const char *str, int add) {
+	int len = strlen (str);
+	ut64 hash = name_hash (str, len);
+	Demangled *d, *head = r_hashtable64_lookup (dc->ht, hash);
+	for (d = head; d; d = d->next) {
+		if (d->type == type && d->len == len && !memcmp (d->name, str, len))
+			return d;
+	}
+	if (!add) return NULL;
+	d = malloc (sizeof (Demangled) + len);
+	if (!d) return NULL;
+	d->type = type;
+	d->len = len;
+	d->state = EMPTY;
+	d->out = NULL;
+	memcpy (d->name, str, len + 1);
+	if (head) {
+		d->next = head->next;
+		head->next = d;
+	} else {
+		d->next = NULL;
+		r_hashtable64_insert (dc->ht, hash, d);
+	}
+	dc->count++;
+	return d;
+}
+
+static char *demangle_cached(RBin *bin, int type, const char *str) {
+	RBinDemangleCache *dc = bin? bin->demangle_cache: NULL;
+	Demangled *d;
+	char *out;
+	if (type == R_BIN_NM_NONE)
+		return NULL;
+	if (!dc)
+		return demangle_type (bin, type, str);
+	r_th_lock_enter (dc->lock);
+	d = cache_get (dc, type, str, false);
+	if (d && d->state == READY) {
+		out = d->out? strdup (d->out): NULL;
+		r_th_lock_leave (dc->lock);
+		return out;
+	}
+	r_th_lock_leave (dc->lock);
+	out = demangle_type (bin, type, str);
+	r_th_lock_enter (dc->lock);
+	d = cache_get (dc, type, str, true);
+	if (d && d->state == EMPTY) {
+		d->out = out? strdup (out): NULL;
+		d->state = READY;
+	}
+	r_th_lock_leave (dc->lock);
+	return out;
+}
+
+R_API char *r_bin_demangle (RBinFile *binfile, const char *def, const char *str) {
+	RBin *bin = binfile->rbin;
+	int type = r_bin_lang_type (binfile, def);
+	if (!str)
+		return NULL;
+	return demangle_cached (bin, type, str);
+}
+
+static int demangle_threads() {
+#if __UNIX__ && defined(_SC_NPROCESSORS_ONLN)
+	int n = (int)sysconf (_SC_NPROCESSORS_ONLN);
+	return R_MAX (1, R_MIN (n, DEMANGLE_THREADS));
+#else
+	return DEMANGLE_THREADS;
+#endif
+}
+
+static void demangle_items(RBin *bin, int type, Demangled **items, int n) {
+	int i;
+	for (i = 0; i < n; i++) {
+		items[i]->out = demangle_type (bin, type, items[i]->name);
+	}
+}
+
+static int demangle_th(RThread *th) {
+	DemangleJob *job = th->user;
+	demangle_items (job->bin, job->type, job->items, job->n);
+	return false;
+}
+
+/* fill the cache with the demangled names of a symbol list, splitting
+ * the work over a few threads for the demanglers that allow it. On a
+ * single thread this is only an extra pass, so the names are left to
+ * r_bin_demangle(). Returns the number of names demangled here */
+R_API int r_bin_demangle_symbols(RBinFile *binfile, const char *def, RList *symbols) {
+	RBin *bin = binfile? binfile->rbin: NULL;
+	RBinDemangleCache *dc = bin? bin->demangle_cache: NULL;
+	DemangleJob jobs[DEMANGLE_THREADS];
+	RThread *th[DEMANGLE_THREADS];
+	Demangled **items, *d;
+	RBinSymbol *sym;
+	RListIter *iter;
+	int i, type, n = 0, njobs = 1, nth = 0;
+
+	if (!dc || !symbols)
+		return 0;
+	type = r_bin_lang_type (binfile, def);
+	if (type == R_BIN_NM_NONE || !demangle_reentrant (type))
+		return 0;
+	if (demangle_threads () < 2 || r_list_length (symbols) < DEMANGLE_THREAD_MIN)
+		return 0;
+	items = malloc (sizeof (Demangled*) * (r_list_length (symbols) + 1));
+	if (!items)
+		return 0;
+	r_th_lock_enter (dc->lock);
+	r_list_foreach (symbols, iter, sym) {
+		d = cache_get (dc, type, sym->name, true);
+		if (d && d->state == EMPTY) {
+			d->state = BATCH;
+			items[n++] = d;
+		}
+	}
+	r_th_lock_leave (dc->lock);
+	if (n >= DEMANGLE_THREAD_MIN)
+		njobs = demangle_threads ();
+	for (i = 0; i < njobs; i++) {
+		jobs[i].bin = bin;
+		jobs[i].type = type;
+		jobs[i].items = items + (n * i / njobs);
+		jobs[i].n = (n * (i + 1) / njobs) - (n * i / njobs);
+	}
+	for (i = 1; i < njobs; i++) {
+		th[nth] = r_th_new (demangle_th, &jobs[i], 0);
+		if (th[nth]) nth++;
+		else demangle_items (bin, type, jobs[i].items, jobs[i].n);
+	}
+	demangle_items (bin, type, jobs[0].items, jobs[0].n);
+	for (i = 0; i < nth; i++) {
+		r_th_wait (th[i]);
+		r_th_free (th[i]);
+	}
+	r_th_lock_enter (dc->lock);
+	for (i = 0; i < n; i++) {
+		items[i]->state = READY;
+	}
+	r_th_lock_leave (dc->lock);
+	free (items);
+	return n;
+}
+
 #ifdef TEST
 main() {
 	char *out, str[128];
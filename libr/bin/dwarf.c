@@ -364,37 +364,28 @@ beach:
 	return buf;
 }
 
-static inline void add_sdb_addrline(Sdb *s, ut64 addr, const char *file, ut64 line, FILE *f, int mode) {
+static inline void add_addrline(RBinFile *bf, const RBinDwarfLNPHeader *hdr,
+		const RBinDwarfSMRegisters *regs, FILE *f, int mode) {
+	const file_entry *fe;
 	const char *p;
-	char fileline[128];
-	char offset[64];
-	char *offset_ptr;
+	int idx = regs->file - 1;
 
-	if (!s || !file)
+	if (!bf->addrlines || !hdr->file_names || idx < 0 || idx >= hdr->file_names_count)
+		return;
+	fe = &hdr->file_names[idx];
+	if (!fe->name)
 		return;
-	p = r_str_rchr (file, NULL, '/');
-	if (p) p++; else p = file;
-	// includedirs and properly check full paths
 	switch (mode) {
 	case 1:
 	case 'r':
 	case '*':
+		p = r_str_rchr (fe->name, NULL, '/');
+		if (p) p++; else p = fe->name;
 		if (!f) f = stdout;
-		fprintf (f, "CL %s:%d 0x%08"PFMT64x"\n", p, (int)line, addr);
+		fprintf (f, "CL %s:%d 0x%08"PFMT64x"\n", p, (int)regs->line, regs->address);
 		break;
 	}
-	if (r_file_exists (file))
-		p = file;
-	snprintf (fileline, sizeof (fileline) - 1, "%s|%"PFMT64d, p, line);
-	offset_ptr = sdb_itoa (addr, offset, 16);
-
-	if (!sdb_add (s, offset_ptr, fileline, 0)) {
-		sdb_set (s, offset_ptr, fileline, 0);
-	}
-
-	if (!sdb_add (s, fileline, offset_ptr, 0)) {
-		sdb_set (s, fileline, offset_ptr, 0);
-	}
+	r_bin_addrlines_add (bf->addrlines, regs->address, fe->file_id, regs->line);
 }
 
 static const ut8* r_bin_dwarf_parse_ext_opcode(const RBin *a, const ut8 *obuf,
@@ -427,13 +418,7 @@ static const ut8* r_bin_dwarf_parse_ext_opcode(const RBin *a, const ut8 *obuf,
 	case DW_LNE_end_sequence:
 		regs->end_sequence = DWARF_TRUE;
 
-		if (binfile && binfile->sdb_addrinfo && hdr->file_names) {
-			int fnidx = regs->file - 1;
-			if (fnidx>=0 && fnidx<hdr->file_names_count) {
-				add_sdb_addrline(binfile->sdb_addrinfo, regs->address,
-						hdr->file_names[fnidx].name, regs->line, f, mode);
-			}
-		}
+		add_addrline (binfile, hdr, regs, f, mode);
 
 		if (f) {
 			fprintf(f, "End of Sequence\n");
@@ -510,14 +495,7 @@ static const ut8* r_bin_dwarf_parse_spec_opcode(
 			advance_adr, regs->address, hdr->line_base +
 			(adj_opcode % hdr->line_range), regs->line);
 	}
-	if (binfile && binfile->sdb_addrinfo && hdr->file_names) {
-		int idx = regs->file -1;
-		if (idx>=0 && idx<hdr->file_names_count) {
-			add_sdb_addrline (binfile->sdb_addrinfo, regs->address,
-					hdr->file_names[idx].name,
-					regs->line, f, mode);
-		}
-	}
+	add_addrline (binfile, hdr, regs, f, mode);
 	regs->basic_block = DWARF_FALSE;
 	regs->prologue_end = DWARF_FALSE;
 	regs->epilogue_begin = DWARF_FALSE;
@@ -547,15 +525,7 @@ static const ut8* r_bin_dwarf_parse_std_opcode(
 			fprintf(f, "Copy\n");
 		}
 
-		if (binfile && binfile->sdb_addrinfo && hdr->file_names) {
-			int fnidx = regs->file - 1;
-			if (fnidx>=0 && fnidx<hdr->file_names_count) {
-				add_sdb_addrline(binfile->sdb_addrinfo,
-					regs->address,
-					hdr->file_names[fnidx].name,
-					regs->line, f, mode);
-			}
-		}
+		add_addrline (binfile, hdr, regs, f, mode);
 		regs->basic_block = DWARF_FALSE;
 		break;
 	case DW_LNS_advance_pc:
@@ -694,7 +664,7 @@ R_API int r_bin_dwarf_parse_line_raw2(const RBin *a, const ut8 *obuf,
 	RBinDwarfLNPHeader hdr;
 	const ut8 *buf = NULL, *buf_tmp = NULL, *buf_end = NULL;
 	RBinDwarfSMRegisters regs;
-	int tmplen;
+	int i, tmplen;
 	FILE *f = NULL;
 	RBinFile *binfile = a ? a->cur : NULL;
 
@@ -704,23 +674,42 @@ R_API int r_bin_dwarf_parse_line_raw2(const RBin *a, const ut8 *obuf,
 		f = stdout;
 	}
 
+	if (!binfile->addrlines) {
+		binfile->addrlines = r_bin_addrlines_new ();
+	} else {
+		r_bin_addrlines_reset (binfile->addrlines);
+	}
+
 	buf = obuf;
 	buf_end = obuf + len;
 	while (buf+1 < buf_end) {
 		buf_tmp = buf;
 		buf = r_bin_dwarf_parse_lnp_header (a->cur, buf, buf_end, &hdr, f, mode);
-		if (!buf) return false;
+		if (!buf) break;
+		for (i = 0; i < hdr.file_names_count; i++) {
+			hdr.file_names[i].file_id = r_bin_addrlines_file (
+				binfile->addrlines, hdr.file_names[i].name);
+		}
 		r_bin_dwarf_set_regs_default (&hdr, &regs);
 		//tmplen = R_MIN (len-(buf_end-buf)-1, 4+hdr.unit_length.part1);
 		tmplen = (int)(buf_end - buf);
 		tmplen = R_MIN (tmplen, 4+hdr.unit_length.part1);
+		if (tmplen>0) {
+			r_bin_dwarf_parse_opcodes (a, buf, tmplen, &hdr, &regs, f, mode);
+		}
+		for (i = 0; i < hdr.file_names_count; i++) {
+			free (hdr.file_names[i].name);
+		}
+		free (hdr.file_names);
+		free (hdr.std_opcode_lengths);
 		if (tmplen<1) break;
-		r_bin_dwarf_parse_opcodes (a, buf, tmplen, &hdr, &regs, f, mode);
 		buf = buf_tmp + tmplen;
 		len = (int)(buf_end - buf);
 	}
-
-	return true;
+	if (binfile->addrlines && binfile->addrlines->synced) {
+		r_bin_addrlines_sync (binfile);
+	}
+	return buf != NULL;
 }
 
 #define READ_BUF(x,y) if (idx+sizeof(y)>=len) { return false;} \
@@ -1514,6 +1503,44 @@ static void r_bin_dwarf_row_free (void *p) {
 	free (row);
 }
 
+typedef struct {
+	ut32 first, last;
+} RowSpan;
+
+static int rowspan_cmp(const void *a, const void *b) {
+	const RowSpan *x = a, *y = b;
+	return (x->first < y->first)? -1: (x->first > y->first);
+}
+
+/* one row per address, in the order the addresses first show up and
+ * with the file and line of the last row parsed for it */
+static void r_bin_dwarf_add_rows(RList *list, RBinAddrlines *al) {
+	RowSpan *spans;
+	int i, n = 0;
+
+	if (!al || !r_bin_addrlines_sort (al) || !al->count)
+		return;
+	spans = malloc (al->count * sizeof (RowSpan));
+	if (!spans) return;
+	for (i = 0; i < al->count; i++) {
+		ut32 idx = al->sorted[i];
+		if (n && al->rows[spans[n - 1].last].addr == al->rows[idx].addr) {
+			spans[n - 1].last = idx;
+		} else {
+			spans[n].first = spans[n].last = idx;
+			n++;
+		}
+	}
+	qsort (spans, n, sizeof (RowSpan), rowspan_cmp);
+	for (i = 0; i < n; i++) {
+		RBinAddrline *al_row = &al->rows[spans[i].last];
+		RBinDwarfRow *row = r_bin_dwarf_row_new (al_row->addr,
+			al->files[al_row->file], (int)al_row->line, 0);
+		if (row) r_list_append (list, row);
+	}
+	free (spans);
+}
+
 R_API RList *r_bin_dwarf_parse_line(RBin *a, int mode) {
 	ut8 *buf;
 	RList *list = NULL;
@@ -1534,26 +1561,7 @@ R_API RList *r_bin_dwarf_parse_line(RBin *a, int mode) {
 		list = r_list_new (); // always return empty list wtf
 		list->free = r_bin_dwarf_row_free;
 		r_bin_dwarf_parse_line_raw2 (a, buf, len, mode);
-		// k bin/cur/addrinfo/*
-		SdbListIter *iter;
-		SdbKv *kv;
-		ls_foreach (binfile->sdb_addrinfo->ht->list, iter, kv) {
-			if (!strncmp (kv->key, "0x", 2)) {
-				ut64 addr;
-				RBinDwarfRow *row;
-				int line;
-				char *file = strdup (kv->value);
-				char *tok = strchr (file, '|');
-				if (tok) {
-					*tok++ = 0;
-					line = atoi (tok);
-					addr = r_num_math (NULL, kv->key);
-					row = r_bin_dwarf_row_new (addr, file, line, 0);
-					r_list_append (list, row);
-				}
-				free (file);
-			}
-		}
+		r_bin_dwarf_add_rows (list, binfile->addrlines);
 		free (buf);
 	}
 	return list;
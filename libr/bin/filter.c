@@ -41,49 +41,191 @@ R_API void r_bin_filter_name(Sdb *db, ut64 vaddr, char *name, int maxlen) {
 	}
 }
 
+/* r_bin_filter_name() without the Sdb. The names seen so far are counted
+ * in an open addressing table and the (name, vaddr) pairs already renamed
+ * in another one. Names are compared in full, so different names never
+ * share a counter; they are copied to a pool because the symbols are
+ * renamed in place */
+typedef struct {
+	ut64 vaddr; // pairs only
+	ut32 hash;
+	ut32 name; // offset of the name in the pool
+	ut32 count; // 0 for empty slots
+} FilterSlot;
+
+typedef struct {
+	FilterSlot *slots;
+	ut32 mask;
+	ut32 used;
+} FilterTable;
+
+typedef struct {
+	FilterTable names;
+	FilterTable pairs;
+	RStrpool *pool;
+} Filter;
+
+static int table_init(FilterTable *t, int n) {
+	ut32 size = 64;
+	while (size < (ut32)n * 4 && size < 0x40000000)
+		size <<= 1;
+	t->slots = calloc (size, sizeof (FilterSlot));
+	t->mask = size - 1;
+	t->used = 0;
+	return t->slots != NULL;
+}
+
+static inline ut32 table_index(FilterTable *t, ut32 hash) {
+	ut32 i = hash * 0x9e3779b1U;
+	return (i ^ (i >> 16)) & t->mask;
+}
+
+/* keeps the load under a half so the lookups always end in a free slot */
+static int table_reserve(FilterTable *t) {
+	FilterSlot *slots = t->slots;
+	ut32 i, j, mask = t->mask;
+	if (t->used * 2 < t->mask)
+		return true;
+	t->slots = calloc ((size_t)(mask + 1) * 2, sizeof (FilterSlot));
+	if (!t->slots) {
+		t->slots = slots;
+		return false;
+	}
+	t->mask = (mask << 1) | 1;
+	for (i = 0; i <= mask; i++) {
+		if (!slots[i].count)
+			continue;
+		for (j = table_index (t, slots[i].hash); t->slots[j].count; j = (j + 1) & t->mask);
+		t->slots[j] = slots[i];
+	}
+	free (slots);
+	return true;
+}
+
+static FilterSlot *name_slot(Filter *f, ut32 hash, const char *name) {
+	FilterTable *t = &f->names;
+	ut32 i = table_index (t, hash);
+	for (; t->slots[i].count; i = (i + 1) & t->mask) {
+		FilterSlot *s = t->slots + i;
+		if (s->hash == hash && !strcmp (r_strpool_get (f->pool, s->name), name))
+			break;
+	}
+	return t->slots + i;
+}
+
+static FilterSlot *pair_slot(Filter *f, ut32 hash, ut32 name, ut64 vaddr) {
+	FilterTable *t = &f->pairs;
+	ut32 i = table_index (t, hash);
+	for (; t->slots[i].count; i = (i + 1) & t->mask) {
+		FilterSlot *s = t->slots + i;
+		if (s->name == name && s->vaddr == vaddr)
+			break;
+	}
+	return t->slots + i;
+}
+
+static int filter_init(Filter *f, int n) {
+	f->pool = r_strpool_new (0);
+	if (f->pool && table_init (&f->names, n)) {
+		if (table_init (&f->pairs, n))
+			return true;
+		free (f->names.slots);
+	}
+	r_strpool_free (f->pool);
+	return false;
+}
+
+static void filter_fini(Filter *f) {
+	free (f->names.slots);
+	free (f->pairs.slots);
+	r_strpool_free (f->pool);
+}
+
+static void filter_name(Filter *f, ut64 vaddr, char *name, int maxlen) {
+	ut32 hash = sdb_hash (name), phash, count, id;
+	FilterSlot *s;
+	if (!table_reserve (&f->names) || !table_reserve (&f->pairs))
+		return;
+	s = name_slot (f, hash, name);
+	if (!s->count) {
+		int off = r_strpool_append (f->pool, name);
+		if (off < 0)
+			return;
+		s->hash = hash;
+		s->name = off;
+		f->names.used++;
+	}
+	count = ++s->count;
+	id = s->name;
+	phash = hash ^ (ut32)vaddr ^ (ut32)(vaddr >> 32);
+	s = pair_slot (f, phash, id, vaddr);
+	if (s->count) {
+		// TODO: symbol is dupped, so symbol can be removed!
+		return;
+	}
+	s->vaddr = vaddr;
+	s->hash = phash;
+	s->name = id;
+	s->count = 1;
+	f->pairs.used++;
+	if (vaddr) {
+		hashify (name, vaddr);
+	}
+	if (count>1) {
+		int namelen = strlen (name);
+		if (namelen>maxlen) {
+			name[maxlen] = 0;
+			namelen = maxlen;
+		}
+		snprintf (name + namelen, 16, "_%d", count-1);
+	}
+}
+
 R_API void r_bin_filter_symbols (RList *list) {
 	RBinSymbol *sym;
 	const int maxlen = sizeof (sym->name)-8;
-	Sdb *db = sdb_new0 ();
-	RListIter *iter, *iter2;
-	if (maxlen>0) {
-		r_list_foreach_safe (list, iter, iter2, sym) {
-			r_bin_filter_name (db, sym->vaddr, sym->name, maxlen);
-		}
-	} else eprintf ("SymbolName is not dynamic\n");
-	sdb_free (db);
+	RListIter *iter;
+	Filter f;
+	if (!filter_init (&f, r_list_length (list)))
+		return;
+	r_list_foreach (list, iter, sym) {
+		filter_name (&f, sym->vaddr, sym->name, maxlen);
+	}
+	filter_fini (&f);
 }
 
 R_API void r_bin_filter_sections (RList *list) {
 	RBinSection *sec;
 	const int maxlen = sizeof (sec->name)-8;
-	Sdb *db = sdb_new0 ();
 	RListIter *iter;
-	if (maxlen>0) {
-		r_list_foreach (list, iter, sec) {
-			r_bin_filter_name (db, sec->vaddr, sec->name, maxlen);
-		}
-	} else eprintf ("SectionName is not dynamic\n");
-	sdb_free (db);
+	Filter f;
+	if (!filter_init (&f, r_list_length (list)))
+		return;
+	r_list_foreach (list, iter, sec) {
+		filter_name (&f, sec->vaddr, sec->name, maxlen);
+	}
+	filter_fini (&f);
 }
 
 R_API void r_bin_filter_classes (RList *list) {
-	Sdb *db = sdb_new0 ();
 	RListIter *iter, *iter2;
+	Filter f;
 	RBinClass *cls;
 	RBinSymbol *sym;
+	if (!filter_init (&f, r_list_length (list)))
+		return;
 	r_list_foreach (list, iter, cls) {
 		int namepad_len = strlen (cls->name)+32;
 		char *namepad = malloc (namepad_len);
 		if (namepad) {
 			strcpy (namepad, cls->name);
-			r_bin_filter_name (db, cls->index, namepad, namepad_len);
+			filter_name (&f, cls->index, namepad, namepad_len);
 			free (cls->name);
 			cls->name = namepad;
 			r_list_foreach (cls->methods, iter2, sym) {
-				r_bin_filter_name (db, sym->vaddr, sym->name, sizeof (sym->name));
+				filter_name (&f, sym->vaddr, sym->name, sizeof (sym->name));
 			}
 		} else eprintf ("Cannot alloc %d bytes\n", namepad_len);
 	}
-	sdb_free (db);
+	filter_fini (&f);
 }
@@ -748,9 +748,9 @@ struct MACH0_(obj_t)* MACH0_(new_buf)(RBuffer *buf) {
 	struct MACH0_(obj_t) *bin = R_NEW0 (struct MACH0_(obj_t));
 	if (!bin) return NULL;
 	bin->kv = sdb_new (NULL, "bin.mach0", 0);
-	bin->b = r_buf_new ();
+	bin->b = r_buf_new_with_pointers (buf->buf, buf->length);
 	bin->size = buf->length;
-	if (!r_buf_set_bytes (bin->b, buf->buf, bin->size)){
+	if (!bin->b || !bin->b->buf) {
 		return MACH0_(mach0_free) (bin);
 	}
 	if (!init(bin))
@@ -2412,9 +2412,9 @@ struct PE_(r_bin_pe_obj_t)* PE_(r_bin_pe_new_buf)(struct r_buf_t *buf) {
 	struct PE_(r_bin_pe_obj_t) *bin = R_NEW0 (struct PE_(r_bin_pe_obj_t));
 	if (!bin) return NULL;
 	bin->kv = sdb_new0 ();
-	bin->b = r_buf_new ();
+	bin->b = r_buf_new_with_pointers (buf->buf, buf->length);
 	bin->size = buf->length;
-	if (!r_buf_set_bytes (bin->b, buf->buf, bin->size)){
+	if (!bin->b || !bin->b->buf) {
 		return PE_(r_bin_pe_free)(bin);
 	}
 	if (!bin_pe_init(bin))
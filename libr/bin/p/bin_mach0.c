@@ -23,8 +23,7 @@ static void * load_bytes(RBinFile *arch, const ut8 *buf, ut64 sz, ut64 loadaddr,
 	struct MACH0_(obj_t) *res = NULL;
 	RBuffer *tbuf = NULL;
 	if (!buf || sz == 0 || sz == UT64_MAX) return NULL;
-	tbuf = r_buf_new();
-	r_buf_set_bytes (tbuf, buf, sz);
+	tbuf = r_buf_new_with_pointers (buf, sz);
 	res = MACH0_(new_buf) (tbuf);
 	if (res) {
 		sdb_ns_set (sdb, "info", res->kv);
@@ -0,0 +1,75 @@
+/* radare - LGPL - Copyright 2015 - pancake */
+
+/* checks the cached and batch demangling against the plain demanglers
+ * on the symbols of a binary, and times them */
+
+#include <r_types.h>
+#include <r_util.h>
+#include <r_bin.h>
+
+int main(int argc, char **argv) {
+	const char *file = (argc > 1)? argv[1]: "/usr/lib/x86_64-linux-gnu/libstdc++.so.6";
+	const char *lang = (argc > 2)? argv[2]: "cxx";
+	int type = r_bin_demangle_type (lang);
+	RBin *bin = r_bin_new ();
+	RListIter *iter;
+	RBinSymbol *sym;
+	RList *symbols;
+	RProfile prof;
+	double t_plain, t_batch, t_cached;
+	int n, miss = 0, count = 0;
+	char *a, *b;
+
+	if (!r_bin_load (bin, file, 0, 0, 0, -1, false)) {
+		eprintf ("Cannot open '%s'\n", file);
+		r_bin_free (bin);
+		return 1;
+	}
+	symbols = r_bin_get_symbols (bin);
+
+	r_prof_start (&prof);
+	r_list_foreach (symbols, iter, sym) {
+		switch (type) {
+		case R_BIN_NM_JAVA: a = r_bin_demangle_java (sym->name); break;
+		case R_BIN_NM_OBJC: a = r_bin_demangle_objc (NULL, sym->name); break;
+		case R_BIN_NM_SWIFT: a = r_bin_demangle_swift (sym->name); break;
+		default: a = r_bin_demangle_cxx (sym->name); break;
+		}
+		free (a);
+	}
+	r_prof_end (&prof);
+	t_plain = prof.result;
+
+	r_prof_start (&prof);
+	n = r_bin_demangle_symbols (bin->cur, lang, symbols);
+	r_prof_end (&prof);
+	t_batch = prof.result;
+
+	r_prof_start (&prof);
+	r_list_foreach (symbols, iter, sym) {
+		free (r_bin_demangle (bin->cur, lang, sym->name));
+	}
+	r_prof_end (&prof);
+	t_cached = prof.result;
+
+	r_list_foreach (symbols, iter, sym) {
+		switch (type) {
+		case R_BIN_NM_JAVA: a = r_bin_demangle_java (sym->name); break;
+		case R_BIN_NM_OBJC: a = r_bin_demangle_objc (NULL, sym->name); break;
+		case R_BIN_NM_SWIFT: a = r_bin_demangle_swift (sym->name); break;
+		default: a = r_bin_demangle_cxx (sym->name); break;
+		}
+		b = r_bin_demangle (bin->cur, lang, sym->name);
+		if ((a || b) && (!a || !b || strcmp (a, b))) {
+			if (miss++ < 5)
+				eprintf ("'%s': '%s' != '%s'\n", sym->name, a, b);
+		}
+		free (a);
+		free (b);
+		count++;
+	}
+	printf ("%d symbols (%d names)  plain %.3fs  batch %.3fs  cached %.3fs  %s\n",
+		count, n, t_plain, t_batch, t_cached, miss? "FAIL": "ok");
+	r_bin_free (bin);
+	return miss? 1: 0;
+}
@@ -0,0 +1,182 @@
+/* radare - LGPL - Copyright 2015 - pancake */
+
+/* checks r_bin_filter_symbols on a few known cases and against a plain
+ * implementation on random symbol lists with duplicated names and
+ * addresses, and times it against r_bin_filter_name */
+
+#include <r_types.h>
+#include <r_util.h>
+#include <r_bin.h>
+
+#define NB 4096
+
+typedef struct {
+	char *name;
+	ut64 vaddr;
+	int count;
+} RefKey;
+
+static void refkey_free(void *p) {
+	RefKey *k = p;
+	free (k->name);
+	free (k);
+}
+
+/* chained hash of names or (name, vaddr) pairs, compared in full */
+static RefKey *ref_get(RList **b, const char *name, ut64 vaddr) {
+	ut32 h = (sdb_hash (name) ^ (ut32)vaddr) % NB;
+	RListIter *iter;
+	RefKey *k;
+	if (!b[h])
+		b[h] = r_list_newf (refkey_free);
+	r_list_foreach (b[h], iter, k) {
+		if (k->vaddr == vaddr && !strcmp (k->name, name))
+			return k;
+	}
+	k = R_NEW0 (RefKey);
+	k->name = strdup (name);
+	k->vaddr = vaddr;
+	r_list_append (b[h], k);
+	return k;
+}
+
+/* a name seen n times gets _n-1 appended, unless it was already seen at
+ * the same address, and its non printable tail is replaced by the address */
+static void ref_filter(RList **names, RList **pairs, ut64 vaddr, char *name, int maxlen) {
+	int count = ++ref_get (names, name, 0)->count;
+	char *s;
+	if (ref_get (pairs, name, vaddr)->count++)
+		return;
+	if (vaddr) {
+		for (s = name; *s; s++) {
+			if (!IS_PRINTABLE (*s)) {
+				sprintf (s, "_%"PFMT64d, vaddr);
+				break;
+			}
+		}
+	}
+	if (count > 1) {
+		if (strlen (name) > maxlen)
+			name[maxlen] = 0;
+		sprintf (name + strlen (name), "_%d", count - 1);
+	}
+}
+
+static RList *symbols_new(int n, unsigned int seed) {
+	RList *list = r_list_newf (free);
+	int i, j, len;
+	srand (seed);
+	for (i = 0; i < n; i++) {
+		RBinSymbol *sym = R_NEW0 (RBinSymbol);
+		// few names and addresses to get plenty of dups
+		len = 1 + rand () % ((rand () % 8)? 12: 300);
+		for (j = 0; j < len; j++) {
+			sym->name[j] = 'a' + rand () % 3;
+		}
+		if (!(rand () % 50))
+			sym->name[rand () % len] = 1 + rand () % 255;
+		sym->vaddr = (rand () % 4)? 0x1000 + (rand () % (n / 2 + 1)) * 4: 0;
+		r_list_append (list, sym);
+	}
+	return list;
+}
+
+static int test(int n, unsigned int seed, int verbose) {
+	RList *a = symbols_new (n, seed);
+	RList *b = symbols_new (n, seed);
+	RList *c = symbols_new (n, seed);
+	RList *names[NB] = {0}, *pairs[NB] = {0};
+	RListIter *ia, *ib;
+	RBinSymbol *sa, *sb;
+	RProfile prof;
+	double t_sdb, t_new;
+	Sdb *db = sdb_new0 ();
+	int i, miss = 0;
+
+	r_prof_start (&prof);
+	r_list_foreach (c, ia, sa) {
+		r_bin_filter_name (db, sa->vaddr, sa->name, sizeof (sa->name)-8);
+	}
+	r_prof_end (&prof);
+	t_sdb = prof.result;
+	sdb_free (db);
+
+	r_prof_start (&prof);
+	r_bin_filter_symbols (b);
+	r_prof_end (&prof);
+	t_new = prof.result;
+
+	r_list_foreach (a, ia, sa) {
+		ref_filter (names, pairs, sa->vaddr, sa->name, sizeof (sa->name)-8);
+	}
+	ib = b->head;
+	r_list_foreach (a, ia, sa) {
+		sb = ib->data;
+		if (strcmp (sa->name, sb->name)) {
+			if (miss++ < 5)
+				eprintf ("0x%"PFMT64x" '%s' != '%s'\n", sa->vaddr, sa->name, sb->name);
+		}
+		ib = ib->n;
+	}
+	if (verbose || miss) {
+		printf ("%8d symbols  sdb %8.3fs  table %8.3fs  %s\n",
+			n, t_sdb, t_new, miss? "FAIL": "ok");
+	}
+	for (i = 0; i < NB; i++) {
+		r_list_free (names[i]);
+		r_list_free (pairs[i]);
+	}
+	r_list_free (a);
+	r_list_free (b);
+	r_list_free (c);
+	return miss;
+}
+
+/* "dhquykqz" and "wbqpfcee" have the same sdb_hash */
+static int test_known() {
+	const struct { const char *name; ut64 vaddr; const char *expect; } syms[] = {
+		{ "main", 0x1000, "main" },
+		{ "dhquykqz", 0x2000, "dhquykqz" },
+		{ "wbqpfcee", 0x2000, "wbqpfcee" },
+		{ "wbqpfcee", 0x3000, "wbqpfcee_1" },
+		{ "main", 0x1000, "main" },
+		{ "main", 0x4000, "main_2" },
+		{ "main", 0, "main_3" },
+		{ "bad\x01name", 0x10, "bad_16" },
+		{ "bad\x01name", 0x20, "bad_32_1" },
+		{ NULL }
+	};
+	RList *list = r_list_newf (free);
+	RListIter *iter;
+	RBinSymbol *sym;
+	int i, miss = 0;
+	for (i = 0; syms[i].name; i++) {
+		sym = R_NEW0 (RBinSymbol);
+		strcpy (sym->name, syms[i].name);
+		sym->vaddr = syms[i].vaddr;
+		r_list_append (list, sym);
+	}
+	r_bin_filter_symbols (list);
+	i = 0;
+	r_list_foreach (list, iter, sym) {
+		if (strcmp (sym->name, syms[i].expect)) {
+			eprintf ("0x%"PFMT64x" '%s' != '%s'\n", sym->vaddr, sym->name, syms[i].expect);
+			miss++;
+		}
+		i++;
+	}
+	r_list_free (list);
+	return miss;
+}
+
+int main(int argc, char **argv) {
+	int i, n, fail = 0, max = (argc > 1)? atoi (argv[1]): 100000;
+	fail += test_known () != 0;
+	for (i = 0; i < 200; i++) {
+		fail += test (1 + rand () % 2000, i, 0) != 0;
+	}
+	for (n = 1000; n <= max; n *= 10) {
+		fail += test (n, n, 1) != 0;
+	}
+	return fail? 1: 0;
+}
@@ -417,12 +417,85 @@ R_API void r_cons_pop() {
 	}
 }
 
-R_API void r_cons_flush() {
+static void cons_output() {
 	const char *tee = I.teefile;
+	if (tee && *tee) {
+		FILE *d = r_sandbox_fopen (tee, "a+");
+		if (d != NULL) {
+			if (I.buffer_len != fwrite (I.buffer, 1, I.buffer_len, d))
+				eprintf ("r_cons_flush: fwrite: error (%s)\n", tee);
+			fclose (d);
+		} else eprintf ("Cannot write on '%s'\n", tee);
+	}
+	r_cons_highlight (I.highlight);
+	// is_html must be a filter, not a write endpoint
+	if (I.is_html) r_cons_html_print (I.buffer);
+	else r_cons_write (I.buffer, I.buffer_len);
+}
+
+/* the pager, the yes/no question, html and the json and less greps
+ * need the whole output, anything else can be written line by line */
+static int stream_ok() {
+	return !I.is_interactive && !I.is_html && !I.null && !I.noflush
+		&& !I.grep.less && !I.grep.json && !backup;
+}
+
+/* writes the complete lines of the buffer and keeps the last one */
+static void stream_flush() {
+	char *tail = NULL;
+	int len, ret, tail_len;
+	for (len = I.buffer_len; len > 0; len--) {
+		if (I.buffer[len-1] == '\n')
+			break;
+	}
+	if (len < 1)
+		return;
+	tail_len = I.buffer_len - len;
+	if (tail_len > 0)
+		tail = r_mem_dup (I.buffer + len, tail_len);
+	I.buffer_len = len;
+	I.buffer[len] = 0;
+	if (I.grep.nstrings>0||I.grep.tokenfrom!=0||I.grep.tokento!=ST32_MAX||I.grep.line!=-1) {
+		ret = r_cons_grep_lines (I.buffer, I.buffer_len);
+		if (ret >= 0)
+			I.buffer_len = I.grep.counter? 0: ret;
+	}
+	if (I.buffer_len > 0)
+		cons_output ();
+	I.streamed += len;
+	I.buffer_len = 0;
+	I.buffer[0] = 0;
+	if (tail) {
+		memcpy (I.buffer, tail, tail_len);
+		I.buffer_len = tail_len;
+		I.buffer[tail_len] = 0;
+		free (tail);
+	}
+}
+
+/* called after appending str, the buffer is only scanned when str has a
+ * newline so a long output without them is not scanned again each time */
+static inline void stream_check(const char *str, int len) {
+	if (I.stream && I.buffer_len > CONS_STREAM_CHUNK
+			&& memchr (str, '\n', len) && stream_ok ())
+		stream_flush ();
+}
+
+/* in stream mode the output is written in chunks of complete lines while
+ * it is printed instead of when the command is done, so it can be bigger
+ * than the memory. Returns the previous mode */
+R_API int r_cons_set_stream(int enable) {
+	int old = I.stream;
+	I.stream = enable;
+	return old;
+}
+
+R_API void r_cons_flush() {
 	if (I.noflush)
 		return;
 	if (I.null) {
 		r_cons_reset ();
+		I.streamed = 0;
 		return;
 	}
 	r_cons_filter ();
@@ -458,20 +531,9 @@ R_API void r_cons_flush() {
 			r_cons_set_raw (1);
 		}
 	}
-	if (tee && *tee) {
-		FILE *d = r_sandbox_fopen (tee, "a+");
-		if (d != NULL) {
-			if (I.buffer_len != fwrite (I.buffer, 1, I.buffer_len, d))
-				eprintf ("r_cons_flush: fwrite: error (%s)\n", tee);
-			fclose (d);
-		} else eprintf ("Cannot write on '%s'\n", tee);
-	}
-	r_cons_highlight (I.highlight);
-	// is_html must be a filter, not a write endpoint
-	if (I.is_html) r_cons_html_print (I.buffer);
-	else r_cons_write (I.buffer, I.buffer_len);
-
+	cons_output ();
 	r_cons_reset ();
+	I.streamed = 0;
 }
 
 R_API void r_cons_visual_flush() {
@@ -582,6 +644,7 @@ R_API void r_cons_printf(const char *format, ...) {
 			va_end (ap);
 		}
 		I.buffer_len += written;
+		stream_check (I.buffer + I.buffer_len - written, written);
 	} else r_cons_strcat (format);
 }
 
@@ -605,6 +668,7 @@ R_API void r_cons_memcat(const char *str, int len) {
 		memcpy (I.buffer+I.buffer_len, str, len);
 		I.buffer_len += len;
 		I.buffer[I.buffer_len] = 0;
+		stream_check (str, len);
 	}
 }
 
@@ -614,6 +678,7 @@ R_API void r_cons_memset(char ch, int len) {
 		palloc (len+1);
 		memset (I.buffer+I.buffer_len, ch, len+1);
 		I.buffer_len += len;
+		stream_check (&ch, 1);
 	}
 }
 
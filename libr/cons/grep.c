@@ -135,6 +135,7 @@ R_API void r_cons_grep(const char *str) {
 			}
 			strncpy (cons->grep.strings[cons->grep.nstrings],
 				optr, R_CONS_GREP_WORD_SIZE-1);
+			cons->grep.lens[cons->grep.nstrings] = wlen;
 			cons->grep.nstrings++;
 			if (cons->grep.nstrings>R_CONS_GREP_WORDS-1) {
 				eprintf ("too many grep strings\n");
@@ -145,13 +146,13 @@ R_API void r_cons_grep(const char *str) {
 		cons->grep.str = strdup (ptr);
 		cons->grep.nstrings++;
 		cons->grep.strings[0][0] = 0;
+		cons->grep.lens[0] = 0;
 	}
 }
 
 R_API int r_cons_grepbuf(char *buf, int len) {
 	RCons *cons = r_cons_singleton ();
-	char *tline, *tbuf, *p, *out, *in = buf;
-	int ret, buffer_len = 0, l = 0, tl = 0;
+	int buffer_len;
 
 	if((len == 0 || buf == NULL || buf[0] == '\0')
 	   && (cons->grep.json || cons->grep.less)){
@@ -189,44 +190,13 @@ R_API int r_cons_grepbuf(char *buf, int len) {
 		cons->buffer = malloc (cons->buffer_len);
 		cons->buffer[0] = 0;
 	}
-	out = tbuf = calloc (1, len);
-	tline = malloc (len);
-	cons->lines = 0;
-	while ((int)(size_t)(in-buf)<len) {
-		p = strchr (in, '\n');
-		if (!p) {
-			free (tbuf);
-			free (tline);
-			return 0;
-		}
-		l = p-in;
-		if (l > 0) {
-			memcpy (tline, in, l);
-			tl = r_str_ansi_filter (tline, NULL, NULL, l);
-			if (tl < 0)
-				ret = -1;
-			else ret = r_cons_grep_line (tline, tl);
-			if (ret > 0) {
-				if (cons->grep.line == -1 ||
-					(cons->grep.line != -1 && cons->grep.line == cons->lines)) {
-					memcpy (out, tline, ret);
-					memcpy (out+ret, "\n", 1);
-					out += ret+1;
-					buffer_len += ret+1;
-				}
-				cons->lines++;
-			} else if (ret < 0) {
-				free (tbuf);
-				free (tline);
-				return 0;
-			} 
-			in += l+1;
-		} else in++;
-	}
-	memcpy (buf, tbuf, len);
+	/* the streamed chunks have been counted already */
+	if (!cons->streamed)
+		cons->lines = 0;
+	buffer_len = r_cons_grep_lines (buf, len);
+	if (buffer_len < 0)
+		return 0;
 	cons->buffer_len = buffer_len;
-	free (tbuf);
-	free (tline);
 	if (cons->grep.counter) {
 		if (cons->buffer_len<10) cons->buffer_len = 10; // HACK
 		snprintf (cons->buffer, cons->buffer_len, "%d\n", cons->lines);
@@ -235,77 +205,124 @@ R_API int r_cons_grepbuf(char *buf, int len) {
 	return cons->lines;
 }
 
-R_API int r_cons_grep_line(char *buf, int len) {
+/* greps the lines of buf in place, cons->lines counts the matching ones
+ * from its current value so the output can be grepped in chunks. Returns
+ * the new length or -1 if buf must be left as is */
+R_API int r_cons_grep_lines(char *buf, int len) {
 	RCons *cons = r_cons_singleton ();
-	const char delims[5][2] = { "|", ",", ";", "=", "\t" };
-	char *in, *out, *tok = NULL;
-	int hit = cons->grep.neg;
-	int i, j, outlen = 0;
-
-	in = calloc (1, len+1);
-	out = calloc (1, len+2);
-	memcpy (in, buf, len);
-
-	if (cons->grep.nstrings>0) {
-		int ampfail = cons->grep.amp;
-		for (i=0; i<cons->grep.nstrings; i++) {
-			char *p = strstr (in, cons->grep.strings[i]);
-			if (!p) {
-				ampfail = 0;
-				continue;
-			}
-			if (cons->grep.begin)
-				hit = (p == in)? 1: 0;
-			else hit = !cons->grep.neg;
-			// TODO: optimize without strlen without breaking t/feat_grep (grep end)
-			if (cons->grep.end && (strlen (cons->grep.strings[i]) != strlen (p)))
-				hit = 0 ;
-			if (!cons->grep.amp)
-				break;
-		}
-		if (cons->grep.amp)
-			hit = ampfail;
-	} else hit = 1;
+	char *in = buf, *out = buf, *end = buf + len, *p;
+	int ret, l, buffer_len = 0;
 
-	if (hit) {
-		if ((cons->grep.tokenfrom != 0 || cons->grep.tokento != ST32_MAX) &&
-			(cons->grep.line == -1 || cons->grep.line == cons->lines)) {
-			const int delims_count = sizeof (delims) / 2;
-			for (i=0; i<len; i++) for (j=0; j<delims_count; j++)
-				if (in[i] == delims[j][0])
-					in[i] = ' ';
-			for (i=0; i <= cons->grep.tokento; i++) {
-				tok = (char *) strtok (i?NULL:in, " ");
-				if (tok) {
-					if (i >= cons->grep.tokenfrom) {
-						int toklen = strlen (tok);
-						memcpy (out+outlen, tok, toklen);
-						memcpy (out+outlen+toklen, " ", 2);
-						outlen += toklen+1;
-					}
-				} else {
-					if (!(*out)) {
-						free (in);
-						free (out);
-						return -1;
-					} else break;
-				}
-			}
-			outlen = outlen>0? outlen - 1: 0;
-			if (outlen>len) { // should never happen
-				eprintf ("r_cons_grep_line: wtf, how you reach this?\n");
-				free (in);
-				free (out);
+	if (len > 0 && buf[len-1] != '\n')
+		return -1;
+	/* the lines are filtered where they are and moved back to out,
+	 * which never gets past the line being read */
+	for (; in < end; in = p + 1) {
+		p = memchr (in, '\n', end - in);
+		l = p - in;
+		if (l < 1)
+			continue;
+		if (memchr (in, 0x1b, l)) {
+			l = r_str_ansi_filter (in, NULL, NULL, l);
+			if (l < 0)
 				return -1;
+		}
+		ret = r_cons_grep_line (in, l);
+		if (ret > 0) {
+			if (cons->grep.line == -1 || cons->grep.line == cons->lines) {
+				memmove (out, in, ret);
+				out[ret] = '\n';
+				out += ret+1;
+				buffer_len += ret+1;
 			}
-			memcpy (buf, out, len);
-			len = outlen;
+			cons->lines++;
 		}
-	} else len = 0;
+	}
+	if (buffer_len < len)
+		buf[buffer_len] = 0;
+	return buffer_len;
+}
 
-	free (in);
-	free (out);
+/* finds the word in the line, memchr looks for its first byte many bytes
+ * at a time and the last one is checked before comparing the rest */
+static const char *grep_find(const char *s, int len, const char *w, int wlen) {
+	const char *last = s + len - wlen;
+	if (wlen < 1)
+		return s;
+	while (s <= last) {
+		s = memchr (s, *w, last - s + 1);
+		if (!s)
+			return NULL;
+		if (s[wlen-1] == w[wlen-1] && !memcmp (s, w, wlen))
+			return s;
+		s++;
+	}
+	return NULL;
+}
 
+static int grep_word(RConsGrep *grep, const char *s, int len, int i) {
+	const char *w = grep->strings[i];
+	int wlen = grep->lens[i];
+	if (wlen > len)
+		return 0;
+	if (grep->begin && grep->end)
+		return wlen == len && !memcmp (s, w, wlen);
+	if (grep->begin)
+		return !memcmp (s, w, wlen);
+	if (grep->end)
+		return !memcmp (s + len - wlen, w, wlen);
+	return grep_find (s, len, w, wlen) != NULL;
+}
+
+static inline int grep_delim(char c) {
+	switch (c) {
+	case ' ': case '|': case ',': case ';': case '=': case '\t':
+		return 1;
+	}
+	return 0;
+}
+
+/* keeps the columns from tokenfrom to tokento joined by spaces */
+static int grep_tokens(RConsGrep *grep, char *buf, int len) {
+	int i = 0, from, tok = 0, outlen = 0;
+	while (i < len && tok <= grep->tokento) {
+		while (i < len && grep_delim (buf[i]))
+			i++;
+		if (i == len)
+			break;
+		for (from = i; i < len && !grep_delim (buf[i]); i++);
+		if (tok++ < grep->tokenfrom)
+			continue;
+		if (outlen)
+			buf[outlen++] = ' ';
+		memmove (buf + outlen, buf + from, i - from);
+		outlen += i - from;
+	}
+	return outlen;
+}
+
+/* greps a line without ansi escapes in place. Returns the length of what
+ * is left of it or 0 if it does not match */
+R_API int r_cons_grep_line(char *buf, int len) {
+	RCons *cons = r_cons_singleton ();
+	RConsGrep *grep = &cons->grep;
+	int i, hit = 1;
+
+	if (grep->nstrings > 0) {
+		/* any of the words or all of them with & */
+		for (i = 0; i < grep->nstrings; i++) {
+			hit = grep_word (grep, buf, len, i);
+			if (hit != grep->amp)
+				break;
+		}
+		if (grep->neg)
+			hit = !hit;
+	}
+	if (!hit)
+		return 0;
+	if ((grep->tokenfrom != 0 || grep->tokento != ST32_MAX) &&
+			(grep->line == -1 || grep->line == cons->lines))
+		len = grep_tokens (grep, buf, len);
 	return len;
 }
 
@@ -0,0 +1,165 @@
+/* radare - LGPL - Copyright 2015 - pancake */
+
+/* times the ~ grep on a disassembly like buffer and checks every line
+ * against a plain strtok and strstr based grep */
+
+#include <r_cons.h>
+#include <r_util.h>
+
+static const char *ops[] = {
+	"mov rax, qword [rbp-0x18]", "call sym.imp.malloc", "test rax, rax",
+	"lea rdi, [rip+0x1234]", "jne 0x4005d0", "push rbp", "ret", "xor eax, eax",
+};
+
+/* some lines lack the pipe to have something for ^ */
+static char *mkbuf(int n, int *len) {
+	char *buf = malloc (n * 64 + 1), *p = buf;
+	int i;
+	for (i = 0; i < n; i++) {
+		p += sprintf (p, (i % 7 == 3)? "0x%08x  %s\n": (i % 5)? "  |   0x%08x    %s\n":
+			"  |   \x1b[32m0x%08x\x1b[0m    %s\n", 0x400000 + i * 3, ops[i % 8]);
+	}
+	*len = p - buf;
+	return buf;
+}
+
+typedef struct {
+	char words[256];
+	int amp, neg, begin, end;
+	int from, to, line;
+} RefGrep;
+
+/* &^! modifiers, words separated by commas and an optional $, then
+ * [from-to] columns and the :line among the matching ones */
+static void ref_parse(RefGrep *g, const char *expr) {
+	char *p;
+	memset (g, 0, sizeof (*g));
+	g->to = ST32_MAX;
+	g->line = -1;
+	for (;; expr++) {
+		if (*expr == '&') g->amp = 1;
+		else if (*expr == '!') g->neg = 1;
+		else if (*expr == '^') g->begin = 1;
+		else break;
+	}
+	strncpy (g->words, expr, sizeof (g->words) - 1);
+	p = g->words + strlen (g->words);
+	if (p - g->words > 1 && p[-1] == '$') {
+		p[-1] = 0;
+		g->end = 1;
+	}
+	if ((p = strchr (g->words, '['))) {
+		*p++ = 0;
+		g->from = g->to = atoi (p);
+		if ((p = strchr (p, '-')))
+			g->to = atoi (p + 1)? atoi (p + 1): ST32_MAX;
+	}
+	if ((p = strchr (g->words, ':'))) {
+		*p++ = 0;
+		g->line = atoi (p);
+	}
+}
+
+static int ref_word(const RefGrep *g, const char *line, const char *w) {
+	int l = strlen (line), wl = strlen (w);
+	if (wl > l)
+		return 0;
+	if (g->begin && g->end)
+		return !strcmp (line, w);
+	if (g->begin)
+		return !strncmp (line, w, wl);
+	if (g->end)
+		return !strcmp (line + l - wl, w);
+	return strstr (line, w) != NULL;
+}
+
+/* any of the words or all of them with &, ! negates */
+static int ref_match(const RefGrep *g, const char *line) {
+	char *e = strdup (g->words), *w;
+	int hit = g->amp;
+	if (!*e)
+		hit = 1;
+	for (w = strtok (e, ","); w; w = strtok (NULL, ",")) {
+		if (ref_word (g, line, w) != g->amp) {
+			hit = !g->amp;
+			break;
+		}
+	}
+	free (e);
+	return g->neg? !hit: hit;
+}
+
+/* keeps the selected columns joined by spaces, empty if there are none */
+static void ref_columns(const RefGrep *g, char *line) {
+	char *e = strdup (line), *w;
+	int i = 0;
+	*line = 0;
+	for (w = strtok (e, " |,;=\t"); w && i <= g->to; w = strtok (NULL, " |,;=\t")) {
+		if (i++ < g->from)
+			continue;
+		if (*line)
+			strcat (line, " ");
+		strcat (line, w);
+	}
+	free (e);
+}
+
+static int test(const char *expr, const char *buf, int len, int n) {
+	char line[128], *exp, *out;
+	const char *p, *q;
+	int miss = 0, count = 0, lines = 0;
+	RProfile prof;
+	RefGrep g;
+
+	/* strip the colors as the grep does */
+	ref_parse (&g, expr);
+	exp = malloc (len + 1);
+	*exp = 0;
+	for (p = buf; (q = strchr (p, '\n')); p = q + 1) {
+		int l = R_MIN (q - p, sizeof (line) - 1);
+		memcpy (line, p, l);
+		line[l] = 0;
+		r_str_ansi_filter (line, NULL, NULL, l);
+		if (!ref_match (&g, line))
+			continue;
+		if (g.line == -1 || g.line == lines) {
+			if (g.from != 0 || g.to != ST32_MAX) {
+				ref_columns (&g, line);
+				/* lines without the columns are skipped */
+				if (!*line)
+					continue;
+			}
+			strcat (strcat (exp + count, line), "\n");
+			count += strlen (exp + count);
+		}
+		lines++;
+	}
+	r_cons_reset ();
+	r_cons_grep (expr);
+	r_cons_memcat (buf, len);
+	r_prof_start (&prof);
+	r_cons_filter ();
+	r_prof_end (&prof);
+	out = strdup (r_cons_get_buffer ());
+	r_cons_reset ();
+	if (strcmp (out, exp))
+		miss++;
+	printf ("%8d lines  ~%-12s %.3fs  %s\n", n, expr, prof.result,
+		miss? "FAIL": "ok");
+	free (out);
+	free (exp);
+	return miss;
+}
+
+int main(int argc, char **argv) {
+	const char *exprs[] = { "call", "rax,ret", "&rax,test", "!mov", "&!push,ret", "0x4",
+		"^0x", "^  |,push", "!^0x", "rax$", "ret$,rbp$", "^0x,rax$", "[1]", "[2]",
+		"[1-2]", "rax[2-0]", "call:3", ":0", "!ret:100", NULL };
+	int i, len, fail = 0, n = (argc > 1)? atoi (argv[1]): 1000000;
+	char *buf = mkbuf (n, &len);
+	r_cons_new ();
+	for (i = 0; exprs[i]; i++)
+		fail += test (exprs[i], buf, len, n);
+	free (buf);
+	return fail? 1: 0;
+}
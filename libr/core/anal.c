@@ -960,12 +960,14 @@ R_API int r_core_anal_fcn_clean(RCore *core, ut64 addr) {
 	RListIter *iter, *iter_tmp;
 
 	if (addr == 0) {
+		r_anal_fcn_tree_purge (core->anal);
 		r_list_purge (core->anal->fcns);
 		if (!(core->anal->fcns = r_anal_fcn_list_new ()))
 			return false;
 	} else {
 		r_list_foreach_safe (core->anal->fcns, iter, iter_tmp, fcni) {
 			if (in_function (fcni, addr)) {
+				r_anal_fcn_tree_delete (core->anal, fcni);
 				r_list_delete (core->anal->fcns, iter);
 			}
 		}
@@ -1809,13 +1811,12 @@ R_API RCoreAnalStats* r_core_anal_get_stats (RCore *core, ut64 from, ut64 to, ut
 		return NULL;
 	}
 	memset (as->block, 0, as_size);
-	// iter all flags
-	r_list_foreach (core->flags->flags, iter, f) {
-		//if (f->offset+f->size < from) continue;
-		if (f->offset< from) continue;
-		if (f->offset > to) continue;
+	// iter all flags in the range
+	for (f = r_flag_get_after (core->flags, from); f && f->offset <= to;
+			f = r_flag_get_after (core->flags, f->offset + 1)) {
 		piece = (f->offset-from)/step;
-		as->block[piece].flags++;
+		as->block[piece].flags += r_list_length (r_flag_get_list (core->flags, f->offset));
+		if (f->offset == UT64_MAX) break;
 	}
 
 	r_list_foreach (core->anal->fcns, iter, F) {
@@ -2054,10 +2055,13 @@ R_API void r_core_anal_fcn_merge (RCore *core, ut64 addr, ut64 addr2) {
 	}
 	// TODO: import data/code/refs
 	// update size
+	r_anal_fcn_tree_delete (core->anal, f1);
 	f1->addr = R_MIN (addr, addr2);
 	f1->size = max-min;
+	r_anal_fcn_tree_insert (core->anal, f1);
 	// resize
 	f2->bbs = NULL;
+	r_anal_fcn_tree_delete (core->anal, f2);
 	r_list_delete_data (core->anal->fcns, f2);
 }
 
@@ -361,13 +361,13 @@ static int bin_info(RCore *r, int mode) {
 static int bin_dwarf(RCore *core, int mode) {
 	RBinDwarfRow *row;
 	RListIter *iter;
-	RList *list = NULL;
+	RList *list = NULL, *ownlist = NULL;
 	RBinFile *binfile = r_core_bin_cur (core);
 	RBinPlugin * plugin = r_bin_file_cur_plugin (binfile);
 	if (!binfile) return false;
 
 	if (plugin && plugin->lines) {
-		list = plugin->lines (binfile);
+		list = r_bin_get_lines (core->bin);
 	} else if (core->bin) {
 		// TODO: complete and speed-up support for dwarf
 		if (r_config_get_i (core->config, "bin.dwarf")) {
@@ -375,7 +375,7 @@ static int bin_dwarf(RCore *core, int mode) {
 			da = r_bin_dwarf_parse_abbrev (core->bin, mode);
 			r_bin_dwarf_parse_info (da, core->bin, mode);
 			r_bin_dwarf_parse_aranges (core->bin, mode);
-			list = r_bin_dwarf_parse_line (core->bin, mode);
+			list = ownlist = r_bin_dwarf_parse_line (core->bin, mode);
 			r_bin_dwarf_free_debug_abbrev (da);
 			free (da);
 		}
@@ -409,7 +409,7 @@ static int bin_dwarf(RCore *core, int mode) {
 		}
         }
 	r_cons_break_end ();
-	r_list_free (list);
+	r_list_free (ownlist);
 	return true;
 }
 
@@ -928,6 +928,9 @@ static int bin_symbols_internal(RCore *r, int mode, ut64 laddr, int va, ut64 at,
 	}
 
 	symbols = r_bin_get_symbols (r->bin);
+	if (bin_demangle && !at && !name) {
+		r_bin_demangle_symbols (r->bin->cur, lang, symbols);
+	}
 	r_space_set (&r->anal->meta_spaces, "bin");
 	if (mode & R_CORE_BIN_JSON) {
 		r_cons_printf ("[");
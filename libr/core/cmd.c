@@ -1047,9 +1047,10 @@ R_API int r_core_cmd_pipe(RCore *core, char *radare_cmd, char *shell_cmd) {
 		str = r_core_cmd_str (core, radare_cmd);
 		r_sys_cmd_str_full (shell_cmd+1, str, &out, &olen, NULL);
 		free (str);
-		r_cons_memcat (out, olen);
+		// set the grep first, the output can be streamed while appended
 		if (_ptr)
 			r_cons_grep (_ptr);
+		r_cons_memcat (out, olen);
 		free (out);
 		ret = 0;
 	}
@@ -1410,11 +1411,13 @@ next:
 		}
 		pipefd = r_cons_pipe_open (str, fdn, ptr[1]=='>');
 		if (pipefd != -1) {
+			int ostream = r_cons_set_stream (true);
 			if (!pipecolor)
 				r_config_set_i (core->config, "scr.color", 0);
 
 			ret = r_core_cmd_subst (core, cmd);
 			r_cons_flush ();
+			r_cons_set_stream (ostream);
 			r_cons_pipe_close (pipefd);
 		}
 		r_cons_set_last_interactive ();
@@ -2245,15 +2248,19 @@ R_API char *r_core_cmd_strf(RCore *core, const char *fmt, ...) {
 R_API char *r_core_cmd_str(RCore *core, const char *cmd) {
 	const char *static_str;
 	char *retstr = NULL;
+	/* the output is returned, not written */
+	int ostream = r_cons_set_stream (false);
 	r_cons_reset ();
 	if (r_core_cmd (core, cmd, 0) == -1) {
 		//eprintf ("Invalid command: %s\n", cmd);
+		r_cons_set_stream (ostream);
 		return NULL;
 	}
 	r_cons_filter ();
 	static_str = r_cons_get_buffer ();
 	retstr = strdup (static_str? static_str: "");
 	r_cons_reset ();
+	r_cons_set_stream (ostream);
 	return retstr;
 }
 
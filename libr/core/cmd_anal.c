@@ -565,11 +565,11 @@ static int cmd_anal_fcn(RCore *core, const char *input) {
 			r_config_set (core->config, "anal.limits", "true");
 
 			RAnalFunction *fcn = r_anal_get_fcn_in (core->anal, addr, 0);
-			if (fcn) r_anal_fcn_resize (fcn, addr_end-addr);
+			if (fcn) r_anal_fcn_resize (core->anal, fcn, addr_end-addr);
 			r_core_anal_fcn (core, addr, UT64_MAX,
 					R_ANAL_REF_TYPE_NULL, depth);
 			fcn = r_anal_get_fcn_in (core->anal, addr, 0);
-			if (fcn) r_anal_fcn_resize (fcn, addr_end-addr);
+			if (fcn) r_anal_fcn_resize (core->anal, fcn, addr_end-addr);
 
 			r_config_set_i (core->config, "anal.from", a);
 			r_config_set_i (core->config, "anal.to", b);
@@ -971,7 +971,7 @@ static int cmd_anal_fcn(RCore *core, const char *input) {
 			//r_core_anal_undefine (core, core->offset);
 			/* resize function if overlaps */
 			fcn = r_anal_get_fcn_in (core->anal, addr, 0);
-			if (fcn) r_anal_fcn_resize (fcn, addr - fcn->addr);
+			if (fcn) r_anal_fcn_resize (core->anal, fcn, addr - fcn->addr);
 			r_core_anal_fcn (core, addr, UT64_MAX,
 				R_ANAL_REF_TYPE_NULL, depth);
 			if (analyze_recursively) {
@@ -993,7 +993,7 @@ static int cmd_anal_fcn(RCore *core, const char *input) {
 							f = r_anal_get_fcn_in (core->anal, fcn->addr, 0);
 							if (f) {
 								/* cut function */
-								r_anal_fcn_resize (f, addr - fcn->addr);
+								r_anal_fcn_resize (core->anal, f, addr - fcn->addr);
 								r_core_anal_fcn (core, ref->addr, fcn->addr,
 									R_ANAL_REF_TYPE_CALL, depth);
 								f = r_anal_get_fcn_at (core->anal, fcn->addr, 0);
@@ -2142,7 +2142,10 @@ static boolt cmd_anal_refs(RCore *core, const char *input) {
 		break;
 	case 'k':
 		if (input[1]==' ') {
+			// the sdb is only a snapshot of the xrefs index
+			r_anal_xrefs_export (core->anal);
 			sdb_query (core->anal->sdb_xrefs, input+2);
+			r_anal_xrefs_import (core->anal);
 		} else eprintf ("|ERROR| Usage: axk [query]\n");
 		break;
 	case '\0':
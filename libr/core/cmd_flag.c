@@ -159,7 +159,7 @@ rep:
 				base = r_num_math (core->num, str);
 				r_list_foreach (f->flags, iter, flag) {
 					if (r_str_glob (flag->name, ptr+1))
-						flag->offset += base;
+						r_flag_set (f, flag->name, flag->offset + base, flag->size, 0);
 				}
 			} else core->flags->base = r_num_math (core->num, input+1);
 			free (str);
@@ -322,7 +322,7 @@ static int cmd_info(void *data, const char *input) {
 				int idx = r_num_math (core->num, input +2);
 				int count = 0;
 				if (input[2] && obj) {
-					r_list_foreach (obj->classes, iter, cls) {
+					r_list_foreach (r_bin_get_classes (core->bin), iter, cls) {
 						if (idx != count++)
 							continue;
 						switch (input[1]) {
@@ -364,7 +364,7 @@ static int cmd_info(void *data, const char *input) {
 					}
 				} else {
 					if (input[1] == 'l' && obj) { // "icl"
-						r_list_foreach (obj->classes, iter, cls) {
+						r_list_foreach (r_bin_get_classes (core->bin), iter, cls) {
 							r_list_foreach (cls->methods, iter2, sym) {
 								const char *comma = iter2->p? " ": "";
 								r_cons_printf ("%s0x%"PFMT64d, comma, sym->vaddr);
@@ -142,6 +142,9 @@ static int cmd_meta_lineinfo(RCore *core, const char *input) {
 		return 0;
 	}
 
+	// the CL commands work on the sdb view of the line table
+	r_bin_addrlines_sync (core->bin->cur);
+
 	if (*p == '-') {
 		p++;
 		remove = true;
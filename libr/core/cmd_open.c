@@ -141,6 +141,7 @@ static void cmd_open_map (RCore *core, const char *input) {
 				ut64 diff = map->to - map->from;
 				map->from = new;
 				map->to = new+diff;
+				r_io_map_index_invalidate (core->io);
 			} else eprintf ("Cannot find any map here\n");
 		} else {
 			cur = core->offset;
@@ -150,6 +151,7 @@ static void cmd_open_map (RCore *core, const char *input) {
 				ut64 diff = map->to - map->from;
 				map->from = new;
 				map->to = new+diff;
+				r_io_map_index_invalidate (core->io);
 			} else eprintf ("Cannot find any map here\n");
 		}
 		break;
@@ -24,6 +24,7 @@ struct search_parameters {
 	boolt use_mread;
 	boolt aes_search;
 	boolt rsa_search;
+	int threads;
 };
 
 struct endlist_pair {
@@ -1434,8 +1435,14 @@ static void do_string_search(RCore *core, struct search_parameters *param) {
 			r_list_append (param->boundaries, map);
 			maplist = true;
 		}
-		buf = (ut8 *)malloc (core->blocksize);
 		bufsz = core->blocksize;
+		if (param->threads > 1 && !param->crypto_search && !param->bckwrds) {
+			// read enough to keep all the threads busy
+			ut64 sz = (ut64)R_MAX (bufsz, 0x100000) * param->threads;
+			if (sz <= ST32_MAX)
+				bufsz = sz;
+		}
+		buf = (ut8 *)malloc (bufsz);
 		r_list_foreach (param->boundaries, iter, map) {
 			int fd;
 			param->from = map->from;
@@ -1488,6 +1495,9 @@ static void do_string_search(RCore *core, struct search_parameters *param) {
 				   */
 				if (ret <1)
 					break;
+				// the reads of the threads are far bigger than a block
+				if (bufsz != core->blocksize && at + ret > param->to)
+					ret = param->to - at;
 				if (param->crypto_search) {
 					int delta = 0;
 					if (param->aes_search)
@@ -1500,7 +1510,7 @@ static void do_string_search(RCore *core, struct search_parameters *param) {
 						}
 						aeskw.count++;
 					}
-				} else if (r_search_update (core->search, &at, buf, ret) == -1) {
+				} else if (r_search_update_threads (core->search, at, buf, ret, param->threads) == -1) {
 					//eprintf ("search: update read error at 0x%08"PFMT64x"\n", at);
 					break;
 				}
@@ -1637,6 +1647,8 @@ static int cmd_search(void *data, const char *input) {
 	}
 */
 	maxhits = r_config_get_i (core->config, "search.maxhits");
+	param.threads = R_MAX (1, R_MIN (r_config_get_i (core->config, "search.threads"),
+		R_SEARCH_THREADS_MAX));
 	searchprefix = r_config_get (core->config, "search.prefix");
 	// TODO: get ranges from current IO section
 	/* XXX: Think how to get the section ranges here */
@@ -1469,6 +1469,7 @@ R_API int r_core_config_init(RCore *core) {
 	SETPREF("search.prefix", "hit", "Prefix name in search hits label");
 	SETPREF("search.show", "true", "Show search results");
 	SETI("search.to", -1, "Search end address");
+	SETI("search.threads", 1, "Number of threads used by keyword searches (up to 64)");
 
 	/* rop */
 	SETI("rop.len", 5, "Maximum ROP gadget length");
@@ -1161,8 +1161,10 @@ R_API int r_core_prompt(RCore *r, int sync) {
 }
 
 R_API int r_core_prompt_exec(RCore *r) {
+	int ostream = r_cons_set_stream (true);
 	int ret = r_core_cmd (r, r->cmdqueue, true);
 	r_cons_flush ();
+	r_cons_set_stream (ostream);
 	if (r->zerosep)
 		r_cons_zero ();
 	return ret;
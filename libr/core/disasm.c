@@ -1698,12 +1698,14 @@ static int handle_print_labels (RCore *core, RDisasmState *ds, RAnalFunction *f)
 static void handle_print_import_name (RCore * core, RDisasmState *ds) {
 	RListIter *iter = NULL;
 	RBinReloc *rel = NULL;
+	RList *relocs;
 	switch (ds->analop.type) {
 		case R_ANAL_OP_TYPE_JMP:
 		case R_ANAL_OP_TYPE_CJMP:
 		case R_ANAL_OP_TYPE_CALL:
-			if (core->bin->cur->o->imports && core->bin->cur->o->relocs) {
-				r_list_foreach (core->bin->cur->o->relocs, iter, rel) {
+			relocs = core->bin->cur->o->imports? r_bin_get_relocs (core->bin): NULL;
+			if (relocs) {
+				r_list_foreach (relocs, iter, rel) {
 					if ((rel->vaddr == ds->analop.jump) &&
 						(rel->import != NULL)) {
 						if (ds->show_color)
@@ -1,4 +1,4 @@
-/* radare - LGPL - Copyright 2010-2014 - nibble, pancake */
+/* radare - LGPL - Copyright 2010-2015 - nibble, pancake */
 
 #include <stdio.h>
 #include <string.h>
@@ -21,14 +21,120 @@ R_API int r_core_gdiff_fcn(RCore *c, ut64 addr, ut64 addr2) {
 	return false;
 }
 
+/* fingerprints are built in two steps: the bytes of the basic blocks
+ * of each core are read in list order through its io into a snapshot,
+ * then workers turn the snapshots of both cores into block and function
+ * fingerprints without touching the io. Sizes are set back in list
+ * order once all of them are done. Analysis plugins with their own
+ * fingerprinting and opcode-only diffing (diff.ops) go through the
+ * arch plugins, which are shared by both cores, so they stay serial */
+#define GDIFF_THREADS 4
+#define GDIFF_THREAD_MIN 0x100000
+
+typedef struct {
+	RAnal *anal;
+	RAnalFunction *fcn;
+	const ut8 *buf; // bytes of its basic blocks, in list order
+	int len;
+} GDiffItem;
+
+typedef struct {
+	GDiffItem *items;
+	int n;
+} GDiffJob;
+
+static int gdiff_serial(RAnal *anal) {
+	return anal->diff_ops || (anal->cur &&
+		(anal->cur->fingerprint_bb || anal->cur->fingerprint_fcn));
+}
+
+static ut8 *gdiff_snapshot(RAnal *anal, GDiffItem *items, int *n, ut64 *total) {
+	RAnalFunction *fcn;
+	RAnalBlock *bb;
+	RListIter *iter, *iter2;
+	ut64 size = 0, off = 0;
+	ut8 *buf;
+	r_list_foreach (anal->fcns, iter, fcn) {
+		r_list_foreach (fcn->bbs, iter2, bb) {
+			if (bb->size > 0)
+				size += bb->size;
+		}
+	}
+	if (!(buf = malloc (size + 1)))
+		return NULL;
+	r_list_foreach (anal->fcns, iter, fcn) {
+		items[*n].anal = anal;
+		items[*n].fcn = fcn;
+		items[*n].buf = buf + off;
+		r_list_foreach (fcn->bbs, iter2, bb) {
+			if (bb->size < 1)
+				continue;
+			anal->iob.read_at (anal->iob.io, bb->addr, buf + off, bb->size);
+			off += bb->size;
+		}
+		items[*n].len = (int)(buf + off - items[*n].buf);
+		(*n)++;
+	}
+	*total += size;
+	return buf;
+}
+
+static void gdiff_fingerprint(GDiffItem *items, int n) {
+	RAnalFunction *fcn;
+	RAnalBlock *bb;
+	RListIter *iter;
+	int i, off;
+	for (i = 0; i < n; i++) {
+		fcn = items[i].fcn;
+		off = 0;
+		r_list_foreach (fcn->bbs, iter, bb) {
+			if (!(bb->fingerprint = malloc (1 + R_MAX (bb->size, 0))))
+				continue;
+			if (bb->size > 0) {
+				memcpy (bb->fingerprint, items[i].buf + off, bb->size);
+				off += bb->size;
+			}
+		}
+		fcn->fingerprint = NULL;
+		if (items[i].len > 0 && (fcn->fingerprint = malloc (items[i].len)))
+			memcpy (fcn->fingerprint, items[i].buf, items[i].len);
+		else items[i].len = 0;
+	}
+}
+
+static int gdiff_fingerprint_th(RThread *th) {
+	GDiffJob *job = th->user;
+	gdiff_fingerprint (job->items, job->n);
+	return false;
+}
+
+static void gdiff_fingerprint_serial(RAnal *anal) {
+	RAnalFunction *fcn;
+	RAnalBlock *bb;
+	RListIter *iter, *iter2;
+	/* Fingerprint fcn bbs (functions basic-blocs) */
+	r_list_foreach (anal->fcns, iter, fcn) {
+		r_list_foreach (fcn->bbs, iter2, bb) {
+			r_anal_diff_fingerprint_bb (anal, bb);
+		}
+	}
+	/* Fingerprint fcn */
+	r_list_foreach (anal->fcns, iter, fcn) {
+		r_anal_fcn_set_size (anal, fcn,
+			r_anal_diff_fingerprint_fcn (anal, fcn));
+	}
+}
+
 /* Fingerprint functions and blocks, then diff.
  * If `anal_all` is 1 analyse all the symbols, if its 2 runs `aac` */
 R_API int r_core_gdiff(RCore *c, RCore *c2, int anal_all) {
 	RCore *cores[2] = {c, c2};
-	RAnalFunction *fcn;
-	RAnalBlock *bb;
-	RListIter *iter, *iter2;
-	int i;
+	ut8 *snap[2] = {NULL, NULL};
+	GDiffItem *items = NULL;
+	GDiffJob jobs[GDIFF_THREADS];
+	RThread *th[GDIFF_THREADS];
+	ut64 total = 0;
+	int i, n = 0, njobs = 1, nth = 0;
 
 	if (!c || !c2)
 		return false;
@@ -37,17 +143,40 @@ R_API int r_core_gdiff(RCore *c, RCore *c2, int anal_all) {
 			r_core_cmd0 (cores[i], "aac");
 		if (anal_all>0)
 			r_core_anal_all (cores[i]);
-		/* Fingerprint fcn bbs (functions basic-blocs) */
-		r_list_foreach (cores[i]->anal->fcns, iter, fcn) {
-			r_list_foreach (fcn->bbs, iter2, bb) {
-				r_anal_diff_fingerprint_bb (cores[i]->anal, bb);
-			}
-		}
-		/* Fingerprint fcn */
-		r_list_foreach (cores[i]->anal->fcns, iter, fcn) {
-			fcn->size = r_anal_diff_fingerprint_fcn (cores[i]->anal, fcn);
-		}
 	}
+	for (i = 0; i < 2; i++) {
+		if (!gdiff_serial (cores[i]->anal))
+			n += r_list_length (cores[i]->anal->fcns);
+	}
+	items = calloc (n + 1, sizeof (GDiffItem));
+	n = 0;
+	for (i = 0; i < 2; i++) {
+		if (!items || gdiff_serial (cores[i]->anal) ||
+				!(snap[i] = gdiff_snapshot (cores[i]->anal, items, &n, &total)))
+			gdiff_fingerprint_serial (cores[i]->anal);
+	}
+	if (n >= GDIFF_THREADS && total >= GDIFF_THREAD_MIN)
+		njobs = GDIFF_THREADS;
+	for (i = 0; i < njobs; i++) {
+		jobs[i].items = items + (n * i / njobs);
+		jobs[i].n = (n * (i + 1) / njobs) - (n * i / njobs);
+	}
+	for (i = 1; i < njobs; i++) {
+		th[nth] = r_th_new (gdiff_fingerprint_th, &jobs[i], 0);
+		if (th[nth]) nth++;
+		else gdiff_fingerprint (jobs[i].items, jobs[i].n);
+	}
+	gdiff_fingerprint (jobs[0].items, jobs[0].n);
+	for (i = 0; i < nth; i++) {
+		r_th_wait (th[i]);
+		r_th_free (th[i]);
+	}
+	for (i = 0; i < n; i++) {
+		r_anal_fcn_set_size (items[i].anal, items[i].fcn, items[i].len);
+	}
+	free (items);
+	free (snap[0]);
+	free (snap[1]);
 	/* Diff functions */
 	r_anal_diff_fcn (cores[0]->anal, cores[0]->anal->fcns, cores[1]->anal->fcns);
 
@@ -315,6 +315,7 @@ R_API int r_core_project_save(RCore *core, const char *file) {
 		 {
 			char buf[1024];
 			snprintf (buf, sizeof (buf), "%s.d"R_SYS_DIR"xrefs", prj);
+			r_anal_xrefs_export (core->anal);
 			sdb_file (core->anal->sdb_xrefs, buf);
 			sdb_sync (core->anal->sdb_xrefs);
 		 }
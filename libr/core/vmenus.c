@@ -1704,7 +1704,7 @@ R_API void r_core_visual_define (RCore *core) {
 			if (r_anal_op (core->anal, &op, here, core->block+delta,
 					core->blocksize-delta)) {
 				size = here - fcn->addr + op.size;
-				r_anal_fcn_resize (fcn, size);
+				r_anal_fcn_resize (core->anal, fcn, size);
 			}
 		}
 		}
@@ -1786,7 +1786,7 @@ R_API void r_core_visual_define (RCore *core) {
 		{
 			RAnalFunction *fcn = r_anal_get_fcn_in (core->anal, core->offset, 0);
 			if (fcn)
-				r_anal_fcn_resize (fcn, core->offset - fcn->addr);
+				r_anal_fcn_resize (core->anal, fcn, core->offset - fcn->addr);
 		}
 		{
 			int funsize = 0;
@@ -1803,7 +1803,7 @@ R_API void r_core_visual_define (RCore *core) {
 			r_cons_break_end ();
 			if (funsize) {
 				RAnalFunction *f = r_anal_get_fcn_in (core->anal, off, -1);
-				if (f) f->size = funsize;
+				if (f) r_anal_fcn_set_size (core->anal, f, funsize);
 			}
 		}
 		break;
@@ -0,0 +1,130 @@
+/* radare - LGPL - Copyright 2015 - pancake */
+
+/* times the memory hashtable of sdb with namespaces of keys shaped like
+ * the ones of the anal hints, meta, xrefs and types, and checks that
+ * every key reads back its own value. With a million keys some of them
+ * collide on their 32 bit hash */
+
+#include <r_util.h>
+#include "r_db.h"
+#include <sys/resource.h>
+
+static void mkkey(char *k, int size, int i) {
+	switch (i % 4) {
+	case 0: snprintf (k, size, "0x%x", 0x400000 + i * 4); break;
+	case 1: snprintf (k, size, "hint.0x%x", 0x400000 + i * 4); break;
+	case 2: snprintf (k, size, "xref.code.0x%x.0x%x", 0x400000 + i, 0x800000 - i); break;
+	default: snprintf (k, size, "type.struct.some_long_type_name_%d.member_%d", i / 16, i % 16); break;
+	}
+}
+
+static void mkval(char *v, int size, int i, int gen) {
+	snprintf (v, size, "%d,0x%x,%s", gen, i, (i % 3)? "code": "data,size=32");
+}
+
+static int count_cb(void *user, const char *k, const char *v) {
+	(*(int*)user)++;
+	return 1;
+}
+
+static int test(int n, int verbose) {
+	double t_set, t_get, t_miss, t_upd, t_del, t_each, t_free;
+	char k[128], v[128];
+	int i, miss = 0, count = 0;
+	RProfile prof;
+	const char *r;
+	Sdb *s = sdb_new0 ();
+
+	r_prof_start (&prof);
+	for (i = 0; i < n; i++) {
+		mkkey (k, sizeof (k), i);
+		mkval (v, sizeof (v), i, 0);
+		sdb_set (s, k, v, 0);
+	}
+	r_prof_end (&prof);
+	t_set = prof.result;
+
+	r_prof_start (&prof);
+	for (i = 0; i < n; i++) {
+		mkkey (k, sizeof (k), (int)(((ut64)i * 7919) % n));
+		if (!sdb_const_get (s, k, NULL))
+			miss++;
+	}
+	r_prof_end (&prof);
+	t_get = prof.result;
+
+	r_prof_start (&prof);
+	for (i = n; i < 2 * n; i++) {
+		mkkey (k, sizeof (k), i);
+		if (sdb_const_get (s, k, NULL))
+			miss++;
+	}
+	r_prof_end (&prof);
+	t_miss = prof.result;
+
+	r_prof_start (&prof);
+	for (i = 0; i < n; i += 2) {
+		mkkey (k, sizeof (k), i);
+		mkval (v, sizeof (v), i, 1);
+		sdb_set (s, k, v, 0);
+	}
+	r_prof_end (&prof);
+	t_upd = prof.result;
+
+	r_prof_start (&prof);
+	for (i = 0; i < n; i += 3) {
+		mkkey (k, sizeof (k), i);
+		sdb_remove (s, k, 0);
+	}
+	r_prof_end (&prof);
+	t_del = prof.result;
+
+	r_prof_start (&prof);
+	sdb_foreach (s, count_cb, &count);
+	r_prof_end (&prof);
+	t_each = prof.result;
+
+	for (i = 0; i < n; i++) {
+		mkkey (k, sizeof (k), i);
+		r = sdb_const_get (s, k, NULL);
+		if (i % 3) {
+			mkval (v, sizeof (v), i, !(i % 2));
+			if (!r || strcmp (r, v)) {
+				if (miss++ < 5)
+					eprintf ("'%s': '%s' != '%s'\n", k, r, v);
+			}
+		} else if (r) {
+			if (miss++ < 5)
+				eprintf ("'%s': removed but has '%s'\n", k, r);
+		}
+	}
+	if (count != n - (n + 2) / 3)
+		miss++;
+
+	r_prof_start (&prof);
+	sdb_free (s);
+	r_prof_end (&prof);
+	t_free = prof.result;
+
+	if (verbose || miss) {
+		printf ("%8d keys  set %.3fs  get %.3fs  miss %.3fs  update %.3fs  "
+			"remove %.3fs  foreach %.3fs  free %.3fs  %s\n", n,
+			t_set, t_get, t_miss, t_upd, t_del, t_each, t_free,
+			miss? "FAIL": "ok");
+	}
+	return miss;
+}
+
+int main(int argc, char **argv) {
+	int i, n, fail = 0, max = (argc > 1)? atoi (argv[1]): 1000000;
+	struct rusage ru;
+	for (i = 0; i < 200; i++) {
+		fail += test (1 + i * 37, 0) != 0;
+	}
+	for (n = 1000; n <= max; n *= 10) {
+		fail += test (n, 1) != 0;
+	}
+	getrusage (RUSAGE_SELF, &ru);
+	printf ("maxrss %ldMB\n", ru.ru_maxrss / 1024);
+	return fail? 1: 0;
+}
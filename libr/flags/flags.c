@@ -1,5 +1,10 @@
 /* radare - LGPL - Copyright 2007-2015 - pancake */
 
+/* flags are owned by f->flags, found by name through the ht_name hash
+ * and by offset through the f->by_off tree, which keeps a list of the
+ * flags at each offset sorted by address. Changes of item->offset must
+ * go through flag_index_move to keep the tree in sync */
+
 #include <r_flags.h>
 #include <r_util.h>
 #include <r_cons.h>
@@ -12,21 +17,75 @@ R_LIB_VERSION(r_flag);
 Sdb *db = NULL;
 #endif
 
-/* aim to fix a bug in hashtable64 , collisions happen */
-#define XORKEY 0x12345678
-#define XOROFF(x) (x^XORKEY)
-// offset needs to be xored to avoid some collisions !!! must switch to sdb
-//#define XOROFF(x) x
+static RList *flag_list_at(RFlag *f, ut64 off) {
+	RITreeNode *node = r_itree_first (f->by_off, off);
+	return (node && node->from == off)? node->data: NULL;
+}
+
+static void flag_index_add(RFlag *f, RFlagItem *item) {
+	RList *list = flag_list_at (f, item->offset);
+	if (!list) {
+		list = r_list_new ();
+		if (!list) return;
+		r_itree_insert (f->by_off, item->offset, item->offset, list);
+	}
+	r_list_append (list, item);
+}
+
+static void flag_index_del(RFlag *f, RFlagItem *item) {
+	RList *list = flag_list_at (f, item->offset);
+	if (list && r_list_delete_data (list, item) && r_list_empty (list)) {
+		r_itree_delete (f->by_off, item->offset, list);
+		r_list_free (list);
+	}
+}
+
+static void flag_index_move(RFlag *f, RFlagItem *item, ut64 off) {
+	if (item->offset != off) {
+		flag_index_del (f, item);
+		item->offset = off;
+		flag_index_add (f, item);
+	}
+}
+
+static void flag_name_add(RFlag *f, RFlagItem *item) {
+	RList *list = r_hashtable64_lookup (f->ht_name, item->namehash);
+	if (!list) {
+		list = r_list_new ();
+		if (!list) return;
+		r_hashtable64_insert (f->ht_name, item->namehash, list);
+	}
+	r_list_append (list, item);
+}
+
+static void flag_name_del(RFlag *f, RFlagItem *item) {
+	RList *list = r_hashtable64_lookup (f->ht_name, item->namehash);
+	if (list && r_list_delete_data (list, item) && r_list_empty (list)) {
+		r_hashtable64_remove (f->ht_name, item->namehash);
+		r_list_free (list);
+	}
+}
+
+static RFlagItem *flag_by_name(RFlag *f, const char *name) {
+	RList *list = r_hashtable64_lookup (f->ht_name, r_str_hash64 (name));
+	RListIter *iter;
+	RFlagItem *item;
+	// skip the other names with the same hash
+	r_list_foreach_prev (list, iter, item) {
+		if (!strncmp (item->name, name, R_FLAG_NAME_SIZE - 1))
+			return item;
+	}
+	return NULL;
+}
 
 static ut64 num_callback (RNum *user, const char *name, int *ok) {
 	RFlag *f = (RFlag*)user;
-	RList *list;
+	RFlagItem *item;
 
 	if (ok) *ok = 0;
-	
-	list = r_hashtable64_lookup (f->ht_name, r_str_hash64 (name));
-	if (list) {
-		RFlagItem *item = r_list_get_top (list);
+
+	item = flag_by_name (f, name);
+	if (item) {
 		// NOTE: to avoid warning infinite loop here we avoid recursivity
 		if (item->alias)
 			return 0LL;
@@ -51,7 +110,7 @@ R_API RFlag * r_flag_new() {
 	f->space_idx2 = -1;
 	f->spacestack = r_list_newf (NULL);
 	f->ht_name = r_hashtable64_new ();
-	f->ht_off = r_hashtable64_new ();
+	f->by_off = r_itree_new ((RListFree)r_list_free);
 	for (i=0; i<R_FLAG_SPACES_MAX; i++)
 		f->spaces[i] = NULL;
 	return f;
@@ -78,13 +137,12 @@ R_API RFlag *r_flag_free(RFlag *f) {
 	r_list_foreach (f->flags, iter, item) {
 		RList *list = r_hashtable64_lookup (f->ht_name, item->namehash);
 		// XXX r_list_free (list);
-		list = r_hashtable64_lookup (f->ht_off, item->offset);
 		// XXX: segfault sometimes wtf -- r_list_free (list);
 	}
 #endif
 	for (i=0; i<R_FLAG_SPACES_MAX; i++)
 		free (f->spaces[i]);
-	r_hashtable64_free (f->ht_off);
+	r_itree_free (f->by_off);
 	r_hashtable64_free (f->ht_name);
 	r_list_free (f->flags);
 	r_list_free (f->spacestack);
@@ -180,19 +238,14 @@ static RFlagItem *evalFlag (RFlag *f, RFlagItem *item) {
 	if (item) {
 		if (item->alias) {
 			ut64 res = r_num_math (f->num, item->alias);
-			item->offset = res;
+			flag_index_move (f, item, res);
 		}
 	}
 	return item;
 }
 
 R_API RFlagItem *r_flag_get(RFlag *f, const char *name) {
-	RList *list = r_hashtable64_lookup (f->ht_name, r_str_hash64 (name));
-	if (list) {
-		RFlagItem *item = r_list_get_top (list);
-		return evalFlag (f, item);
-	}
-	return NULL;
+	return evalFlag (f, flag_by_name (f, name));
 }
 
 R_API RFlagItem *r_flag_get_i2(RFlag *f, ut64 off) {
@@ -205,15 +258,10 @@ R_API RFlagItem *r_flag_get_i2(RFlag *f, ut64 off) {
 	char * foo = sdb_get (db, sdb_itoa (off, buf, 16), 0);
 	return r_flag_get (f, foo);
 #else
-       list = r_hashtable64_lookup (f->ht_off, XOROFF(off));
-
-//if (off == 0x4005c4) { eprintf ("FLAG GET IT %llx = %p\n", off, list); }
+	list = flag_list_at (f, off);
 	if (list) {
 		RListIter *iter;
 		r_list_foreach (list, iter, item) {
-			// XXX: hack, because some times the hashtable is poluted by ghost values
-			if (item->offset != off)
-				continue;
 #define NEW_FILTER 1
 #if NEW_FILTER
 			/* catch sym. first */
@@ -249,7 +297,7 @@ R_API RFlagItem *r_flag_get_i2(RFlag *f, ut64 off) {
 }
 
 R_API const RList* /*<RFlagItem*>*/ r_flag_get_list(RFlag *f, ut64 off) {
-	return r_hashtable64_lookup (f->ht_off, XOROFF(off));
+	return flag_list_at (f, off);
 }
 
 R_API char *r_flag_get_liststr(RFlag *f, ut64 off) {
@@ -264,31 +312,13 @@ R_API char *r_flag_get_liststr(RFlag *f, ut64 off) {
 	return p;
 }
 
-#define R_FLAG_TEST 0
 R_API RFlagItem *r_flag_get_i(RFlag *f, ut64 off) {
-	RList *list = r_hashtable64_lookup (f->ht_off, XOROFF(off));
-//if (off == 0x4005c4) { eprintf ("FLAG GET IT %llx = %p\n", off, list); }
-	if (list) {
-		RFlagItem *item = r_list_get_top (list);
-#if R_FLAG_TEST
-		return item;
-#else
-		// XXX: hack, because some times the hashtable is poluted by ghost values
-		if (item && item->offset == off)
-			return item;
-#endif
-	}
-	return NULL;
+	RList *list = flag_list_at (f, off);
+	return list? r_list_get_top (list): NULL;
 }
 
 R_API RFlagItem *r_flag_set(RFlag *f, const char *name, ut64 off, ut32 size, int dup) {
-	RFlagItem *item = NULL;
-#if 1
-	RListIter *iter2 = NULL;
-	RListIter *iter22 = NULL;
-	RFlagItem *item2 = NULL;
-#endif
-	RList *list2, *list;
+	RFlagItem *item;
 
 #if USE_SDB
 {
@@ -298,113 +328,30 @@ sdb_set (db, sdb_itoa (off, buf, 16), name, 0);
 }
 #endif
 
-//if (strstr(name, "str")) eprintf ("%d %s=0x%"PFMT64x"\n", dup, name, off);
-	dup = 0; // XXX: force nondup
-
 	/* contract fail */
 	if (!name || !*name)
 		return NULL;
-	if (dup) {
-// XXX: doesnt works well 
-		item = R_NEW0 (RFlagItem);
-		if (!r_flag_item_set_name (item, name, NULL)) {
-			eprintf ("Invalid flag name '%s'.\n", name);
-			free (item);
-			return NULL;
-		}
-		item->space = f->space_idx;
-		r_list_append (f->flags, item);
-
-		item->offset = off + f->base;
+	// dup is ignored, flag names are unique
+	item = r_flag_get (f, name);
+	if (item) {
+		flag_index_move (f, item, off);
 		item->size = size;
-
-		list = r_hashtable64_lookup (f->ht_name, item->namehash);
-		if (!list) {
-			list = r_list_new ();
-			r_hashtable64_insert (f->ht_name, item->namehash, list);
-		}
-		r_list_append (list, item);
-
-		list2 = r_hashtable64_lookup (f->ht_off, XOROFF(off));
-		if (list2 == NULL) {
-			list2 = r_list_new ();
-			r_hashtable64_insert (f->ht_name, off, list2);
-		}
-		r_list_append (list2, item);
-	} else {
-		item = r_flag_get (f, name);
-		if (item) {
-			if (item->offset == off) {
-				item->size = size;
-				return item;
-			}
-			/* remove old entry */
-#if 1
-			RList *list2 = r_hashtable64_lookup (f->ht_off, XOROFF(item->offset));
-			if (list2) {
-				/* No _safe loop necessary because we break immediately after the delete. */
-				r_list_foreach_safe (list2, iter2, iter22, item2) {
-					if (item->namehash != item2->namehash)
-						continue;
-					if (item->offset == item2->offset) {
-						// r_list_delete (list2, iter2);
-						// delete without freeing contents
-						//list2->free = NULL;
-						r_list_split_iter (list2, iter2);
-						if (r_list_empty (list2)) {
-							r_hashtable64_remove (f->ht_off, item2->offset);
-							r_hashtable64_insert (f->ht_off, item2->offset, NULL);
-							//r_list_free (list2);
-							//list2 = NULL;
-						}
-						break;
-					}
-				}
-			}
-#endif
-			/* update new entry */
-			item->offset = off;
-			item->size = size;
-
-#if 1
-			RList *lol = r_hashtable64_lookup (f->ht_off, XOROFF(off));
-			if (!lol) {
-				lol = r_list_new ();
-				r_hashtable64_remove (f->ht_off, XOROFF(off));
-				r_hashtable64_insert (f->ht_off, XOROFF(off), lol);
-			}
-			if (lol) {
-				r_list_append (lol, item);
-			}
-#endif
-		} else {
-			item = R_NEW0 (RFlagItem);
-			if (!r_flag_item_set_name (item, name, NULL)) {
-				eprintf ("Invalid flag name '%s'.\n", name);
-				free (item);
-				return NULL;
-			}
-			item->space = f->space_idx;
-			r_list_append (f->flags, item);
-			item->offset = off + f->base;
-			item->size = size;
-
-			list = r_hashtable64_lookup (f->ht_name, item->namehash);
-			if (!list) {
-				list = r_list_new ();
-				r_hashtable64_insert (f->ht_name, item->namehash, list);
-			}
-			r_list_append (list, item);
-
-			list2 = r_hashtable64_lookup (f->ht_off, XOROFF(off));
-			if (list2 == NULL) {
-				list2 = r_list_new ();
-				r_hashtable64_insert (f->ht_off, XOROFF(off), list2);
-//if (off == 0x4005c4) { eprintf ("FLAG SET IT %llx = %p\n", off, list2); }
-			}
-			r_list_append (list2, item);
-		}
+		return item;
+	}
+	item = R_NEW0 (RFlagItem);
+	if (!item)
+		return NULL;
+	if (!r_flag_item_set_name (item, name, NULL)) {
+		eprintf ("Invalid flag name '%s'.\n", name);
+		free (item);
+		return NULL;
 	}
+	item->space = f->space_idx;
+	item->offset = off + f->base;
+	item->size = size;
+	r_list_append (f->flags, item);
+	flag_name_add (f, item);
+	flag_index_add (f, item);
 	return item;
 }
 
@@ -441,46 +388,28 @@ R_API int r_flag_item_set_name(RFlagItem *item, const char *name, const char *re
 	memmove (item->name, r_str_chop (item->name), len);
 	r_name_filter (item->name, 0);
 	item->name[R_FLAG_NAME_SIZE-1]='\0';
-	item->namehash = r_str_hash64 (item->realname);
+	// the ht_name key, realname may be changed later by the demangler
+	item->namehash = r_str_hash64 (item->name);
 	return true;
 }
 
 R_API int r_flag_rename(RFlag *f, RFlagItem *item, const char *name) {
-	ut64 hash;
-	RList *list;
 	if (!f || !item || !name || !*name) {
 		eprintf ("r_flag_rename: contract fail\n");
 		return false;
 	}
-	hash = r_str_hash64 (item->name);
-	list = r_hashtable64_lookup (f->ht_name, hash);
-	if (list) {
-		RFlagItem *item = r_list_get_top (list);
-		if (r_list_empty (list)) {
-			//r_list_free (list);
-			r_hashtable64_remove (f->ht_name, hash);
-		} else {
-			r_hashtable64_remove (f->ht_name, hash);
-			r_list_delete_data (list, item);
-		}
-		if (!r_flag_item_set_name (item, name, NULL)) {
-			r_list_append (list, item);
-			return false;
-		}
-		list = r_hashtable64_lookup (f->ht_name, item->namehash);
-		if (!list) {
-			list = r_list_new ();
-			r_hashtable64_insert (f->ht_name, item->namehash, list);
-		}
-		r_list_append (list, item);
-	}
+	if (!r_name_check (name))
+		return false;
+	flag_name_del (f, item);
+	r_flag_item_set_name (item, name, NULL);
+	flag_name_add (f, item);
 	return true;
 }
 
 R_API int r_flag_unset_i(RFlag *f, ut64 off, RFlagItem *p) {
 	RFlagItem *flag = r_flag_get_i (f, off);
 	if (flag) {
-		r_flag_unset (f, flag->name, NULL); //, flag);
+		r_flag_unset (f, flag->name, flag);
 		return true;
 	}
 	return false;
@@ -514,78 +443,32 @@ R_API void r_flag_unset_all (RFlag *f) {
 
 	r_hashtable64_free (f->ht_name);
 	f->ht_name = r_hashtable64_new ();
-	r_hashtable64_free (f->ht_off);
-	f->ht_off = r_hashtable64_new ();
+	r_itree_purge (f->by_off);
 
 	r_flag_space_unset (f, NULL);
 }
 
-static void unflag(RFlag *f, ut64 namehash) {
-	RFlagItem *item;
-	RListIter *iter;
-	/* No _safe loop necessary because we return immediately after the delete. */
-	r_list_foreach (f->flags, iter, item) {
-		if (item->namehash == namehash) {
-			r_list_delete (f->flags, iter);
-			break;
-		}
-	}
-}
-
 R_API int r_flag_unset(RFlag *f, const char *name, RFlagItem *p) {
-	ut64 off;
-	RListIter *iter2;
-	RFlagItem *item2, *item = p;
-	ut64 hash = r_str_hash64 (name);
-	RList *list2, *list = r_hashtable64_lookup (f->ht_name, hash);
-// list = name hash
-// list2 = off hash
-	if (list && list->head) {
-		if (!item) item = r_list_pop (list);
-		if (!item) return false;
-		off = item->offset;
-
-		list2 = r_hashtable64_lookup (f->ht_off, XOROFF(off));
-		if (list2) {
-			/* delete flag by name */
-			/* No _safe loop necessary because we break immediately after the delete. */
-			r_list_foreach (list2, iter2, item2) {
-				if (hash == item2->namehash) {
-					r_list_delete (list2, iter2);
-					break;
-				}
-			}
-			if (list2 && r_list_empty (list2)) {
-				r_list_free (list2);
-				r_hashtable64_remove (f->ht_off, XOROFF(off));
-			}
-		}
-		/* delete from f->flags list */
-		unflag (f, hash);
-		if (list && r_list_empty (list)) {
-			r_list_free (list);
-			r_hashtable64_remove (f->ht_name, hash);
-		}
-		return true;
-	}
-	return false;
+	RFlagItem *item = p? p: flag_by_name (f, name);
+	if (!item)
+		return false;
+	flag_name_del (f, item);
+	flag_index_del (f, item);
+	/* frees the item */
+	r_list_delete_data (f->flags, item);
+	return true;
 }
 
+/* closest flag at or before off */
 R_API RFlagItem *r_flag_get_at(RFlag *f, ut64 off) {
-	RFlagItem *item, *nice = NULL;
-	RListIter *iter;
+	RITreeNode *node = r_itree_last (f->by_off, off);
+	return node? r_list_first (node->data): NULL;
+}
 
-	r_list_foreach (f->flags, iter, item) {
-		if (item->offset == off)
-			return item;
-		if (off > item->offset) {
-			if (nice)  {
-				if (nice->offset < item->offset)
-					nice = item;
-			} else nice = item;
-		}
-	}
-	return nice;
+/* closest flag at or after off */
+R_API RFlagItem *r_flag_get_after(RFlag *f, ut64 off) {
+	RITreeNode *node = r_itree_first (f->by_off, off);
+	return node? r_list_first (node->data): NULL;
 }
 
 R_API int r_flag_relocate (RFlag *f, ut64 off, ut64 off_mask, ut64 to) {
@@ -600,7 +483,7 @@ R_API int r_flag_relocate (RFlag *f, ut64 off, ut64 off_mask, ut64 to) {
 		if (fn == on) {
 			ut64 fm = item->offset & off_mask;
 			ut64 om = to & off_mask;
-			item->offset = (to&neg_mask) + fm + om;
+			flag_index_move (f, item, (to&neg_mask) + fm + om);
 			n++;
 		}
 	}
@@ -18,12 +18,34 @@ static int cmp(const void *a, const void *b) {
 	return 0;
 }
 
+/* the offset index is already sorted, just walk it */
+static int sort_by_offset(RFlag *f) {
+	RITreeNode *node;
+	RListIter *iter;
+	RFlagItem *flag;
+	RList *list, *tmp = r_list_newf ((RListFree)r_flag_item_free);
+	if (!tmp) return false;
+	for (node = r_itree_first (f->by_off, 0); node; node = r_itree_next (f->by_off, node)) {
+		list = node->data;
+		r_list_foreach (list, iter, flag) {
+			r_list_append (tmp, flag);
+		}
+	}
+	f->flags->free = NULL;
+	r_list_free (f->flags);
+	f->flags = tmp;
+	return !r_list_empty (tmp);
+}
+
 R_API int r_flag_sort(RFlag *f, int namesort) {
 	int ret = false;
 	int changes;
 	RFlagItem *flag, *fi = NULL;
 	RListIter *iter, *it_elem;
-	RList *tmp = r_list_new ();
+	RList *tmp;
+	if (!namesort)
+		return sort_by_offset (f);
+	tmp = r_list_new ();
 	// find bigger ones after this
 	do {
 		changes = 0;
@@ -49,6 +71,6 @@ R_API int r_flag_sort(RFlag *f, int namesort) {
 
 	free (f->flags);
 	f->flags = tmp;
-	f->flags->free = free;
+	f->flags->free = (RListFree)r_flag_item_free;
 	return ret;
 }
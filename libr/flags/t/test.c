@@ -23,8 +23,22 @@ int main()
 	if (fi) printf("FLAG FOUND '%s'\n", fi->name);
 	else printf("FLAG NOT FOUND\n");
 
+	r_flag_set(flags, "bar", 0x100, 0, 0);
+	r_flag_set(flags, "baz", 0x200, 0, 0);
+	fi = r_flag_get_at(flags, 0x1ff);
+	printf("AT 0x1ff '%s'\n", fi? fi->name: "");
+	fi = r_flag_get_after(flags, 0x101);
+	printf("AFTER 0x101 '%s'\n", fi? fi->name: "");
+	r_flag_rename(flags, fi, "qux");
+	fi = r_flag_get(flags, "qux");
+	printf("RENAMED '%s' %s\n", fi? fi->name: "",
+		r_flag_get(flags, "foo")? "FAIL": "OK");
+	r_flag_unset(flags, "bar", NULL);
+	fi = r_flag_get_at(flags, 0x1ff);
+	printf("AT 0x1ff '%s'\n", fi? fi->name: "");
+
 	r_cons_printf ("--- pre ---\n");
-	r_flag_list (flags, 0);
+	r_flag_list (flags, 0, NULL);
 	r_cons_flush ();
 
 	r_cons_printf ("--- sort ---\n");
@@ -33,7 +47,7 @@ int main()
 
 	r_cons_printf ("--- list ---\n");
 	r_cons_flush ();
-	r_flag_list (flags, 1);
+	r_flag_list (flags, 1, NULL);
 	r_cons_flush ();
 	r_flag_free (flags);
 	r_cons_free ();
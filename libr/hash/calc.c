@@ -13,6 +13,9 @@ static int bitnum(int bit) {
 
 /* TODO: do it more beautiful with structs and not spaguetis */
 /* TODO: find a better method name */
+/* only the first algorithm set in algobit is computed, because ctx->digest
+ * holds a single digest. Callers hashing with several algorithms use one
+ * context and call for each bit (see rahash2) */
 R_API int r_hash_calculate(RHash *ctx, ut64 algobit, const ut8 *buf, int len) {
 	if (len <= 0)
 		return 0;
@@ -6,26 +6,150 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
-#include "r_types.h"
+#include "r_hash.h"
 
-static double get_px(ut8 x, const ut8 *data, ut64 size) {
-        ut64 i, count = 0;
-        for (i = 0; i < size; i++)
-                if (data[i] == x)
-                        count++;
-        return (double) count / size;
+/* count every byte value in one pass. Four tables are used so that
+ * runs of the same byte do not wait on the previous increment */
+static void histogram(const ut8 *data, ut64 size, ut64 *count) {
+	ut64 c[4][256] = {{0}};
+	ut64 i;
+	int x;
+	for (i = 0; i + 4 <= size; i += 4) {
+		c[0][data[i]]++;
+		c[1][data[i + 1]]++;
+		c[2][data[i + 2]]++;
+		c[3][data[i + 3]]++;
+	}
+	for (; i < size; i++)
+		c[0][data[i]]++;
+	for (x = 0; x < 256; x++)
+		count[x] = c[0][x] + c[1][x] + c[2][x] + c[3][x];
 }
 
 R_API double r_hash_entropy(const ut8 *data, ut64 size) {
-        ut32 x;
-        double h = 0, px, log2 = log (2.0);
-        for (x = 0; x < 256; x++) {
-                px = get_px (x, data, size);
-                if (px > 0)
-                        h += -px * (log (px) / log2);
-        }
-        return h;
+	ut64 count[256];
+	ut32 x;
+	double h = 0, px, log2 = log (2.0);
+	if (!data || !size)
+		return 0;
+	histogram (data, size, count);
+	for (x = 0; x < 256; x++) {
+		if (count[x]) {
+			px = (double) count[x] / size;
+			h += -px * (log (px) / log2);
+		}
+	}
+	return h;
+}
+
+/* c * log2 (c), from the table when possible */
+static inline double clogc(RHashEntropy *e, ut32 c) {
+	return (c <= e->max)? e->clogc[c]: c * (log (c) / log (2.0));
+}
+
+static void entropy_resync(RHashEntropy *e) {
+	int x;
+	e->sum = 0;
+	for (x = 0; x < 256; x++)
+		e->sum += clogc (e, e->count[x]);
+	e->updates = 0;
+}
+
+/* incremental entropy of a sliding window: bytes are added when they
+ * enter the window and removed when they leave it, keeping the sum
+ * of c*log2(c) of the histogram, so each step costs O(1). 'max' is
+ * the usual size of the window, used to size the logarithm table */
+R_API RHashEntropy *r_hash_entropy_new(int max) {
+	RHashEntropy *e = R_NEW0 (RHashEntropy);
+	ut32 c;
+	if (!e) return NULL;
+	e->max = R_MAX (1, R_MIN (max, 0x100000));
+	e->clogc = malloc (sizeof (double) * (e->max + 1));
+	if (!e->clogc) {
+		free (e);
+		return NULL;
+	}
+	e->clogc[0] = 0;
+	for (c = 1; c <= e->max; c++)
+		e->clogc[c] = c * (log (c) / log (2.0));
+	return e;
+}
+
+R_API void r_hash_entropy_free(RHashEntropy *e) {
+	if (!e) return;
+	free (e->clogc);
+	free (e);
+}
+
+R_API void r_hash_entropy_reset(RHashEntropy *e) {
+	memset (e->count, 0, sizeof (e->count));
+	e->size = 0;
+	e->sum = 0;
+	e->updates = 0;
+}
+
+R_API void r_hash_entropy_add(RHashEntropy *e, const ut8 *buf, int len) {
+	int i;
+	for (i = 0; i < len; i++) {
+		ut32 c = e->count[buf[i]]++;
+		e->sum += clogc (e, c + 1) - clogc (e, c);
+	}
+	e->size += len;
+	e->updates += len;
+}
+
+R_API void r_hash_entropy_del(RHashEntropy *e, const ut8 *buf, int len) {
+	int i;
+	for (i = 0; i < len; i++) {
+		ut32 c = e->count[buf[i]];
+		if (!c) continue;
+		e->count[buf[i]]--;
+		e->sum += clogc (e, c - 1) - clogc (e, c);
+		e->size--;
+	}
+	e->updates += len;
+}
+
+/* bits per byte of the bytes in the window, 0-8 */
+R_API double r_hash_entropy_get(RHashEntropy *e) {
+	double h;
+	if (!e->size)
+		return 0;
+	// drop the rounding errors accumulated by the updates
+	if (e->updates > 0x100000)
+		entropy_resync (e);
+	h = log (e->size) / log (2.0) - e->sum / e->size;
+	return (h < 0)? 0: h;
+}
+
+/* entropy of every 'window' bytes of data starting each 'step' bytes,
+ * out must have room for (size - window) / step + 1 values. Returns
+ * the number of values written */
+R_API int r_hash_entropy_map(const ut8 *data, ut64 size, int window, int step, double *out) {
+	RHashEntropy *e;
+	ut64 at;
+	int n = 0;
+	if (!data || !out || window < 1 || step < 1 || size < (ut64)window)
+		return 0;
+	e = r_hash_entropy_new (window);
+	if (!e) return 0;
+	r_hash_entropy_add (e, data, window);
+	for (at = 0;; at += step) {
+		out[n++] = r_hash_entropy_get (e);
+		if (at + step + window > size)
+			break;
+		if (step < window) {
+			r_hash_entropy_del (e, data + at, step);
+			r_hash_entropy_add (e, data + at + window, step);
+		} else {
+			r_hash_entropy_reset (e);
+			r_hash_entropy_add (e, data + at + step, window);
+		}
+	}
+	r_hash_entropy_free (e);
+	return n;
 }
 
 R_API double r_hash_entropy_fraction(const ut8 *data, ut64 size) {
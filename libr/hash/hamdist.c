@@ -32,21 +32,18 @@ errors that transformed one string into the other.
 
 #include "r_types.h"
 
-static int hamdist(int x, int y) {
-	int dist = 0, val = x^y;
-	while (val) {
-		++dist; 
-		val &= val - 1;
-	}
-	return dist;
-}
+/* bits set in each byte value */
+#define BITS2(n) n, n+1, n+1, n+2
+#define BITS4(n) BITS2(n), BITS2(n+1), BITS2(n+1), BITS2(n+2)
+#define BITS6(n) BITS4(n), BITS4(n+1), BITS4(n+1), BITS4(n+2)
+static const ut8 bits_set[256] = { BITS6(0), BITS6(1), BITS6(1), BITS6(2) };
 
+/* the distance of each byte to the previous distance, which is never
+ * above 8, so the loop is a single table lookup per byte */
 R_API ut8 r_hash_hamdist(const ut8 *buf, int len) {
-	int i, x, y;
-	x = y = i = 0;
+	int i, x = 0;
 	for (i=0; i<len; i++) {
-		y = buf[i];
-		x = hamdist (x, y);
+		x = bits_set[x ^ buf[i]];
 	}
 	return x;
 }
@@ -1,4 +1,4 @@
-/* radare - LGPL - Copyright 2007-2014 pancake */
+/* radare - LGPL - Copyright 2007-2015 pancake */
 
 #include "r_hash.h"
 #include "r_util.h"
@@ -38,39 +38,78 @@ R_API int r_hash_pcprint(const ut8 *buffer, ut64 len) {
 	return ((100*n)/len);
 }
 
-R_API int r_hash_parity(const ut8 *buf, ut64 len) {
-	const ut8 *end = buf+len;
-	ut32 ones = 0;
-	for (;buf<end;buf++) {
-		ut8 x = buf[0];
-		ones += ((x&128)?1:0) + ((x&64)?1:0) + ((x&32)?1:0) + ((x&16)?1:0) +
-			((x&8)?1:0) + ((x&4)?1:0) + ((x&2)?1:0) + ((x&1)?1:0);
+/* the checksums below work on 8 bytes at a time */
+static inline ut64 load64(const ut8 *p) {
+	ut64 v;
+	memcpy (&v, p, sizeof (v));
+	return v;
+}
+
+/* xor of all the 64 bit words, the tail bytes are left to the caller */
+static ut64 xor64(const ut8 *b, ut64 len) {
+	ut64 a = 0, c = 0, i;
+	for (i = 0; i + 16 <= len; i += 16) {
+		a ^= load64 (b + i);
+		c ^= load64 (b + i + 8);
 	}
-	return ones%2;
+	if (i + 8 <= len)
+		a ^= load64 (b + i);
+	return a ^ c;
+}
+
+R_API int r_hash_parity(const ut8 *buf, ut64 len) {
+	/* the parity of the ones is the parity of their xor */
+	ut8 x = r_hash_xor (buf, len);
+	x ^= x >> 4;
+	x ^= x >> 2;
+	x ^= x >> 1;
+	return x & 1;
 }
 
 /* These functions comes from 0xFFFF */
 /* fmi: nopcode.org/0xFFFF */
 R_API ut16 r_hash_xorpair(const ut8 *a, ut64 len) {
-	ut16 result = 0, *b = (ut16 *)a;
-	for (len>>=1; len--; b++)
-		result ^= *b;
+	ut64 x = xor64 (a, len);
+	ut64 i = len & ~(ut64)7;
+	ut16 w, result = (ut16)(x ^ (x >> 16) ^ (x >> 32) ^ (x >> 48));
+	for (; i + 2 <= len; i += 2) {
+		memcpy (&w, a + i, sizeof (w));
+		result ^= w;
+	}
 	return result;
 }
 
 R_API ut8 r_hash_xor(const ut8 *b, ut64 len) {
-	ut8 res = 0;
-	for (; len--; b++)
-		res ^= *b;
+	ut64 i, x = xor64 (b, len);
+	ut8 res;
+	x ^= x >> 32;
+	x ^= x >> 16;
+	res = (ut8)(x ^ (x >> 8));
+	for (i = len & ~(ut64)7; i < len; i++)
+		res ^= b[i];
 	return res;
 }
 
+#define LANES16 0x00ff00ff00ff00ffULL
+
 R_API ut8 r_hash_mod255(const ut8 *b, ut64 len) {
-	int i, c = 0;
+	ut64 i = 0, acc;
+	ut32 c = 0;
+	int n;
 	/* from gdb */
-	for (i = 0; i < len; i++)
+	while (i + 8 <= len) {
+		/* add the bytes in 16 bit lanes, 128 words can not overflow them */
+		for (acc = 0, n = 0; n < 128 && i + 8 <= len; n++, i += 8) {
+			ut64 w = load64 (b + i);
+			acc += (w & LANES16) + ((w >> 8) & LANES16);
+		}
+		c += (acc & 0xffff) + ((acc >> 16) & 0xffff) +
+			((acc >> 32) & 0xffff) + (acc >> 48);
+	}
+	for (; i < len; i++)
 		c += b[i];
-	return c%255;
+	// wraps like the int counter used to
+	return (int)c % 255;
 }
 
 R_API ut8 r_hash_deviation(const ut8 *b, ut64 len) {
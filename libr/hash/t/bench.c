@@ -0,0 +1,121 @@
+/* checks the checksum kernels against the byte loops and reports GB/s */
+
+#include <r_hash.h>
+#include <r_util.h>
+
+static ut32 ref_crc32(const ut8 *buf, ut64 len) {
+	ut32 crc = 0xffffffff;
+	int k;
+	while (len--) {
+		crc ^= *buf++;
+		for (k = 0; k < 8; k++)
+			crc = (crc >> 1) ^ ((crc & 1)? 0xedb88320: 0);
+	}
+	return crc ^ 0xffffffff;
+}
+
+static ut16 ref_crc16(const ut8 *buf, ut64 len) {
+	ut16 crc = 0;
+	int k;
+	while (len--) {
+		crc ^= *buf++;
+		for (k = 0; k < 8; k++)
+			crc = (crc >> 1) ^ ((crc & 1)? 0xa001: 0);
+	}
+	return crc;
+}
+
+static ut8 ref_xor(const ut8 *b, ut64 len) {
+	ut8 res = 0;
+	while (len--)
+		res ^= *b++;
+	return res;
+}
+
+static ut16 ref_xorpair(const ut8 *b, ut64 len) {
+	ut16 w, res = 0;
+	for (; len >= 2; len -= 2, b += 2) {
+		memcpy (&w, b, 2);
+		res ^= w;
+	}
+	return res;
+}
+
+static int ref_parity(const ut8 *b, ut64 len) {
+	int ones = 0, k;
+	while (len--) {
+		for (k = 0; k < 8; k++)
+			ones += (*b >> k) & 1;
+		b++;
+	}
+	return ones % 2;
+}
+
+static ut8 ref_mod255(const ut8 *b, ut64 len) {
+	int c = 0;
+	while (len--)
+		c += *b++;
+	return c % 255;
+}
+
+static ut8 ref_hamdist(const ut8 *b, int len) {
+	int i, k, x = 0;
+	for (i = 0; i < len; i++) {
+		int v = x ^ b[i];
+		for (x = 0, k = 0; k < 8; k++)
+			x += (v >> k) & 1;
+	}
+	return x;
+}
+
+#define CHECK(name, a, b) if ((a) != (b)) { \
+	printf ("FAIL %s on %d bytes at %d\n", name, len, off); fail++; }
+
+static int check(const ut8 *buf) {
+	int off, len, fail = 0;
+	for (off = 0; off < 8; off++) {
+		for (len = 0; len < 300; len++) {
+			const ut8 *b = buf + off;
+			CHECK ("crc32", r_hash_crc32 (b, len), ref_crc32 (b, len));
+			CHECK ("crc16", r_hash_crc16 (0, b, len), ref_crc16 (b, len));
+			CHECK ("xor", r_hash_xor (b, len), ref_xor (b, len));
+			CHECK ("xorpair", r_hash_xorpair (b, len), ref_xorpair (b, len));
+			CHECK ("parity", r_hash_parity (b, len), ref_parity (b, len));
+			CHECK ("mod255", r_hash_mod255 (b, len), ref_mod255 (b, len));
+			CHECK ("hamdist", r_hash_hamdist (b, len), ref_hamdist (b, len));
+		}
+	}
+	return fail;
+}
+
+#define BENCH(name, expr) { \
+	r_prof_start (&prof); \
+	for (i = 0; i < loops; i++) sum += (expr); \
+	r_prof_end (&prof); \
+	printf ("%-8s %6.2f GB/s\n", name, (double)size * loops / prof.result / 1e9); }
+
+int main(int argc, char **argv) {
+	int i, size = (argc > 1)? atoi (argv[1]): 0x1000000;
+	int loops = (argc > 2)? atoi (argv[2]): 10;
+	ut8 *buf = malloc (size + 8);
+	ut64 sum = 0;
+	RProfile prof;
+	if (!buf || size < 308)
+		return 1;
+	for (i = 0; i < size + 8; i++)
+		buf[i] = rand ();
+	if (check (buf))
+		return 1;
+	printf ("OK\n");
+	BENCH ("crc32", r_hash_crc32 (buf, size));
+	BENCH ("crc16", r_hash_crc16 (0, buf, size));
+	BENCH ("xor", r_hash_xor (buf, size));
+	BENCH ("xorpair", r_hash_xorpair (buf, size));
+	BENCH ("parity", r_hash_parity (buf, size));
+	BENCH ("mod255", r_hash_mod255 (buf, size));
+	BENCH ("hamdist", r_hash_hamdist (buf, size));
+	BENCH ("adler32", r_hash_adler32 (buf, size));
+	BENCH ("xxhash", r_hash_xxhash (buf, size));
+	free (buf);
+	return sum == 0x1234;
+}
@@ -0,0 +1,71 @@
+/* checks the entropy kernels against the naive formula and times them */
+
+#include <r_hash.h>
+#include <r_util.h>
+#include <math.h>
+
+static double naive(const ut8 *data, ut64 size) {
+	double h = 0, px;
+	ut64 i, count;
+	int x;
+	for (x = 0; x < 256; x++) {
+		for (count = i = 0; i < size; i++)
+			if (data[i] == x) count++;
+		px = (double)count / size;
+		if (px > 0)
+			h += -px * (log (px) / log (2.0));
+	}
+	return h;
+}
+
+int main(int argc, char **argv) {
+	int i, n, fail = 0, size = (argc > 1)? atoi (argv[1]): 0x100000;
+	int window = 4096, step = 64;
+	ut8 *buf = malloc (size);
+	double *map, h = 0;
+	RProfile prof;
+
+	/* text, then random, then zeroes */
+	for (i = 0; i < size; i++) {
+		if (i < size / 3) buf[i] = "radare2"[i % 7];
+		else if (i < 2 * size / 3) buf[i] = rand ();
+		else buf[i] = 0;
+	}
+	for (i = 1; i <= size; i *= 7) {
+		if (r_hash_entropy (buf, i) != naive (buf, i)) {
+			printf ("FAIL entropy of %d bytes\n", i);
+			fail++;
+		}
+	}
+	map = malloc (sizeof (double) * ((size - window) / step + 1));
+	n = r_hash_entropy_map (buf, size, window, step, map);
+	for (i = 0; i < n; i++) {
+		if (fabs (map[i] - r_hash_entropy (buf + i * step, window)) > 1e-9) {
+			printf ("FAIL window at %d\n", i * step);
+			fail++;
+			break;
+		}
+	}
+	printf ("%s (%d windows)\n", fail? "FAIL": "OK", n);
+
+	r_prof_start (&prof);
+	h = r_hash_entropy (buf, size);
+	r_prof_end (&prof);
+	printf ("entropy     %f  %.2f MB/s\n", h, size / prof.result / 1e6);
+	r_prof_start (&prof);
+	h = naive (buf, size);
+	r_prof_end (&prof);
+	printf ("naive       %f  %.2f MB/s\n", h, size / prof.result / 1e6);
+	r_prof_start (&prof);
+	r_hash_entropy_map (buf, size, window, step, map);
+	r_prof_end (&prof);
+	printf ("map %d/%d  %.3fs\n", window, step, prof.result);
+	r_prof_start (&prof);
+	for (i = 0; i < n; i++)
+		map[i] = r_hash_entropy (buf + i * step, window);
+	r_prof_end (&prof);
+	printf ("blocks %d/%d %.3fs\n", window, step, prof.result);
+	free (map);
+	free (buf);
+	return fail;
+}
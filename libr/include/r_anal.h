@@ -35,9 +35,6 @@ R_LIB_VERSION_HEADER(r_anal);
 */
 #define R_ANAL_BB_HAS_OPS 0
 
-/* TODO: work in progress */
-#define USE_NEW_FCN_STORE 0
-
 // TODO: Remove this define? /cc @nibble_ds
 #define VERBOSE_ANAL if(0)
 
@@ -266,11 +263,6 @@ struct r_anal_attr_t {
 	RAnalAttr *next;
 };
 
-typedef struct r_anal_fcn_store_t {
-	RHashTable64 *h;
-	RList *l;
-} RAnalFcnStore;
-
 /* Store various function information,
  * variables, arguments, refs and even
  * description */
@@ -567,6 +559,20 @@ typedef struct r_anal_options_t {
 	int nopskip; // skip nops at the beginning of functions
 } RAnalOptions;
 
+/* sorted adjacency array used by xrefs.c */
+typedef struct r_anal_xrefs_item_t {
+	ut64 addr; // from in anal->xrefs_from, to in anal->xrefs_to
+	ut64 other;
+	int type;
+} RAnalXrefsItem;
+
+typedef struct r_anal_xrefs_index_t {
+	RAnalXrefsItem *items;
+	int length;
+	int sorted; // items past this one are pending to be sorted and merged
+	int size;
+} RAnalXrefsIndex;
+
 typedef struct r_anal_t {
 	char *cpu;
 	int bits;
@@ -577,7 +583,7 @@ typedef struct r_anal_t {
 	void *user;
 	ut64 gp; // global pointer. used for mips. but can be used by other arches too in the future
 	RList *fcns;
-	RListRange *fcnstore;
+	RITree *fcn_tree; // interval index of fcns, see fcnstore.c
 	RList *refs;
 	RList *vartypes;
 	RReg *reg;
@@ -600,7 +606,9 @@ typedef struct r_anal_t {
 	RAnalRange *limit;
 	//struct list_head anals; // TODO: Reimplement with RList
 	RList *plugins;
-	Sdb *sdb_xrefs;
+	Sdb *sdb_xrefs; // only used to import and export the xrefs index
+	RAnalXrefsIndex *xrefs_from;
+	RAnalXrefsIndex *xrefs_to;
 	Sdb *sdb_types;
 	Sdb *sdb_meta; // TODO: Future r_meta api
 	RSpaces meta_spaces;
@@ -812,11 +820,6 @@ typedef struct r_anal_cycle_hook_t {	//rename ?
 	int cycles;
 } RAnalCycleHook;
 
-typedef struct r_anal_esil_word_t {
-	int type;
-	const char *str;
-} RAnalEsilWord;
-
 // only flags that affect control flow
 enum {
 	R_ANAL_ESIL_FLAG_ZERO = 1,
@@ -916,6 +919,40 @@ typedef struct r_anal_reil {
 #define ESIL_INTERNAL_PREFIX	'$'		//must be a char
 #define ESIL struct r_anal_esil_t
 
+#define R_ANAL_ESIL_CACHE_SIZE 1024
+
+enum {
+	R_ANAL_ESIL_WORD_PUSH = 0,
+	R_ANAL_ESIL_WORD_NUM,	// immediate
+	R_ANAL_ESIL_WORD_REG,	// register
+	R_ANAL_ESIL_WORD_OP,
+	R_ANAL_ESIL_WORD_ELSE,	// }{
+	R_ANAL_ESIL_WORD_ENDIF,	// }
+};
+
+/* expression split in words with the operators already resolved */
+typedef struct r_anal_esil_word_t {
+	int type;
+	const char *str;
+	int end; // offset of the next word in the expression
+	int (*op)(ESIL *esil);
+	ut64 num;
+	RRegItem *reg;
+} RAnalEsilWord;
+
+typedef struct r_anal_esil_code_t {
+	ut64 addr;
+	char *expr;
+	char *buf; // expr with the commas replaced by nulls
+	RAnalEsilWord *words;
+	int length;
+	int trailing; // expr ends with a comma
+	RReg *reg; // registers were resolved in this profile
+	int reg_gen;
+	int cached;
+	int running; // do not free while an op is parsing another expression
+} RAnalEsilCode;
+
 typedef struct r_anal_esil_callbacks_t {
 	void *user;
 	/* callbacks */
@@ -934,6 +971,8 @@ typedef struct r_anal_esil_callbacks_t {
 typedef struct r_anal_esil_t {
 	RAnal *anal;
 	char *stack[32];
+	RAnalEsilWord *stack_word[32]; // operands pushed without their string
+	RAnalEsilWord stack_num[32]; // numbers pushed by the ops
 	int stackptr;
 	int skip;
 	int nowrite;
@@ -963,6 +1002,7 @@ typedef struct r_anal_esil_t {
 	int trace_idx;
 	RAnalEsilCallbacks cb;
 	RAnalReil *Reil;
+	RAnalEsilCode **cache; // compiled expressions indexed by address
 	char *cmd_intr; // r2 (external) command to run when an interrupt occurs
 	char *cmd_trap; // r2 (external) command to run when an interrupt occurs
 	int (*cmd)(ESIL *esil, const char *name, int a0, int a1);
@@ -1078,15 +1118,14 @@ typedef struct r_anal_plugin_t {
 
 
 #ifdef R_API
-/* --------- */ /* REFACTOR */ /* ---------- */
-R_API RListRange* r_listrange_new (void);
-R_API void r_listrange_free(RListRange *s);
-R_API void r_listrange_add(RListRange *s, RAnalFunction *f);
-R_API void r_listrange_del(RListRange *s, RAnalFunction *f);
-R_API void r_listrange_resize(RListRange *s, RAnalFunction *f, int newsize);
-R_API RAnalFunction *r_listrange_find_in_range(RListRange* s, ut64 addr);
-R_API RAnalFunction *r_listrange_find_root(RListRange* s, ut64 addr);
-/* --------- */ /* REFACTOR */ /* ---------- */
+/* fcnstore.c */
+R_API void r_anal_fcn_tree_insert(RAnal *anal, RAnalFunction *fcn);
+R_API void r_anal_fcn_tree_delete(RAnal *anal, RAnalFunction *fcn);
+R_API void r_anal_fcn_tree_update(RAnal *anal, RAnalFunction *fcn);
+R_API void r_anal_fcn_tree_purge(RAnal *anal);
+R_API RAnalFunction *r_anal_fcn_tree_in(RAnal *anal, ut64 addr, int type);
+R_API RAnalFunction *r_anal_fcn_tree_at(RAnal *anal, ut64 addr, int type);
+R_API RAnalFunction *r_anal_fcn_tree_next(RAnal *anal, ut64 addr);
 /* type.c */
 R_API RAnalType *r_anal_type_new(void);
 R_API void r_anal_type_add(RAnal *l, RAnalType *t);
@@ -1154,6 +1193,10 @@ R_API _Bool r_anal_esil_set_pc (RAnalEsil *esil, ut64 addr);
 R_API int r_anal_esil_setup (RAnalEsil *esil, RAnal *anal, int romem, int stats);
 R_API void r_anal_esil_free (RAnalEsil *esil);
 R_API int r_anal_esil_parse (RAnalEsil *esil, const char *str);
+R_API RAnalEsilCode *r_anal_esil_compile (RAnalEsil *esil, const char *str);
+R_API void r_anal_esil_code_free (RAnalEsilCode *code);
+R_API int r_anal_esil_code_run (RAnalEsil *esil, RAnalEsilCode *code);
+R_API void r_anal_esil_cache_flush (RAnalEsil *esil);
 R_API int r_anal_esil_dumpstack (RAnalEsil *esil);
 R_API int r_anal_esil_mem_read (RAnalEsil *esil, ut64 addr, ut8 *buf, int len);
 R_API int r_anal_esil_mem_write (RAnalEsil *esil, ut64 addr, const ut8 *buf, int len);
@@ -1239,7 +1282,8 @@ R_API char *r_anal_fcn_to_string(RAnal *a, RAnalFunction* fs);
 R_API int r_anal_str_to_fcn(RAnal *a, RAnalFunction *f, const char *_str);
 R_API int r_anal_fcn_count (RAnal *a, ut64 from, ut64 to);
 R_API RAnalBlock *r_anal_fcn_bbget(RAnalFunction *fcn, ut64 addr); // default 20
-R_API int r_anal_fcn_resize (RAnalFunction *fcn, int newsize);
+R_API int r_anal_fcn_resize (RAnal *anal, RAnalFunction *fcn, int newsize);
+R_API void r_anal_fcn_set_size (RAnal *anal, RAnalFunction *fcn, ut32 size);
 
 #if 0
 #define r_anal_fcn_get_refs(x) x->refs
@@ -1250,6 +1294,9 @@ R_API int r_anal_fcn_resize (RAnalFunction *fcn, int newsize);
 R_API const char *r_anal_xrefs_type_tostring (char type);
 R_API RList *r_anal_xrefs_get (RAnal *anal, ut64 to);
 R_API RList *r_anal_xrefs_get_from (RAnal *anal, ut64 from);
+R_API RList *r_anal_xrefs_get_range (RAnal *anal, ut64 from, ut64 to);
+R_API RList *r_anal_xrefs_get_from_range (RAnal *anal, ut64 from, ut64 to);
+R_API int r_anal_xrefs_count (RAnal *anal);
 R_API void r_anal_xrefs_list(RAnal *anal, int rad);
 R_API RList* r_anal_fcn_get_refs (RAnalFunction *anal);
 R_API RList* r_anal_fcn_get_xrefs (RAnalFunction *anal);
@@ -1257,6 +1304,8 @@ R_API int r_anal_xrefs_from (RAnal *anal, RList *list, const char *kind, const R
 R_API int r_anal_xrefs_set (RAnal *anal, const RAnalRefType type, ut64 from, ut64 to);
 R_API int r_anal_xrefs_deln (RAnal *anal, const RAnalRefType type, ut64 from, ut64 to);
 R_API void r_anal_xrefs_save(RAnal *anal, const char *prjfile);
+R_API int r_anal_xrefs_export(RAnal *anal);
+R_API int r_anal_xrefs_import(RAnal *anal);
 R_API RList* r_anal_fcn_get_vars (RAnalFunction *anal);
 R_API RList* r_anal_fcn_get_bbs (RAnalFunction *anal);
 R_API RList* r_anal_get_fcns (RAnal *anal);
@@ -1298,6 +1347,7 @@ R_API int r_anal_project_load(RAnal *anal, const char *prjfile);
 R_API int r_anal_project_save(RAnal *anal, const char *prjfile);
 R_API int r_anal_xrefs_load(RAnal *anal, const char *prjfile);
 R_API int r_anal_xrefs_init (RAnal *anal);
+R_API void r_anal_xrefs_fini (RAnal *anal);
 
 #define R_ANAL_THRESHOLDFCN 0.7F
 #define R_ANAL_THRESHOLDBB 0.7F
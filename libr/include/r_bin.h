@@ -29,6 +29,16 @@ R_LIB_VERSION_HEADER (r_bin);
 #define R_BIN_DBG_SYMS     0x08
 #define R_BIN_DBG_RELOCS   0x10
 
+/* RBinObject lists loaded on first access, clear the bit to reload */
+#define R_BIN_ITEM_LIBS    0x01
+#define R_BIN_ITEM_RELOCS  0x02
+#define R_BIN_ITEM_STRINGS 0x04
+#define R_BIN_ITEM_CLASSES 0x08
+#define R_BIN_ITEM_LINES   0x10
+#define R_BIN_ITEM_MEM     0x20
+#define R_BIN_ITEM_LANG    0x40
+#define R_BIN_ITEM_ALL     0x7f
+
 #define R_BIN_SIZEOF_STRINGS 512
 #define R_BIN_MAX_ARCH 1024
 
@@ -140,10 +150,31 @@ typedef struct r_bin_object_t {
 	struct r_bin_plugin_t *plugin;
 	int referenced;
 	int lang;
+	int loaded; // R_BIN_ITEM_* already loaded
 	Sdb *kv;
 	void *bin_obj; // internal pointer used by formats
 } RBinObject;
 
+typedef struct r_bin_addrline_t {
+	ut64 addr;
+	ut32 file; // index in RBinAddrlines.files
+	ut32 line;
+} RBinAddrline;
+
+/* address to file:line rows from the debug info, in parse order */
+typedef struct r_bin_addrlines_t {
+	RBinAddrline *rows;
+	int count;
+	int size;
+	ut32 *sorted;     // row indexes by address, built on the first lookup
+	char **files;     // file names as shown, by file index
+	char **paths;     // file paths as found in the debug info
+	int nfiles;
+	RHashTable64 *ht; // hash of the path -> file index + 1
+	int synced;       // sdb_addrinfo holds the rows and is used instead
+	int exported;     // rows already copied to sdb_addrinfo
+} RBinAddrlines;
+
 // XXX: this is a copy of RBinObject
 typedef struct r_bin_file_t {
 	char *file;
@@ -166,9 +197,17 @@ typedef struct r_bin_file_t {
 	Sdb *sdb;
 	Sdb *sdb_info;
 	Sdb *sdb_addrinfo;
+	RBinAddrlines *addrlines;
 	struct r_bin_t *rbin;
 } RBinFile;
 
+/* demangled names by language type and mangled name, failures included */
+typedef struct r_bin_demangle_cache_t {
+	RHashTable64 *ht; // hash of the mangled name -> entry chain
+	RThreadLock *lock;
+	int count;
+} RBinDemangleCache;
+
 typedef struct r_bin_t {
 	const char *file;
 	RBinFile *cur;
@@ -188,6 +227,7 @@ typedef struct r_bin_t {
 	char *force;
 	int is_debugger;
 	int filter;
+	RBinDemangleCache *demangle_cache;
 } RBin;
 
 typedef int (*FREE_XTR)(void *xtr_obj);
@@ -414,6 +454,9 @@ R_API ut64 r_bin_get_boffset(RBin *bin);
 R_API RBinAddr* r_bin_get_sym(RBin *bin, int sym);
 
 R_API char* r_bin_demangle(RBinFile *binfile, const char *lang, const char *str);
+R_API int r_bin_demangle_symbols(RBinFile *binfile, const char *lang, RList *symbols);
+R_API RBinDemangleCache *r_bin_demangle_cache_new(void);
+R_API void r_bin_demangle_cache_free(RBinDemangleCache *dc);
 R_API int r_bin_demangle_type (const char *str);
 R_API char *r_bin_demangle_java(const char *str);
 R_API char *r_bin_demangle_cxx(const char *str);
@@ -466,6 +509,7 @@ R_API int r_bin_object_delete (RBin *bin, ut32 binfile_id, ut32 binobj_id);
 R_API int r_bin_use_arch(RBin *bin, const char *arch, int bits, const char *name);
 R_API RBinFile * r_bin_file_find_by_arch_bits(RBin *bin, const char *arch, int bits, const char *name);
 R_API RBinObject * r_bin_object_find_by_arch_bits (RBinFile *binfile, const char *arch, int bits, const char *name);
+R_API int r_bin_object_load_items(RBinFile *binfile, RBinObject *o, int items);
 R_API void r_bin_list_archs(RBin *bin, int mode);
 R_API void r_bin_set_user_ptr(RBin *bin, void *user);
 R_API RBuffer *r_bin_create (RBin *bin, const ut8 *code, int codelen, const ut8 *data, int datalen);
@@ -487,6 +531,14 @@ R_API void r_bin_force_plugin (RBin *bin, const char *pname);
 R_API int r_bin_addr2line(RBin *bin, ut64 addr, char *file, int len, int *line);
 R_API char *r_bin_addr2text(RBin *bin, ut64 addr);
 R_API char *r_bin_addr2fileline(RBin *bin, ut64 addr);
+R_API RBinAddrlines *r_bin_addrlines_new(void);
+R_API void r_bin_addrlines_free(RBinAddrlines *al);
+R_API void r_bin_addrlines_reset(RBinAddrlines *al);
+R_API int r_bin_addrlines_file(RBinAddrlines *al, const char *path);
+R_API int r_bin_addrlines_add(RBinAddrlines *al, ut64 addr, int file, ut32 line);
+R_API int r_bin_addrlines_sort(RBinAddrlines *al);
+R_API RBinAddrline *r_bin_addrlines_get(RBinAddrlines *al, ut64 addr);
+R_API void r_bin_addrlines_sync(RBinFile *bf);
 /* bin_write.c */
 R_API ut64 r_bin_wr_scn_resize(RBin *bin, const char *name, ut64 size);
 R_API int r_bin_wr_rpath_del(RBin *bin);
@@ -502,6 +554,7 @@ R_API void r_bin_demangle_list(RBin *bin);
 R_API char *r_bin_demangle_plugin(RBin *bin, const char *name, const char *str);
 
 R_API RList *r_bin_get_mem (RBin *bin);
+R_API RList *r_bin_get_lines (RBin *bin);
 
 /* filter.c */
 R_API void r_bin_filter_name(Sdb *db, ut64 addr, char *name, int maxlen);
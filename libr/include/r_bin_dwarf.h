@@ -706,6 +706,7 @@ typedef struct {
 typedef struct {
 	char *name;
 	ut32 id_idx, mod_time, file_len;
+	int file_id; // index in the RBinFile.addrlines files
 } file_entry;
 
 typedef struct {
@@ -30,6 +30,7 @@ extern "C" {
 /* constants */
 #define CONS_MAX_USER 102400
 #define CONS_BUFSZ 0x4f00
+#define CONS_STREAM_CHUNK 0x10000
 #define STR_IS_NULL(x) (!x || !x[0])
 
 /* palette */
@@ -43,6 +44,7 @@ R_LIB_VERSION_HEADER(r_cons);
 
 typedef struct r_cons_grep_t {
 	char strings[R_CONS_GREP_WORDS][R_CONS_GREP_WORD_SIZE];
+	int lens[R_CONS_GREP_WORDS]; // length of each of the strings
 	int nstrings;
 	char *str;
 	int counter;
@@ -170,6 +172,8 @@ typedef struct r_cons_t {
 	int fix_columns;
 	bool breaked;
 	int noflush;
+	int stream; // write complete lines as they come, see r_cons_set_stream
+	int streamed; // bytes already written by the stream since the last flush
 	FILE *fdin; // FILE? and then int ??
 	int fdout; // only used in pipe.c :?? remove?
 	const char *teefile;
@@ -378,6 +382,7 @@ R_API char *r_cons_swap_ground(const char *col);
 R_API void r_cons_set_raw(int b);
 R_API void r_cons_set_interactive(int b);
 R_API void r_cons_set_last_interactive(void);
+R_API int r_cons_set_stream(int enable);
 
 /* output */
 R_API void r_cons_printf(const char *format, ...);
@@ -431,6 +436,7 @@ R_API const char *r_cons_get_buffer(void);
 R_API void r_cons_grep(const char *str);
 R_API int r_cons_grep_line(char *buf, int len); // must be static
 R_API int r_cons_grepbuf(char *buf, int len);
+R_API int r_cons_grep_lines(char *buf, int len);
 
 R_API void r_cons_rgb (ut8 r, ut8 g, ut8 b, int is_bg);
 R_API void r_cons_rgb_fgbg (ut8 r, ut8 g, ut8 b, ut8 R, ut8 G, ut8 B);
@@ -48,6 +48,9 @@ R_API int r_diff_set_callback(RDiff *d, RDiffCallback callback, void *user);
 R_API int r_diff_buffers_distance(RDiff *d,
 	const ut8 *a, ut32 la, const ut8 *b, ut32 lb, ut32 *distance,
 	double *similarity);
+R_API int r_diff_buffers_distance_limit(RDiff *d,
+	const ut8 *a, ut32 la, const ut8 *b, ut32 lb, ut32 *distance,
+	double *similarity, double threshold);
 /* static method !??! */
 R_API int r_diff_lines(const char *file1, const char *sa, int la, const char *file2, const char *sb, int lb);
 R_API int r_diff_set_delta(RDiff *d, int delta);
@@ -47,9 +47,9 @@ typedef struct r_flag_t {
 	char *spaces[R_FLAG_SPACES_MAX];
 	RNum *num;
 #if USE_HT
-	RHashTable64 *ht_off;
 	RHashTable64 *ht_name;
 #endif
+	RITree *by_off; /* lists of items at each offset, sorted by offset */
 #if USE_BTREE
 	struct btree_node *tree; /* index by offset */
 	struct btree_node *ntree; /* index by name */
@@ -97,6 +97,7 @@ R_API void r_flag_item_set_comment(RFlagItem *item, const char *comment);
 R_API int r_flag_unset_glob(RFlag *f, const char *name);
 R_API int r_flag_rename(RFlag *f, RFlagItem *item, const char *name);
 R_API RFlagItem *r_flag_get_at(RFlag *f, ut64 off);
+R_API RFlagItem *r_flag_get_after(RFlag *f, ut64 off);
 R_API int r_flag_relocate (RFlag *f, ut64 off, ut64 off_mask, ut64 to);
 R_API int r_flag_move (RFlag *f, ut64 at, ut64 to);
 R_API const char *r_flag_color(RFlag *f, RFlagItem *it, const char *color);
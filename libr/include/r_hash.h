@@ -54,6 +54,16 @@ struct r_hash_t {
 	ut8 digest[128];
 };
 
+/* histogram of a sliding window, see r_hash_entropy_new */
+typedef struct r_hash_entropy_t {
+	ut32 count[256];
+	ut64 size;
+	ut32 max;
+	double *clogc;
+	double sum;
+	ut64 updates;
+} RHashEntropy;
+
 typedef struct r_hash_seed_t {
 	int prefix;
 	ut8 *buf;
@@ -131,6 +141,13 @@ R_API ut8  r_hash_hamdist(const ut8 *buf, int len);
 R_API double r_hash_entropy(const ut8 *data, ut64 len);
 R_API double r_hash_entropy_fraction(const ut8 *data, ut64 len);
 R_API int r_hash_pcprint(const ut8 *buffer, ut64 len);
+R_API RHashEntropy *r_hash_entropy_new(int max);
+R_API void r_hash_entropy_free(RHashEntropy *e);
+R_API void r_hash_entropy_reset(RHashEntropy *e);
+R_API void r_hash_entropy_add(RHashEntropy *e, const ut8 *buf, int len);
+R_API void r_hash_entropy_del(RHashEntropy *e, const ut8 *buf, int len);
+R_API double r_hash_entropy_get(RHashEntropy *e);
+R_API int r_hash_entropy_map(const ut8 *data, ut64 size, int window, int step, double *out);
 
 /* lifecycle */
 R_API void r_hash_do_begin(RHash *ctx, int flags);
@@ -62,6 +62,20 @@ typedef struct r_io_section_t {
 	int fd;
 } RIOSection;
 
+/* lookup trees of io->sections, rebuilt on the next query after a change */
+typedef struct r_io_section_index_t {
+	RITree *vaddr; // [vaddr, vaddr + vsize)
+	RITree *paddr; // [offset, offset + size)
+	RITree *vsize; // [vaddr, vaddr + size), as r_io_section_next sees them
+	int dirty;
+} RIOSectionIndex;
+
+/* lookup tree of io->maps, rebuilt on the next query after a change */
+typedef struct r_io_map_index_t {
+	RITree *tree; // [from, to)
+	int dirty;
+} RIOMapIndex;
+
 typedef struct r_io_desc_t {
 	int fd;
 	int flags;
@@ -137,10 +151,12 @@ typedef struct r_io_t {
 	RList *sections;
 	int next_section_id;
 	RIOSection *section; /* current section (cache) */
+	RIOSectionIndex secindex;
 	/* maps */
 	RList *maps; /*<RIOMap>*/
+	RIOMapIndex mapindex;
 	RList *files;
-	RList *cache;
+	RITree *cache; /*<RIOCache>*/
 	RCache *buffer;
 	int buffer_enabled;
 	int ff;
@@ -197,6 +213,7 @@ typedef RIODesc* (*RIODescOpen)(RIO *io, const char *file, int flags, int mode);
 typedef RIODesc* (*RIODescOpenAt)(RIO *io, const char *file, int flags, int mode, ut64 maddr);
 typedef int (*RIODescClose)(RIO *io, RIODesc *);
 typedef ut8 * (*RIODescRead)(RIO *io, RIODesc *desc, ut64 *sz);
+typedef RBuffer * (*RIODescMmap)(RIO *io, RIODesc *desc);
 typedef ut64 (*RIODescSeek)(RIO *io, RIODesc *desc, ut64 offset);
 typedef ut64 (*RIODescSize)(RIO *io, RIODesc *desc);
 typedef int (*RIOIsValidOffset)(RIO *io, ut64 addr, int hasperm);
@@ -227,6 +244,7 @@ typedef struct r_io_bind_t {
 	RIODescOpenAt desc_open_at;		//esil-gb needs that to allocate mem on init
 	RIODescClose desc_close;
 	RIODescRead desc_read;
+	RIODescMmap desc_mmap;
 	RIODescSize desc_size;
 	RIODescSeek desc_seek;
 	RIODescGetFD desc_get_by_fd;
@@ -344,6 +362,7 @@ R_API int r_io_cache_invalidate(RIO *io, ut64 from, ut64 to);
 R_API void r_io_cache_commit(RIO *io, ut64 from, ut64 to);
 R_API void r_io_cache_enable(RIO *io, int read, int write);
 R_API void r_io_cache_init(RIO *io);
+R_API void r_io_cache_fini(RIO *io);
 R_API int r_io_cache_list(RIO *io, int rad);
 R_API void r_io_cache_reset(RIO *io, int set);
 R_API int r_io_cache_write(RIO *io, ut64 addr, const ut8 *buf, int len);
@@ -351,6 +370,8 @@ R_API int r_io_cache_read(RIO *io, ut64 addr, ut8 *buf, int len);
 
 /* io/map.c */
 R_API void r_io_map_init(RIO *io);
+R_API void r_io_map_fini(RIO *io);
+R_API void r_io_map_index_invalidate(RIO *io);
 R_API _Bool r_io_map_overlaps (RIO *io, RIODesc *fd, RIOMap *map);
 R_API ut64 r_io_map_next(RIO *io, ut64 addr);
 R_API RIOMap *r_io_map_add(RIO *io, int fd, int flags, ut64 delta, ut64 offset, ut64 size);
@@ -390,6 +411,8 @@ R_API int r_io_section_set_archbits(RIO *io, ut64 addr, const char *arch, int bi
 R_API const char *r_io_section_get_archbits(RIO* io, ut64 addr, int *bits);
 R_API void r_io_section_clear(RIO *io);
 R_API int r_io_section_rm(RIO *io, int idx);
+R_API void r_io_section_fini(RIO *io);
+R_API void r_io_section_index_invalidate(RIO *io);
 R_API int r_io_section_rm_all (RIO *io, int fd);
 R_API void r_io_section_list(RIO *io, ut64 offset, int rad);
 R_API void r_io_section_list_visual(RIO *io, ut64 seek, ut64 len, int width, int color);
@@ -445,6 +468,7 @@ R_API int r_io_desc_add(RIO *io, RIODesc *desc);
 R_API int r_io_desc_del(RIO *io, int fd);
 R_API RIODesc *r_io_desc_get(RIO *io, int fd);
 R_API ut64 r_io_desc_size(RIO *io, RIODesc *desc);
+R_API RBuffer *r_io_desc_mmap(RIO *io, RIODesc *desc);
 R_API ut64 r_io_fd_size(RIO *io, int fd);
 R_API ut64 r_io_desc_seek (RIO *io, RIODesc *desc, ut64 offset);
 R_API void r_io_desc_list (RIO *io);
@@ -94,6 +94,7 @@ typedef struct r_reg_t {
 	int arch;
 	int bits;
 	int size;
+	int gen; // bumped every time the items are freed
 	bool is_thumb;
 	bool big_endian;
 } RReg;
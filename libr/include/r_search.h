@@ -24,6 +24,7 @@ enum {
 };
 
 #define R_SEARCH_DISTANCE_MAX 10
+#define R_SEARCH_THREADS_MAX 64
 
 #define R_SEARCH_KEYWORD_TYPE_BINARY 'i'
 #define R_SEARCH_KEYWORD_TYPE_STRING 's'
@@ -48,6 +49,8 @@ typedef struct r_search_hit_t {
 	ut64 addr;
 } RSearchHit;
 
+typedef struct r_search_ac_t RSearchAC;
+
 typedef int (*RSearchUpdate)(void *s, ut64 from, const ut8 *buf, int len);
 typedef int (*RSearchCallback)(RSearchKeyword *kw, void *user, ut64 where);
 
@@ -68,6 +71,7 @@ typedef struct r_search_t {
 	int align;
 	RSearchUpdate update;
 	RList *kws; // TODO: Use r_search_kw_new ()
+	RSearchAC *ac; // keyword automaton, built on first update
 	RIOBind iob;
 	char bckwrds;
 } RSearch;
@@ -84,6 +88,7 @@ R_API RSearch *r_search_free(RSearch *s);
 R_API RList *r_search_find(RSearch *s, ut64 addr, const ut8 *buf, int len);
 R_API int r_search_update(RSearch *s, ut64 *from, const ut8 *buf, long len);
 R_API int r_search_update_i(RSearch *s, ut64 from, const ut8 *buf, long len);
+R_API int r_search_update_threads(RSearch *s, ut64 from, const ut8 *buf, long len, int n);
 
 R_API void r_search_keyword_free (RSearchKeyword *kw);
 R_API RSearchKeyword* r_search_keyword_new(const ut8 *kw, int kwlen, const ut8 *bm, int bmlen, const char *data);
@@ -112,6 +117,11 @@ R_API int r_search_deltakey_update(void *s, ut64 from, const ut8 *buf, int len);
 R_API int r_search_strings_update(void *s, ut64 from, const ut8 *buf, int len);
 R_API int r_search_regexp_update(void *s, ut64 from, const ut8 *buf, int len);
 R_API int r_search_xrefs_update(void *s, ut64 from, const ut8 *buf, int len);
+R_API RSearchAC *r_search_ac_new(RList *kws);
+R_API void r_search_ac_free(RSearchAC *ac);
+R_API void r_search_ac_reset(RSearchAC *ac);
+R_API int r_search_ac_update(RSearch *s, ut64 from, const ut8 *buf, int len);
+R_API int r_search_ac_update_threads(RSearch *s, ut64 from, const ut8 *buf, int len, int n);
 R_API int r_search_hit_new(RSearch *s, RSearchKeyword *kw, ut64 addr);
 R_API void r_search_set_distance(RSearch *s, int dist);
 R_API int r_search_strings(RSearch *s, ut32 min, ut32 max);
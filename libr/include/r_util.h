@@ -118,6 +118,7 @@ typedef struct r_buf_t {
 	ut64 base;
 	RMmap *mmap;
 	ut8 empty;
+	ut8 ro; // buf is borrowed or mapped read-only, copied on first write
 	RList *sparse;
 } RBuffer;
 
@@ -216,13 +217,6 @@ typedef struct r_mixed_t {
 } RMixed;
 
 
-/* TODO : THIS IS FROM See libr/anal/fcnstore.c for refactoring info */
-typedef struct r_list_range_t {
-	RHashTable64 *h;
-	RList *l;
-	//RListComparator c;
-} RListRange;
-
 /* stack api */
 typedef struct r_stack_t {
 	void **elems;
@@ -264,6 +258,26 @@ typedef struct r_tree_visitor_t {
 } RTreeVisitor;
 typedef void (*RTreeNodeVisitCb)(RTreeNode *n, RTreeVisitor *vis);
 
+/* interval tree api */
+typedef struct r_itree_node_t {
+	struct r_itree_node_t *child[2];
+	ut64 from;
+	ut64 to; // not included
+	ut64 max; // greatest 'to' in this subtree
+	ut32 seq; // insertion order, sorts nodes sharing the same 'from'
+	int height;
+	void *data;
+} RITreeNode;
+
+typedef struct r_itree_t {
+	RITreeNode *root;
+	RListFree free;
+	ut32 seq;
+	int length;
+} RITree;
+
+typedef int (*RITreeCallback)(RITreeNode *n, void *user);
+
 /* graph api */
 typedef struct r_graph_node_t {
 	unsigned int idx;
@@ -319,6 +333,21 @@ R_API void r_tree_free (RTree *t);
 R_API void r_tree_dfs (RTree *t, RTreeVisitor *vis);
 R_API void r_tree_bfs (RTree *t, RTreeVisitor *vis);
 
+R_API RITree *r_itree_new (RListFree freefn);
+R_API void r_itree_free (RITree *t);
+R_API void r_itree_purge (RITree *t);
+R_API RITreeNode *r_itree_insert (RITree *t, ut64 from, ut64 to, void *data);
+R_API int r_itree_delete (RITree *t, ut64 from, void *data);
+R_API int r_itree_resize (RITree *t, RITreeNode *node, ut64 to);
+R_API RITreeNode *r_itree_find (RITree *t, ut64 from, void *data);
+R_API RITreeNode *r_itree_first (RITree *t, ut64 from);
+R_API RITreeNode *r_itree_last (RITree *t, ut64 from);
+R_API RITreeNode *r_itree_next (RITree *t, RITreeNode *node);
+R_API RITreeNode *r_itree_prev (RITree *t, RITreeNode *node);
+R_API int r_itree_stab (RITree *t, ut64 addr, RITreeCallback cb, void *user);
+R_API int r_itree_foreach (RITree *t, RITreeCallback cb, void *user);
+R_API int r_itree_length (RITree *t);
+
 R_API RGraphNode *r_graph_get_node (const RGraph *g, unsigned int idx);
 R_API RListIter *r_graph_node_iter (const RGraph *g, unsigned int idx);
 R_API const RList *r_graph_get_nodes (const RGraph *g);
@@ -373,6 +402,7 @@ R_API char* r_num_as_string(RNum *___, ut64 n);
 /* constructors */
 R_API RBuffer *r_buf_new(void);
 R_API RBuffer *r_buf_new_with_bytes(const ut8* bytes, ut64 len);
+R_API RBuffer *r_buf_new_with_pointers(const ut8 *bytes, ut64 len);
 R_API RBuffer *r_buf_file (const char *file);
 R_API RBuffer *r_buf_mmap (const char *file, int flags);
 R_API RBuffer *r_buf_new_sparse();
@@ -652,6 +682,20 @@ R_API int r_utf8_size (const ut8 *ptr);
 R_API int r_utf8_strlen (const ut8 *str);
 R_API int r_isprint (const RRune c);
 
+/* string runs, the wide ones may hold any printable rune */
+#define R_STRSCAN_ASCII 1
+#define R_STRSCAN_UTF16LE 2
+#define R_STRSCAN_UTF16BE 4
+#define R_STRSCAN_UTF32LE 8
+#define R_STRSCAN_UTF32BE 16
+#define R_STRSCAN_ALL 31
+/* ascii runs that also take utf-8 sequences and the \a\b\t\n\v\f\r\e
+ * escapes, reported instead of R_STRSCAN_ASCII */
+#define R_STRSCAN_UTF8 32
+typedef int (*RStrScanCallback)(void *user, int off, int len, int size, int enc);
+R_API int r_str_scan(const ut8 *buf, int len, int min, int max, int encs, RStrScanCallback cb, void *user);
+R_API int r_str_scan_skip(const ut8 *buf, int len);
+
 /* LOG */
 R_API void r_log_msg(const char *str);
 R_API void r_log_error(const char *str);
@@ -1,31 +1,40 @@
 #include "ls.h"
 #include "types.h"
 
-typedef void (*HtKvFreeFunc)(void *);
+typedef struct sdb_kv {
+	char *key;
+	char *value;
+	ut64 expire;
+	int value_len;
+	ut32 cas;
+} SdbKv;
 
 /** ht **/
 typedef struct ht_entry_t {
-	SdbListIter *iter;
 	ut32 hash;
-	void *data;
+	ut32 dist; // probe distance + 1, 0 for free slots
+	SdbKv *kv;
 } SdbHashEntry;
 
+#define HT_POOL_CLASSES 21
+
 typedef struct ht_t {
-	SdbList *list;
+	SdbList *list; // the kvs in insertion order
 	SdbHashEntry *table;
 	ut32 size;
-	ut32 rehash;
-	ut32 max_entries;
-	ut32 size_index;
+	ut32 shift;
 	ut32 entries;
-	ut32 deleted_entries;
+	/* kv storage */
+	void *chunks;
+	ut8 *top;
+	ut8 *end;
+	ut32 chunk_size;
+	void *pool[HT_POOL_CLASSES];
 } SdbHash;
 
-SdbHash* ht_new(SdbListFree f);
+SdbHash* ht_new();
 void ht_free(SdbHash *ht);
-//void ht_set(SdbHash *ht, ut32 hash, void *data);
-SdbHashEntry* ht_search(SdbHash *ht, ut32 hash);
-void *ht_lookup(SdbHash *ht, ut32 hash);
-void ht_set(SdbHash *ht, ut32 hash, void *data);
-int ht_insert(SdbHash *ht, ut32 hash, void *data, SdbListIter *iter);
+SdbHashEntry* ht_search(SdbHash *ht, const char *key, ut32 hash);
+SdbKv *ht_lookup(SdbHash *ht, const char *key, ut32 hash);
+SdbKv *ht_insert(SdbHash *ht, const char *key, ut32 hash);
 void ht_delete_entry(SdbHash *ht, SdbHashEntry *entry);
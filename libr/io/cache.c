@@ -1,8 +1,11 @@
 /* radare - LGPL - Copyright 2008-2015 - pancake */
 
-// TODO: implement a more inteligent way to store cached memory
 // TODO: define limit of max mem to cache
 
+/* cached writes are kept in an interval tree of non-overlapping ranges.
+ * Writes touching or overlapping previous ones are merged into a single
+ * item, so reads only need to look at the few items around them */
+
 #include "r_io.h"
 
 static void cache_item_free(RIOCache *cache) {
@@ -13,142 +16,249 @@ static void cache_item_free(RIOCache *cache) {
 	free (cache);
 }
 
+static RIOCache *cache_item_new(ut64 from, int size) {
+	RIOCache *c = R_NEW0 (RIOCache);
+	if (!c) return NULL;
+	c->from = from;
+	c->to = from + size;
+	c->size = size;
+	c->data = malloc (size);
+	c->odata = malloc (size);
+	if (!c->data || !c->odata) {
+		cache_item_free (c);
+		return NULL;
+	}
+	return c;
+}
+
+/* bytes of the file below the cache */
+static void cache_read_orig(RIO *io, ut64 addr, ut8 *buf, int len) {
+	// we must use raw io here to avoid calling to cacheread and get wrong reads
+	if (r_io_seek (io, addr, R_IO_SEEK_SET)==UT64_MAX)
+		memset (buf, 0xff, len);
+	r_io_read_internal (io, buf, len);
+}
+
+/* write to the file skipping the cache */
+static int cache_write_orig(RIO *io, ut64 addr, const ut8 *buf, int len) {
+	int ret, ioc = io->cached;
+	io->cached = 2; // magic number to skip caching this write
+	r_io_seek (io, addr, R_IO_SEEK_SET);
+	ret = r_io_write (io, buf, len);
+	io->cached = ioc;
+	return ret == len;
+}
+
+/* first item ending after addr */
+static RITreeNode *cache_first(RIO *io, ut64 addr) {
+	RITreeNode *node = r_itree_last (io->cache, addr);
+	if (node && node->to <= addr) {
+		node = r_itree_next (io->cache, node);
+	}
+	return node? node: r_itree_first (io->cache, addr);
+}
+
+/* split the item containing addr in two, so ranges can be handled apart */
+static void cache_split(RIO *io, ut64 addr) {
+	RITreeNode *node = r_itree_last (io->cache, addr);
+	RIOCache *c, *c2;
+	int n;
+	if (!node || node->from == addr || node->to <= addr) {
+		return;
+	}
+	c = node->data;
+	n = addr - c->from;
+	c2 = cache_item_new (addr, c->size - n);
+	if (!c2) return;
+	memcpy (c2->data, c->data + n, c2->size);
+	memcpy (c2->odata, c->odata + n, c2->size);
+	c2->written = c->written;
+	c->size = n;
+	c->to = addr;
+	r_itree_resize (io->cache, node, c->to);
+	r_itree_insert (io->cache, c2->from, c2->to, c2);
+}
+
 R_API void r_io_cache_init(RIO *io) {
-	io->cache = r_list_new ();
-	io->cache->free = (RListFree)cache_item_free;
+	io->cache = r_itree_new ((RListFree)cache_item_free);
 	io->cached = false; // cache write ops
 	io->cached_read = false; // cached read ops
 }
 
+R_API void r_io_cache_fini(RIO *io) {
+	r_itree_free (io->cache);
+	io->cache = NULL;
+}
+
 R_API void r_io_cache_enable(RIO *io, int read, int write) {
 	io->cached = read | write;
 	io->cached_read = read;
 }
 
 R_API void r_io_cache_commit(RIO *io, ut64 from, ut64 to) {
-	RListIter *iter;
+	RITreeNode *node;
 	RIOCache *c;
-
-	int ioc = io->cached;
-	io->cached = 2;
-	r_list_foreach (io->cache, iter, c) {
-		if (c->from >= from && c->to <= to) {
-			if (!r_io_write_at (io, c->from, c->data, c->size))
-				eprintf ("Error writing change at 0x%08"PFMT64x"\n", c->from);
-			else c->written = true;
-			break;
-		}
+	if (from >= to) return;
+	cache_split (io, from);
+	cache_split (io, to);
+	for (node = r_itree_first (io->cache, from); node && node->from < to;
+			node = r_itree_next (io->cache, node)) {
+		c = node->data;
+		if (!cache_write_orig (io, c->from, c->data, c->size))
+			eprintf ("Error writing change at 0x%08"PFMT64x"\n", c->from);
+		else c->written = true;
 	}
-	io->cached = ioc;
 }
 
 R_API void r_io_cache_reset(RIO *io, int set) {
 	io->cached = set;
-	r_list_purge (io->cache);
+	r_itree_purge (io->cache);
 }
 
 R_API int r_io_cache_invalidate(RIO *io, ut64 from, ut64 to) {
-	RListIter *iter;
+	RITreeNode *node, *next;
 	RIOCache *c;
 	int done = false;
-
-	if (from<to) {
-		//r_list_foreach_safe (io->cache, iter, iter_tmp, c) {
-		r_list_foreach (io->cache, iter, c) {
-			if (c->from >= from && c->to <= to) {
-				int ioc = io->cached;
-				io->cached = 2; // magic number to skip caching this write
-				r_io_write_at (io, c->from, c->odata, c->size);
-				io->cached = ioc;
-				if (!c->written)
-					r_list_delete (io->cache, iter);
-				c->written = false;
-				done = true;
-				break;
-			}
+	if (from >= to) return false;
+	cache_split (io, from);
+	cache_split (io, to);
+	for (node = r_itree_first (io->cache, from); node && node->from < to; node = next) {
+		next = r_itree_next (io->cache, node);
+		c = node->data;
+		if (c->written) {
+			// restore the file, but keep the change in the cache
+			cache_write_orig (io, c->from, c->odata, c->size);
+			c->written = false;
+		} else {
+			r_itree_delete (io->cache, c->from, c);
+			cache_item_free (c);
 		}
+		done = true;
 	}
 	return done;
 }
 
-R_API int r_io_cache_list(RIO *io, int rad) {
-	int i, j = 0;
-	RListIter *iter;
-	RIOCache *c;
+typedef struct {
+	RIO *io;
+	int rad;
+	int idx;
+} CacheListQuery;
 
-	r_list_foreach (io->cache, iter, c) {
-		if (rad) {
-			io->cb_printf ("wx ");
-			for (i=0; i<c->size; i++)
-				io->cb_printf ("%02x", c->data[i]);
-			io->cb_printf (" @ 0x%08"PFMT64x, c->from);
-			io->cb_printf (" # replaces: ");
-			for (i=0; i<c->size; i++)
-				io->cb_printf ("%02x", c->odata[i]);
-			io->cb_printf ("\n");
-		} else {
-			io->cb_printf ("idx=%d addr=0x%08"PFMT64x" size=%d ",
-				j, c->from, c->size);
-			for (i=0; i<c->size; i++)
-				io->cb_printf ("%02x", c->odata[i]);
-			io->cb_printf (" -> ");
-			for (i=0; i<c->size; i++)
-				io->cb_printf ("%02x", c->data[i]);
-			io->cb_printf (" %s\n", c->written?"(written)":"(not written)");
-		}
-		j++;
+static int cache_list_cb(RITreeNode *node, void *user) {
+	CacheListQuery *q = user;
+	RIO *io = q->io;
+	RIOCache *c = node->data;
+	int i;
+	if (q->rad) {
+		io->cb_printf ("wx ");
+		for (i=0; i<c->size; i++)
+			io->cb_printf ("%02x", c->data[i]);
+		io->cb_printf (" @ 0x%08"PFMT64x, c->from);
+		io->cb_printf (" # replaces: ");
+		for (i=0; i<c->size; i++)
+			io->cb_printf ("%02x", c->odata[i]);
+		io->cb_printf ("\n");
+	} else {
+		io->cb_printf ("idx=%d addr=0x%08"PFMT64x" size=%d ",
+			q->idx, c->from, c->size);
+		for (i=0; i<c->size; i++)
+			io->cb_printf ("%02x", c->odata[i]);
+		io->cb_printf (" -> ");
+		for (i=0; i<c->size; i++)
+			io->cb_printf ("%02x", c->data[i]);
+		io->cb_printf (" %s\n", c->written?"(written)":"(not written)");
 	}
+	q->idx++;
+	return true;
+}
+
+R_API int r_io_cache_list(RIO *io, int rad) {
+	CacheListQuery q = { io, rad, 0 };
+	r_itree_foreach (io->cache, cache_list_cb, &q);
 	return false;
 }
 
 R_API int r_io_cache_write(RIO *io, ut64 addr, const ut8 *buf, int len) {
-	RIOCache *ch;
+	RITreeNode *node, *next, *first;
+	RIOCache *c, *ch;
+	ut64 from, to, end, at;
 	if (io->cached == 2) // magic hackaround
 		return 0;
-	ch = R_NEW0 (RIOCache);
-	ch->from = addr;
-	ch->to = addr + len;
-	ch->size = len;
-	ch->odata = (ut8*)malloc (len);
-	ch->data = (ut8*)malloc (len);
+	if (len < 1)
+		return 0;
+	end = addr + len;
+	if (end < addr) {
+		// do not wrap around the end of the address space
+		len = UT64_MAX - addr;
+		end = UT64_MAX;
+	}
+	/* grow an unwritten item ending right here instead of adding a new one.
+	 * This is what happens when patching byte after byte */
+	node = r_itree_last (io->cache, addr);
+	if (node && node->to == addr && !((RIOCache*)node->data)->written) {
+		RITreeNode *n2 = r_itree_next (io->cache, node);
+		c = node->data;
+		if (!n2 || n2->from >= end) {
+			ut8 *d = realloc (c->data, c->size + len);
+			ut8 *od = d? realloc (c->odata, c->size + len): NULL;
+			if (d) c->data = d;
+			if (od) {
+				c->odata = od;
+				cache_read_orig (io, addr, c->odata + c->size, len);
+				memcpy (c->data + c->size, buf, len);
+				c->size += len;
+				c->to = end;
+				r_itree_resize (io->cache, node, end);
+				return len;
+			}
+			// could not grow it, merge below
+		}
+	}
+	/* merge with all the items overlapping the write */
+	first = cache_first (io, addr);
+	from = addr;
+	to = end;
+	for (node = first; node && node->from < end; node = r_itree_next (io->cache, node)) {
+		if (node->from < from) from = node->from;
+		if (node->to > to) to = node->to;
+	}
+	ch = cache_item_new (from, (int)(to - from));
+	if (!ch) return 0;
 	ch->written = io->cached? 0: 1;
-#if 1
-	// we must use raw io here to avoid calling to cacheread and get wrong reads
-	if (r_io_seek (io, addr, R_IO_SEEK_SET)==UT64_MAX)
-		memset (ch->odata, 0xff, len);
-	r_io_read_internal (io, ch->odata, len);
-#else
-	r_io_read_at (io, addr, ch->odata, len);
-#endif
-	memcpy (ch->data, buf, len);
-	r_list_append (io->cache, ch);
+	at = from;
+	for (node = first; node && node->from < end; node = next) {
+		next = r_itree_next (io->cache, node);
+		c = node->data;
+		if (c->from > at) {
+			cache_read_orig (io, at, ch->odata + (at - from), c->from - at);
+		}
+		memcpy (ch->odata + (c->from - from), c->odata, c->size);
+		memcpy (ch->data + (c->from - from), c->data, c->size);
+		at = c->to;
+		r_itree_delete (io->cache, c->from, c);
+		cache_item_free (c);
+	}
+	if (at < to) {
+		cache_read_orig (io, at, ch->odata + (at - from), to - at);
+	}
+	memcpy (ch->data + (addr - from), buf, len);
+	r_itree_insert (io->cache, ch->from, ch->to, ch);
 	return len;
 }
 
 R_API int r_io_cache_read(RIO *io, ut64 addr, ut8 *buf, int len) {
-	int l, ret, da, db;
-	RListIter *iter;
+	RITreeNode *node;
 	RIOCache *c;
-
-	r_list_foreach (io->cache, iter, c) {
-		if (r_range_overlap (addr, addr+len-1, c->from, c->to, &ret)) {
-			if (ret>0) {
-				da = ret;
-				db = 0;
-				l = c->size;
-			} else if (ret<0) {
-				da = 0;
-				db = -ret;
-				l = c->size-db;
-			} else {
-				da = 0;
-				db = 0;
-				l = c->size;
-			}
-			if ((l+da)>len) l = len-da;					//say hello to integer overflow, but this won't happen in realistic scenarios because malloc will fail befor
-			if (l<1) l = 1; // XXX: fail
-			else memcpy (buf+da, c->data+db, l);
-		}
+	ut64 from, to, end = addr + len;
+	if (len < 1)
+		return len;
+	if (end < addr) end = UT64_MAX;
+	for (node = cache_first (io, addr); node && node->from < end;
+			node = r_itree_next (io->cache, node)) {
+		c = node->data;
+		from = R_MAX (addr, c->from);
+		to = R_MIN (end, c->to);
+		memcpy (buf + (from - addr), c->data + (from - c->from), to - from);
 	}
 	return len;
 }
@@ -26,6 +26,23 @@ R_API ut64 r_io_desc_size(RIO *io, RIODesc *desc){
 	return sz;
 }
 
+/* read-only mapping of the file behind desc. Only plain local files are
+ * mapped, for anything else NULL is returned and the contents must be
+ * read through the plugin */
+R_API RBuffer *r_io_desc_mmap(RIO *io, RIODesc *desc) {
+	ut64 sz;
+	if (!io || !desc || !desc->name || !desc->plugin || desc->plugin->isdbg)
+		return NULL;
+	if (!desc->plugin->name || strcmp (desc->plugin->name, "default"))
+		return NULL;
+	if (!r_file_is_regular (desc->name))
+		return NULL;
+	sz = r_file_size (desc->name);
+	if (sz == 0 || sz > ST32_MAX)
+		return NULL;
+	return r_buf_mmap (desc->name, R_IO_READ);
+}
+
 R_API RIODesc *r_io_desc_new(RIOPlugin *plugin, int fd, const char *name, int flags, int mode, void *data) {
 	RETURN_IO_DESC_NEW (plugin, fd, name, flags, mode, data);
 }
@@ -73,10 +73,11 @@ R_API RIO *r_io_free(RIO *io) {
 		R_FREE (il);
 	}
 	r_list_free (io->sections);
-	r_list_free (io->maps);
+	r_io_section_fini (io);
+	r_io_map_fini (io);
 	r_list_free (io->undo.w_list);
 	r_cache_free (io->buffer);
-	r_list_free (io->cache);
+	r_io_cache_fini (io);
 	r_io_desc_fini (io);
 	free (io);
 	return NULL;
@@ -361,7 +362,7 @@ int r_io_read_cr (RIO *io, ut64 addr, ut8 *buf, int len) {
 }
 
 R_API int r_io_read_at(RIO *io, ut64 addr, ut8 *buf, int len) {
-	ut64 paddr, last, last2;
+	ut64 paddr, maddr, last, last2;
 	int ms, ret, l = 0, olen = len, w = 0;
 
 	if (!io || !buf || len<0)
@@ -467,16 +468,16 @@ R_API int r_io_read_at(RIO *io, ut64 addr, ut8 *buf, int len) {
 		if (addr != UT64_MAX) {
 			paddr = w? r_io_section_vaddr_to_maddr_try (io, addr+w): addr;
 		} else paddr = 0;
-		//if (!paddr || paddr==UT64_MAX)
+		// one map lookup for the chunk start, used as fallback too
+		maddr = r_io_map_select (io, addr);
 		if (paddr==UT64_MAX) {
-			paddr = r_io_map_select (io, addr); // XXX
+			paddr = maddr;
 		}
 		if (paddr == UT64_MAX) {
 			w +=l;
 			len -= l;
 			continue;
 		}
-		r_io_map_select (io, addr); // XXX
 		if (len>0 && l>len) l = len;
 		addr = paddr-w;
 		if (r_io_seek (io, paddr, R_IO_SEEK_SET)==UT64_MAX) {
@@ -494,7 +495,7 @@ R_API int r_io_read_at(RIO *io, ut64 addr, ut8 *buf, int len) {
 #if USE_CACHE
 		if (io->cached) {
 			r_io_cache_read (io, addr+w, buf+w, len); //-w);
-		} else if (r_list_length (io->maps) >1) {
+		} else if (r_io_map_count (io) >1) {
 			if (!io->debug && ms>0) {
 				//eprintf ("FAIL MS=%d l=%d d=%d\n", ms, l, d);
 				/* check if address is vaddred in sections */
@@ -660,7 +661,9 @@ R_API int r_io_write(RIO *io, const ut8 *buf, int len) {
 		if (io->cached != 2) {
 			eprintf ("r_io_write: cannot write on fd %d\n",
 				io->desc? io->desc->fd: -1);
-			r_io_cache_invalidate (io, io->off, io->off+1);
+			// drop the cached bytes of this write only
+			r_io_cache_invalidate (io, io->off,
+				(io->off + len < io->off)? UT64_MAX: io->off + len);
 		}
 	} else {
 		if (io->desc) {
@@ -857,6 +860,7 @@ R_API int r_io_bind(RIO *io, RIOBind *bnd) {
 	bnd->desc_open_at = r_io_open_at;
 	bnd->desc_close = r_io_close;
 	bnd->desc_read = r_io_desc_read;
+	bnd->desc_mmap = r_io_desc_mmap;
 	bnd->desc_size = r_io_desc_size;
 	bnd->desc_seek = r_io_desc_seek;
 	bnd->desc_get_by_fd = r_io_desc_get;
@@ -913,6 +917,7 @@ R_API int r_io_create (RIO *io, const char *file, int mode, int type) {
 
 R_API void r_io_sort_maps (RIO *io) {
 	r_list_sort (io->maps, (RListComparator) r_io_map_sort);
+	r_io_map_index_invalidate (io);
 }
 
 // THIS IS pread.. a weird one
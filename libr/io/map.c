@@ -7,8 +7,69 @@
 #include <r_util.h>
 #include <r_list.h>
 
+/* Address lookups go through io->mapindex, an interval tree built from
+ * io->maps in list order: the node seq is the position in the list, so
+ * "first map containing addr" keeps its meaning. Whoever changes the
+ * list or a map range must call r_io_map_index_invalidate. */
+
+#define MAPIDX(io) (&(io)->mapindex)
+
+R_API void r_io_map_index_invalidate(RIO *io) {
+	if (io) MAPIDX (io)->dirty = true;
+}
+
+static RITree *mapindex(RIO *io) {
+	RIOMapIndex *mi = MAPIDX (io);
+	RListIter *iter;
+	RIOMap *map;
+	if (mi->tree && !mi->dirty)
+		return mi->tree;
+	if (!mi->tree) {
+		mi->tree = r_itree_new (NULL);
+	} else {
+		r_itree_purge (mi->tree);
+	}
+	r_list_foreach (io->maps, iter, map) {
+		r_itree_insert (mi->tree, map->from, map->to, map);
+	}
+	mi->dirty = false;
+	return mi->tree;
+}
+
+typedef struct {
+	RITreeNode *first; // lowest seq
+	RITreeNode *last; // highest seq
+	RITreeNode *raised; // lowest seq with fd == io->raised
+	int fd;
+	ut64 skipfrom; // ignore the maps starting here
+	int skip;
+} MapQuery;
+
+static int mapindex_cb(RITreeNode *n, void *user) {
+	MapQuery *q = user;
+	RIOMap *map = n->data;
+	if (q->skip && n->from == q->skipfrom)
+		return true;
+	// a wrapped range holds nothing for the list walks either
+	if (map->to < map->from)
+		return true;
+	if (!q->first || n->seq < q->first->seq)
+		q->first = n;
+	if (!q->last || n->seq > q->last->seq)
+		q->last = n;
+	if (map->fd == q->fd && (!q->raised || n->seq < q->raised->seq))
+		q->raised = n;
+	return true;
+}
+
 R_API int r_io_map_count (RIO *io) {
-	return r_list_length (io->maps);
+	return r_itree_length (mapindex (io));
+}
+
+static void mapindex_stab(RIO *io, ut64 addr, MapQuery *q) {
+	memset (q, 0, sizeof (MapQuery));
+	q->fd = io->raised;
+	r_itree_stab (mapindex (io), addr, mapindex_cb, q);
 }
 
 R_API RIOMap * r_io_map_new(RIO *io, int fd, int flags, ut64 delta, ut64 addr, ut64 size) {
@@ -23,11 +84,20 @@ R_API RIOMap * r_io_map_new(RIO *io, int fd, int flags, ut64 delta, ut64 addr, u
 	map->from = addr;
 	map->to = addr + size;
 	r_list_append (io->maps, map);
+	r_io_map_index_invalidate (io);
 	return map;
 }
 
 R_API void r_io_map_init(RIO *io) {
 	io->maps = r_list_new ();
+	memset (MAPIDX (io), 0, sizeof (RIOMapIndex));
+}
+
+R_API void r_io_map_fini(RIO *io) {
+	r_list_free (io->maps);
+	io->maps = NULL;
+	r_itree_free (MAPIDX (io)->tree);
+	memset (MAPIDX (io), 0, sizeof (RIOMapIndex));
 }
 
 R_API int r_io_map_sort(void *_a, void *_b) {
@@ -52,6 +122,7 @@ R_API int r_io_map_write_update(RIO *io, int fd, ut64 addr, ut64 len) {
 	if (map && map->to < addr+len) {
 		res = true;
 		map->to = addr+len;
+		r_io_map_index_invalidate (io);
 	}
 	return res;
 }
@@ -68,18 +139,15 @@ R_API int r_io_map_truncate_update(RIO *io, int fd, ut64 sz) {
 	if (map) {
 		res = true;
 		map->to = map->from+sz;
+		r_io_map_index_invalidate (io);
 	}
 	return res;
 }
 
 R_API RIOMap *r_io_map_get(RIO *io, ut64 addr) {
-	RIOMap *map;
-	RListIter *iter;
-	r_list_foreach (io->maps, iter, map) {
-		if ((map->from <= addr) && (addr < map->to))
-			return map;
-	}
-	return NULL;
+	MapQuery q;
+	mapindex_stab (io, addr, &q);
+	return q.first? q.first->data: NULL;
 }
 
 R_API RIOMap *r_io_map_resolve(RIO *io, int fd) {
@@ -146,16 +214,28 @@ R_API RList *r_io_map_get_maps_in_range(RIO *io, ut64 addr, ut64 endaddr) {
 }
 
 R_API RIOMap * r_io_map_get_first_map_in_range(RIO *io, ut64 addr, ut64 endaddr) {
-	RIOMap *map = NULL;
-	RListIter *iter;
-	r_list_foreach (io->maps, iter, map) {
-		if (map->from <= addr && addr < map->to) break;
-		//if (map->from == addr && endaddr == map->to) r_list_append(maps, map);
-		if (map->from < endaddr && endaddr < map->to) break;
-		if (addr <= map->from && map->to <= endaddr) break;
-		map = NULL;
+	RITree *t = mapindex (io);
+	RITreeNode *n, *first;
+	RIOMap *map;
+	MapQuery q;
+	// maps containing addr
+	mapindex_stab (io, addr, &q);
+	first = q.first;
+	// maps containing endaddr past their start
+	memset (&q, 0, sizeof (q));
+	q.skipfrom = endaddr;
+	q.skip = true;
+	r_itree_stab (t, endaddr, mapindex_cb, &q);
+	if (q.first && (!first || q.first->seq < first->seq))
+		first = q.first;
+	// and the ones lying inside the range
+	for (n = r_itree_first (t, addr); n && n->from <= endaddr; n = r_itree_next (t, n)) {
+		if (first && first->seq < n->seq) continue;
+		map = n->data;
+		if (map->to <= endaddr)
+			first = n;
 	}
-	return map;
+	return first? first->data: NULL;
 }
 
 R_API int r_io_map_del(RIO *io, int fd) {
@@ -169,20 +249,18 @@ R_API int r_io_map_del(RIO *io, int fd) {
 				deleted = true;
 			}
 		}
+		r_io_map_index_invalidate (io);
 	}
 	return deleted;
 }
 
 R_API ut64 r_io_map_next(RIO *io, ut64 addr) {
-	ut64 next = UT64_MAX;
-	RIOMap *map;
-	RListIter *iter;
-	r_list_foreach (io->maps, iter, map) {
-		if (map->from > addr)
-			if (!next || map->from < next)
-				next = map->from;
-	}
-	return next;
+	RITreeNode *n;
+	if (addr == UT64_MAX)
+		return UT64_MAX;
+	// lowest map start after addr
+	n = r_itree_first (mapindex (io), addr + 1);
+	return n? n->from: UT64_MAX;
 }
 
 R_API int r_io_map_del_at(RIO *io, ut64 addr) {
@@ -191,6 +269,7 @@ R_API int r_io_map_del_at(RIO *io, ut64 addr) {
 	r_list_foreach (io->maps, iter, map) {
 		if (map->from <= addr && addr < map->to) {
 			r_list_delete (io->maps, iter);
+			r_io_map_index_invalidate (io);
 			return true;
 		}
 	}
@@ -234,16 +313,9 @@ R_API RIOMap *r_io_map_add(RIO *io, int fd, int flags, ut64 delta, ut64 addr, ut
 }
 
 R_API int r_io_map_exists_for_offset (RIO *io, ut64 off) {
-	int res = false;
-	RIOMap *im = NULL;
-	RListIter *iter;
-	r_list_foreach (io->maps, iter, im) {
-		if (im->from <= off && off < im->to) {
-			res = true;
-			break;
-		}
-	}
-	return res;
+	MapQuery q;
+	mapindex_stab (io, off, &q);
+	return q.first? true: false;
 }
 
 R_API ut64 r_io_map_select(RIO *io, ut64 off) {
@@ -253,6 +325,22 @@ R_API ut64 r_io_map_select(RIO *io, ut64 off) {
 	RIOMap *im = NULL;
 	RListIter *iter;
 	ut64 prevfrom = 0LL;
+	MapQuery q;
+
+	/* the walk below ends up on the first map containing off that
+	 * belongs to the raised fd, or else on the last one containing it */
+	mapindex_stab (io, off, &q);
+	if (q.first) {
+		im = (q.raised? q.raised: q.last)->data;
+		if (im->fd != -1 && r_io_use_fd (io, im->fd)) {
+			paddr = off - im->from + im->delta;
+			if (io->debug) /* HACK */
+				r_io_seek (io, off, R_IO_SEEK_SET);
+			else r_io_seek (io, paddr, R_IO_SEEK_SET);
+			return paddr;
+		}
+	}
+	// no map here or a stale fd, the walk picks the fd
 	r_list_foreach (io->maps, iter, im) {
 		if (off>=im->from) {
 			if (prevfrom) {
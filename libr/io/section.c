@@ -1,15 +1,88 @@
-/* radare - LGPL - Copyright 2008-2014 - pancake, nibble */
+/* radare - LGPL - Copyright 2008-2015 - pancake, nibble */
 
 #include "r_io.h"
 
 // no link dep
 #include <r_cons.h>
 
+/* The lookups done on every read go through io->secindex: three
+ * interval trees built from io->sections in list order, so the node
+ * seq is the position in the list and "first matching section" keeps
+ * meaning the same. Every change to the list must invalidate it. */
+
+#define SECIDX(io) (&(io)->secindex)
+
+R_API void r_io_section_index_invalidate(RIO *io) {
+	if (io) SECIDX (io)->dirty = true;
+}
+
+static void secindex_build(RIO *io) {
+	RIOSectionIndex *si = SECIDX (io);
+	RListIter *iter;
+	RIOSection *s;
+	if (!si->vaddr) {
+		si->vaddr = r_itree_new (NULL);
+		si->paddr = r_itree_new (NULL);
+		si->vsize = r_itree_new (NULL);
+	} else {
+		r_itree_purge (si->vaddr);
+		r_itree_purge (si->paddr);
+		r_itree_purge (si->vsize);
+	}
+	r_list_foreach (io->sections, iter, s) {
+		r_itree_insert (si->vaddr, s->vaddr, s->vaddr + s->vsize, s);
+		r_itree_insert (si->paddr, s->offset, s->offset + s->size, s);
+		r_itree_insert (si->vsize, s->vaddr, s->vaddr + s->size, s);
+	}
+	si->dirty = false;
+}
+
+static RIOSectionIndex *secindex(RIO *io) {
+	RIOSectionIndex *si = SECIDX (io);
+	if (si->dirty || !si->vaddr) {
+		secindex_build (io);
+	}
+	return si;
+}
+
+typedef struct {
+	RITreeNode *node;
+	ut32 minseq;
+	int rwx;
+} SecQuery;
+
+/* keep the containing section that comes first in io->sections */
+static int secindex_first_cb(RITreeNode *n, void *user) {
+	SecQuery *q = user;
+	RIOSection *s = n->data;
+	if (n->seq < q->minseq) return true;
+	if (q->rwx && !(s->rwx & q->rwx)) return true;
+	if (!q->node || n->seq < q->node->seq) {
+		q->node = n;
+	}
+	return true;
+}
+
+static RIOSection *secindex_first(RITree *t, ut64 addr, int rwx) {
+	SecQuery q = { NULL, 0, rwx };
+	r_itree_stab (t, addr, secindex_first_cb, &q);
+	return q.node? q.node->data: NULL;
+}
+
 R_API void r_io_section_init(RIO *io) {
 	io->next_section_id = 0;
 	io->enforce_rwx = 0; // do not enforce RWX section permissions by default
 	io->enforce_seek = 0; // do not limit seeks out of the file by default
 	io->sections = r_list_new ();
+	memset (SECIDX (io), 0, sizeof (RIOSectionIndex));
+}
+
+R_API void r_io_section_fini(RIO *io) {
+	RIOSectionIndex *si = SECIDX (io);
+	r_itree_free (si->vaddr);
+	r_itree_free (si->paddr);
+	r_itree_free (si->vsize);
+	memset (si, 0, sizeof (RIOSectionIndex));
 }
 
 #if 0
@@ -52,6 +125,7 @@ R_API RIOSection *r_io_section_add(RIO *io, ut64 offset, ut64 vaddr, ut64 size,
 	s->arch = s->bits = 0;
 	s->bin_id = bin_id;
 	s->fd = fd;
+	r_io_section_index_invalidate (io);
 	if (!update) {
 		if (name) strncpy (s->name, name, sizeof (s->name)-4);
 		else *s->name = '\0';
@@ -71,6 +145,7 @@ R_API RIOSection *r_io_section_get_i(RIO *io, int idx) {
 }
 
 R_API int r_io_section_rm(RIO *io, int idx) {
+	r_io_section_index_invalidate (io);
 	return r_list_del_n (io->sections, idx);
 }
 
@@ -79,6 +154,7 @@ R_API int r_io_section_rm_all (RIO *io, int fd) {
 	RListIter *iter, *ator;
 	if (!io || !io->sections)
 		return false;
+	r_io_section_index_invalidate (io);
 	r_list_foreach_safe (io->sections, iter, ator, section) {
 		if (section->fd == fd || fd == -1)
 			r_list_delete (io->sections, iter);
@@ -87,6 +163,7 @@ R_API int r_io_section_rm_all (RIO *io, int fd) {
 }
 
 R_API void r_io_section_clear(RIO *io) {
+	r_io_section_index_invalidate (io);
 	r_list_free (io->sections);
 	io->sections = r_list_new ();
 	io->sections->free = free;
@@ -209,23 +286,11 @@ R_API void r_io_section_list_visual(RIO *io, ut64 seek, ut64 len, int width, int
 }
 
 R_API RIOSection *r_io_section_vget(RIO *io, ut64 vaddr) {
-	RListIter *iter;
-	RIOSection *s;
-	r_list_foreach (io->sections, iter, s) {
-		if (vaddr >= s->vaddr && vaddr < s->vaddr + s->vsize)
-			return s;
-	}
-	return NULL;
+	return secindex_first (secindex (io)->vaddr, vaddr, 0);
 }
 
 R_API RIOSection *r_io_section_mget(RIO *io, ut64 maddr) {
-	RIOSection *s;
-	RListIter *iter;
-	r_list_foreach (io->sections, iter, s) {
-		if ((maddr >= s->offset && maddr < (s->offset + s->size)))
-			return s;
-	}
-	return NULL;
+	return secindex_first (secindex (io)->paddr, maddr, 0);
 }
 
 // XXX: rename this
@@ -277,16 +342,8 @@ R_API ut64 r_io_section_vaddr_to_maddr_try(RIO *io, ut64 vaddr) {
 /* returns the conversion from vaddr to maddr if the given vaddr is in a mapped
  * region, UT64_MAX otherwise */
 R_API ut64 r_io_section_vaddr_to_maddr(RIO *io, ut64 vaddr) {
-	RListIter *iter;
-	RIOSection *s;
-
-	r_list_foreach (io->sections, iter, s) {
-		if (!(s->rwx & R_IO_MAP)) continue;
-		if (vaddr >= s->vaddr && vaddr < s->vaddr + s->vsize) {
-			return (vaddr - s->vaddr + s->offset);
-		}
-	}
-	return UT64_MAX;
+	RIOSection *s = secindex_first (secindex (io)->vaddr, vaddr, R_IO_MAP);
+	return s? (vaddr - s->vaddr + s->offset): UT64_MAX;
 }
 
 /* returns the conversion from file offset to vaddr if the given offset is
@@ -316,40 +373,48 @@ R_API int r_io_section_exists_for_vaddr (RIO *io, ut64 vaddr, int hasperm) {
 	return true;
 }
 
+/* first mapped section after position minseq of the list containing addr */
+static RITreeNode *secindex_next_in(RITree *t, ut64 addr, ut32 minseq) {
+	SecQuery q = { NULL, minseq, R_IO_MAP };
+	r_itree_stab (t, addr, secindex_first_cb, &q);
+	return q.node;
+}
+
 // dupped in vio.c
 R_API ut64 r_io_section_next(RIO *io, ut64 o) {
-	int oset = 0;
-	ut64 newsec = 0LL;
-	RListIter *iter;
+	RIOSectionIndex *si = secindex (io);
+	RITreeNode *np, *nv, *n;
 	RIOSection *s;
+	ut32 seq = 0;
+	int oset = 0;
 
-	r_list_foreach (io->sections, iter, s) {
-		ut64 addr = s->vaddr;
-		if (!(s->rwx & R_IO_MAP)) continue;
-		if (o < addr) {
-			if (newsec) {
-				if (addr<newsec)
-					newsec = addr;//s->offset;//addr;
-			} else newsec = addr; //s->offset; //addr;
-		}
+	/* the list walk moves o to the end of every section containing it,
+	 * replay those moves in list order */
+	for (;;) {
+		np = secindex_next_in (si->paddr, o, seq);
+		nv = secindex_next_in (si->vsize, o, seq);
+		n = (np && (!nv || np->seq <= nv->seq))? np: nv;
+		if (!n) break;
+		s = n->data;
 		if (o >= s->offset && o < (s->offset + s->size)) {
-			ut64 n = s->offset + s->size;
-			if (n>o) {
-				o = n;
-				oset = 1;
-			}
+			o = s->offset + s->size;
+			oset = 1;
 		}
 		if (o >= s->vaddr && o < (s->vaddr + s->size)) {
-			ut64 n = s->vaddr + s->size;
-			if (n>o) {
-				o = n;
-				oset = 1;
-			}
+			o = s->vaddr + s->size;
+			oset = 1;
 		}
+		seq = n->seq + 1;
 	}
-	//eprintf ("Newsec %d %llx\n", oset, newsec);
 	if (oset) return o;
-	return newsec? newsec: o;
+	// lowest mapped section starting after o
+	for (n = r_itree_first (si->vsize, o + 1); n; n = r_itree_next (si->vsize, n)) {
+		s = n->data;
+		if (s->rwx & R_IO_MAP) {
+			return s->vaddr;
+		}
+	}
+	return o;
 }
 
 R_API RList *r_io_section_get_in_paddr_range(RIO *io, ut64 addr, ut64 endaddr) {
@@ -402,20 +467,27 @@ R_API RIOSection * r_io_section_get_first_in_paddr_range(RIO *io, ut64 addr, ut6
 }
 
 R_API RIOSection * r_io_section_get_first_in_vaddr_range(RIO *io, ut64 addr, ut64 endaddr) {
-	RIOSection *s= NULL;
-	RListIter *iter;
+	RIOSectionIndex *si = secindex (io);
+	SecQuery q = { NULL, 0, R_IO_MAP };
+	RITreeNode *n;
+	RIOSection *s;
 	ut64 sec_from, sec_to;
-	r_list_foreach (io->sections, iter, s) {
+	// sections containing addr
+	r_itree_stab (si->vaddr, addr, secindex_first_cb, &q);
+	// and the ones starting inside the range
+	for (n = r_itree_first (si->vaddr, addr); n && n->from <= endaddr;
+			n = r_itree_next (si->vaddr, n)) {
+		s = n->data;
 		if (!(s->rwx & R_IO_MAP)) continue;
+		if (q.node && q.node->seq < n->seq) continue;
 		sec_to = s->vaddr + s->vsize;
 		sec_from = s->vaddr;
-		if (sec_from <= addr && addr < sec_to) break;
-		//if (map->from == addr && endaddr == sec_to) r_list_append(maps, map);
-		if (sec_from < endaddr && endaddr < sec_to) break;
-		if (addr <= sec_from && sec_to <= endaddr) break;
-		s = NULL;
+		if ((sec_from < endaddr && endaddr < sec_to) ||
+				(addr <= sec_from && sec_to <= endaddr)) {
+			q.node = n;
+		}
 	}
-	return s;
+	return q.node? q.node->data: NULL;
 }
 
 R_API int r_io_section_set_archbits(RIO *io, ut64 addr, const char *arch, int bits) {
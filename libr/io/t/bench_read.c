@@ -0,0 +1,133 @@
+/* times reads through sections and maps against how many there are */
+
+#include <r_io.h>
+
+#define READS 100000
+#define BASE 0x400000
+
+static RIOSection *list_vget(RIO *io, ut64 vaddr) {
+	RListIter *iter;
+	RIOSection *s;
+	r_list_foreach (io->sections, iter, s) {
+		if (vaddr >= s->vaddr && vaddr < s->vaddr + s->vsize)
+			return s;
+	}
+	return NULL;
+}
+
+static RIOMap *list_map_get(RIO *io, ut64 addr) {
+	RListIter *iter;
+	RIOMap *map;
+	r_list_foreach (io->maps, iter, map) {
+		if (addr >= map->from && addr < map->to)
+			return map;
+	}
+	return NULL;
+}
+
+static void bench(const char *file, int nsecs) {
+	RIO *io = r_io_new ();
+	RIODesc *fd;
+	RProfile prof;
+	ut64 *addrs, end = BASE + (ut64)nsecs * 0x100;
+	double t_read, t_vget;
+	int i, miss = 0;
+	ut8 buf[4];
+
+	fd = r_io_open_nomap (io, file, R_IO_READ, 0);
+	if (!fd) {
+		eprintf ("Cannot open '%s'\n", file);
+		r_io_free (io);
+		return;
+	}
+	io->va = true;
+	for (i = 0; i < nsecs; i++) {
+		char name[32];
+		snprintf (name, sizeof (name), "s%d", i);
+		r_io_section_add (io, (i * 0x80) & 0xffff, BASE + (ut64)i * 0x100,
+			0x80, 0xc0, R_IO_READ | R_IO_MAP, name, 0, fd->fd);
+	}
+	addrs = malloc (sizeof (ut64) * READS);
+	for (i = 0; i < READS; i++) {
+		addrs[i] = BASE + ((ut64)rand () * rand ()) % (end - BASE);
+	}
+
+	r_prof_start (&prof);
+	for (i = 0; i < READS; i++) {
+		r_io_read_at (io, addrs[i], buf, sizeof (buf));
+	}
+	r_prof_end (&prof);
+	t_read = prof.result;
+
+	r_prof_start (&prof);
+	for (i = 0; i < READS / 10; i++) {
+		if (list_vget (io, addrs[i]) != r_io_section_vget (io, addrs[i]))
+			miss++;
+	}
+	r_prof_end (&prof);
+	t_vget = prof.result * 10;
+
+	printf ("%6d sections  read %8.3f us  list vget %8.3f us  (%d mismatches)\n",
+		nsecs, t_read * 1000000 / READS, t_vget * 1000000 / READS, miss);
+	free (addrs);
+	r_io_close (io, fd);
+	r_io_free (io);
+}
+
+static void bench_maps(const char *file, int nmaps) {
+	RIO *io = r_io_new ();
+	RIODesc *fd;
+	RProfile prof;
+	ut64 *addrs, end = BASE + (ut64)nmaps * 0x100;
+	double t_read, t_get;
+	int i, miss = 0;
+	ut8 buf[4];
+
+	fd = r_io_open_nomap (io, file, R_IO_READ, 0);
+	if (!fd) {
+		eprintf ("Cannot open '%s'\n", file);
+		r_io_free (io);
+		return;
+	}
+	for (i = 0; i < nmaps; i++) {
+		r_io_map_new (io, fd->fd, R_IO_READ, (i * 0x80) & 0xffff,
+			BASE + (ut64)i * 0x100, 0xc0);
+	}
+	addrs = malloc (sizeof (ut64) * READS);
+	for (i = 0; i < READS; i++) {
+		addrs[i] = BASE + ((ut64)rand () * rand ()) % (end - BASE);
+	}
+
+	r_prof_start (&prof);
+	for (i = 0; i < READS; i++) {
+		r_io_read_at (io, addrs[i], buf, sizeof (buf));
+	}
+	r_prof_end (&prof);
+	t_read = prof.result;
+
+	r_prof_start (&prof);
+	for (i = 0; i < READS / 10; i++) {
+		if (list_map_get (io, addrs[i]) != r_io_map_get (io, addrs[i]))
+			miss++;
+	}
+	r_prof_end (&prof);
+	t_get = prof.result * 10;
+
+	printf ("%6d maps      read %8.3f us  list get  %8.3f us  (%d mismatches)\n",
+		nmaps, t_read * 1000000 / READS, t_get * 1000000 / READS, miss);
+	free (addrs);
+	r_io_close (io, fd);
+	r_io_free (io);
+}
+
+int main(int argc, char **argv) {
+	const char *file = (argc > 1)? argv[1]: "/bin/ls";
+	int n, max = (argc > 2)? atoi (argv[2]): 10000;
+	for (n = 10; n <= max; n *= 10) {
+		bench (file, n);
+	}
+	for (n = 10; n <= max; n *= 10) {
+		bench_maps (file, n);
+	}
+	return 0;
+}
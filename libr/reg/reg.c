@@ -90,6 +90,7 @@ R_API void r_reg_free_internal(RReg *reg) {
 		reg->regset[i].regs = r_list_newf ((RListFree)r_reg_item_free);
 	}
 	reg->size = 0;
+	reg->gen++;
 }
 
 R_API void r_reg_free(RReg *reg) {
@@ -0,0 +1,576 @@
+/* radare - LGPL - Copyright 2015 - pancake */
+
+/* Aho-Corasick automaton for the keyword search.
+ *
+ * Every keyword is added to the trie through its anchor: the longest
+ * run of bytes not affected by the binmask. When an anchor is found
+ * the whole keyword is checked against the data, with its binmask and
+ * case, so masked and case insensitive keywords share a single pass.
+ * Keywords fully covered by the mask have no anchor and are checked
+ * at every position.
+ *
+ * The last bytes of every block are kept, and scanned again in front
+ * of the next one when it is contiguous. Hits are only reported when
+ * the keyword ends inside the current block, so the ones crossing the
+ * boundary are found once and nothing is reported twice.
+ *
+ * When there is a single case sensitive keyword the trie walk is
+ * replaced by a filter on the first and last bytes of its anchor,
+ * tested a word at a time, and only the few offsets passing it are
+ * compared.
+ *
+ * r_search_ac_update_threads splits a large buffer between threads,
+ * each one with its own copy of the automaton and the bytes before its
+ * part of the buffer as tail. Workers only collect the hits, which are
+ * then merged and reported from the calling thread in the order of a
+ * serial run: by the end of their anchor, then by keyword. */
+
+#include <r_search.h>
+#include <ctype.h>
+
+typedef struct {
+	int fail;	// longest proper suffix that is also in the trie
+	int dict;	// nearest suffix with patterns ending on it
+	int pat;	// first pattern whose anchor ends here
+	int child;	// first child
+	int sibling;	// next child of the parent
+	ut8 ch;
+} ACNode;
+
+typedef struct {
+	RSearchKeyword *kw;
+	int idx;	// position in s->kws, hits at one offset keep that order
+	int aend;	// offset of the anchor end in the keyword
+	int next;	// next pattern ending on the same node
+	ut64 nexthit;	// hits overlapping the previous one are skipped
+} ACPattern;
+
+struct r_search_ac_t {
+	ACNode *nodes;
+	int nnodes;
+	int root[256];
+	ut8 map[256];	// input byte folding
+	ACPattern *pats;
+	int npats;
+	int *loose;	// patterns without anchor
+	int nloose;
+	int maxlen;
+	ut8 *tail;	// end of the previous block
+	int tlen;
+	ut64 tend;	// address after the tail
+	int *hits;	// scratch list of patterns hit at one offset
+	int nhits;
+	const ut8 *anchor;	// set when the single keyword fast path is used
+	int alen;
+	int anode;	// node where the anchor ends
+	RSearchAC **workers;	// copies used by r_search_ac_update_threads
+	int nworkers;
+};
+
+typedef struct {
+	ut64 addr;
+	ut64 end;	// address of the anchor end, serial runs report in this order
+	int pat;
+} ACHit;
+
+/* window made of the previous tail followed by the current block */
+typedef struct {
+	RSearch *s;
+	RSearchAC *ac;
+	const ut8 *buf;
+	int len;
+	ut64 addr;	// address of the window start
+	int count;
+	int collect;	// store hits in found instead of reporting them
+	ACHit *found;
+	int nfound;
+	int ok;
+} ACWindow;
+
+static inline ut8 win_byte(ACWindow *w, int i) {
+	return (i < w->ac->tlen)? w->ac->tail[i]: w->buf[i - w->ac->tlen];
+}
+
+static ut8 kw_mask(RSearchKeyword *kw, int i) {
+	return kw->binmask_length? kw->bin_binmask[i % kw->binmask_length]: 0xff;
+}
+
+static int ac_node_new(RSearchAC *ac, int parent, ut8 ch) {
+	ACNode *n;
+	if (!(ac->nnodes & (ac->nnodes - 1))) {
+		n = realloc (ac->nodes, sizeof (ACNode) * (ac->nnodes? ac->nnodes * 2: 1));
+		if (!n) return -1;
+		ac->nodes = n;
+	}
+	n = &ac->nodes[ac->nnodes];
+	memset (n, 0, sizeof (ACNode));
+	n->pat = -1;
+	n->ch = ch;
+	if (parent != -1) {
+		n->sibling = ac->nodes[parent].child;
+		ac->nodes[parent].child = ac->nnodes;
+	}
+	return ac->nnodes++;
+}
+
+static inline int ac_child(RSearchAC *ac, int node, ut8 ch) {
+	int c;
+	for (c = ac->nodes[node].child; c; c = ac->nodes[c].sibling) {
+		if (ac->nodes[c].ch == ch)
+			return c;
+	}
+	return 0;
+}
+
+static inline int ac_step(RSearchAC *ac, int node, ut8 ch) {
+	int c;
+	while (node) {
+		if ((c = ac_child (ac, node, ch)))
+			return c;
+		node = ac->nodes[node].fail;
+	}
+	return ac->root[ch];
+}
+
+/* longest run of bytes fully covered by the binmask */
+static void kw_anchor(RSearchKeyword *kw, int *from, int *len) {
+	int i, run = 0;
+	*from = *len = 0;
+	for (i = 0; i < kw->keyword_length; i++) {
+		if (kw_mask (kw, i) == 0xff) {
+			if (++run > *len) {
+				*len = run;
+				*from = i - run + 1;
+			}
+		} else run = 0;
+	}
+}
+
+static int ac_add(RSearchAC *ac, RSearchKeyword *kw, int idx) {
+	ACPattern *p;
+	int i, node, c, *pn, from, len;
+	if (!(ac->npats & (ac->npats - 1))) {
+		p = realloc (ac->pats, sizeof (ACPattern) * (ac->npats? ac->npats * 2: 1));
+		if (!p) return false;
+		ac->pats = p;
+	}
+	p = &ac->pats[ac->npats];
+	memset (p, 0, sizeof (ACPattern));
+	p->kw = kw;
+	p->idx = idx;
+	p->next = -1;
+	if (kw->keyword_length > ac->maxlen)
+		ac->maxlen = kw->keyword_length;
+	kw_anchor (kw, &from, &len);
+	if (!len) {
+		// checked at every offset as if it ended there
+		int *l = realloc (ac->loose, sizeof (int) * (ac->nloose + 1));
+		if (!l) return false;
+		ac->loose = l;
+		p->aend = kw->keyword_length;
+		ac->loose[ac->nloose++] = ac->npats++;
+		return true;
+	}
+	p->aend = from + len;
+	for (node = 0, i = from; i < from + len; i++) {
+		ut8 ch = ac->map[kw->bin_keyword[i]];
+		if (!(c = ac_child (ac, node, ch))) {
+			if ((c = ac_node_new (ac, node, ch)) == -1)
+				return false;
+		}
+		node = c;
+	}
+	// keep the patterns of a node sorted like the keyword list
+	for (pn = &ac->nodes[node].pat; *pn != -1; pn = &ac->pats[*pn].next)
+		;
+	*pn = ac->npats++;
+	ac->anchor = kw->bin_keyword + from;
+	ac->alen = len;
+	ac->anode = node;
+	return true;
+}
+
+static int ac_link(RSearchAC *ac) {
+	int *queue, head = 0, tail = 0, c, u, f;
+	queue = malloc (sizeof (int) * ac->nnodes);
+	if (!queue) return false;
+	memset (ac->root, 0, sizeof (ac->root));
+	for (c = ac->nodes[0].child; c; c = ac->nodes[c].sibling) {
+		ac->root[ac->nodes[c].ch] = c;
+		queue[tail++] = c;
+	}
+	while (head < tail) {
+		u = queue[head++];
+		for (c = ac->nodes[u].child; c; c = ac->nodes[c].sibling) {
+			f = ac_step (ac, ac->nodes[u].fail, ac->nodes[c].ch);
+			ac->nodes[c].fail = f;
+			ac->nodes[c].dict = (ac->nodes[f].pat != -1)? f: ac->nodes[f].dict;
+			queue[tail++] = c;
+		}
+	}
+	free (queue);
+	return true;
+}
+
+R_API void r_search_ac_free(RSearchAC *ac) {
+	int i;
+	if (!ac) return;
+	free (ac->nodes);
+	free (ac->pats);
+	free (ac->loose);
+	free (ac->tail);
+	free (ac->hits);
+	for (i = 0; i < ac->nworkers; i++)
+		r_search_ac_free (ac->workers[i]);
+	free (ac->workers);
+	free (ac);
+}
+
+R_API RSearchAC *r_search_ac_new(RList *kws) {
+	RSearchKeyword *kw;
+	RListIter *iter;
+	RSearchAC *ac = R_NEW0 (RSearchAC);
+	int i, idx = 0, icase = false;
+	if (!ac) return NULL;
+	r_list_foreach (kws, iter, kw) {
+		if (kw->icase) icase = true;
+	}
+	for (i = 0; i < 256; i++)
+		ac->map[i] = icase? tolower (i): i;
+	if (ac_node_new (ac, -1, 0) == -1)
+		goto fail;
+	r_list_foreach (kws, iter, kw) {
+		if (kw->keyword_length < 1)
+			continue;
+		if (!ac_add (ac, kw, idx++))
+			goto fail;
+	}
+	if (!ac_link (ac))
+		goto fail;
+	if (ac->npats != 1 || ac->nloose || icase)
+		ac->anchor = NULL;
+	ac->tail = malloc (ac->maxlen + 1);
+	ac->hits = malloc (sizeof (int) * (ac->npats + 1));
+	if (!ac->tail || !ac->hits)
+		goto fail;
+	return ac;
+fail:
+	r_search_ac_free (ac);
+	return NULL;
+}
+
+/* forget the previous block, the next update starts from scratch */
+R_API void r_search_ac_reset(RSearchAC *ac) {
+	int i;
+	if (!ac) return;
+	ac->tlen = 0;
+	for (i = 0; i < ac->npats; i++)
+		ac->pats[i].nexthit = 0;
+}
+
+static int ac_verify(ACWindow *w, ACPattern *p, int start) {
+	RSearchKeyword *kw = p->kw;
+	int i;
+	for (i = 0; i < kw->keyword_length; i++) {
+		ut8 a = win_byte (w, start + i);
+		ut8 b = kw->bin_keyword[i];
+		ut8 m = kw_mask (kw, i);
+		if (kw->icase) {
+			a = tolower (a);
+			b = tolower (b);
+		}
+		if ((a & m) != (b & m))
+			return false;
+	}
+	return true;
+}
+
+static void ac_candidate(ACWindow *w, int pi, int pos) {
+	RSearchAC *ac = w->ac;
+	ACPattern *p = &ac->pats[pi];
+	int j, start = pos + 1 - p->aend;
+	int end = start + p->kw->keyword_length;
+	// must start in the window and end inside the current block
+	if (start < 0 || end <= ac->tlen || end > ac->tlen + w->len)
+		return;
+	if (!ac_verify (w, p, start))
+		return;
+	// insertion sort by keyword order
+	for (j = ac->nhits; j > 0 && ac->pats[ac->hits[j - 1]].idx > p->idx; j--)
+		ac->hits[j] = ac->hits[j - 1];
+	ac->hits[j] = pi;
+	ac->nhits++;
+}
+
+/* check the patterns ending on the window offset pos, -1 to stop */
+static int ac_emit(ACWindow *w, int node, int pos) {
+	RSearchAC *ac = w->ac;
+	int i, p;
+	ac->nhits = 0;
+	if (ac->nodes[node].pat == -1)
+		node = ac->nodes[node].dict;
+	for (; node; node = ac->nodes[node].dict) {
+		for (p = ac->nodes[node].pat; p != -1; p = ac->pats[p].next)
+			ac_candidate (w, p, pos);
+	}
+	for (i = 0; i < ac->nloose; i++)
+		ac_candidate (w, ac->loose[i], pos);
+	for (i = 0; i < ac->nhits; i++) {
+		ACPattern *pat = &ac->pats[ac->hits[i]];
+		ut64 addr = w->addr + pos + 1 - pat->aend;
+		if (w->collect) {
+			if (!(w->nfound & (w->nfound - 1))) {
+				ACHit *f = realloc (w->found, sizeof (ACHit) * (w->nfound? w->nfound * 2: 1));
+				if (!f) return -1;
+				w->found = f;
+			}
+			w->found[w->nfound].addr = addr;
+			w->found[w->nfound].end = w->addr + pos;
+			w->found[w->nfound++].pat = ac->hits[i];
+			continue;
+		}
+		if (addr < pat->nexthit)
+			continue;
+		pat->nexthit = addr + pat->kw->keyword_length;
+		if (!r_search_hit_new (w->s, pat->kw, addr))
+			return -1;
+		pat->kw->count++;
+		w->count++;
+	}
+	return 0;
+}
+
+static int ac_scan(ACWindow *w, const ut8 *data, int len, int pos, int *state) {
+	RSearchAC *ac = w->ac;
+	int i, node = *state;
+	for (i = 0; i < len; i++) {
+		node = ac_step (ac, node, ac->map[data[i]]);
+		if (ac->nodes[node].pat != -1 || ac->nodes[node].dict || ac->nloose) {
+			if (ac_emit (w, node, pos + i) == -1)
+				return false;
+		}
+	}
+	*state = node;
+	return true;
+}
+
+#define ONES 0x0101010101010101ULL
+#define HIGHS 0x8080808080808080ULL
+/* nonzero when any byte of x is zero */
+#define HASZERO(x) (((x) - ONES) & ~(x) & HIGHS)
+
+static inline ut64 load64(const ut8 *p) {
+	ut64 v;
+	memcpy (&v, p, sizeof (v));
+	return v;
+}
+
+/* find the anchor of the single keyword in buf, pos is the window
+ * offset of buf[0]. Only anchors fully inside buf are looked for */
+static int ac_scan_single(ACWindow *w, const ut8 *buf, int len, int pos) {
+	RSearchAC *ac = w->ac;
+	const ut8 *a = ac->anchor;
+	int i, j, m = ac->alen, last = len - m;
+	ut64 first = ONES * a[0];
+	ut64 end = ONES * a[m - 1];
+	for (i = 0; i <= last; ) {
+		if (i + 8 <= last + 1) {
+			// 8 candidate offsets at a time
+			ut64 x = (load64 (buf + i) ^ first) | (load64 (buf + i + m - 1) ^ end);
+			if (!HASZERO (x)) {
+				i += 8;
+				continue;
+			}
+			for (j = i + 8; i < j; i++) {
+				if (buf[i] == a[0] && buf[i + m - 1] == a[m - 1]
+						&& !memcmp (buf + i + 1, a + 1, R_MAX (m - 2, 0))) {
+					if (ac_emit (w, ac->anode, pos + i + m - 1) == -1)
+						return false;
+				}
+			}
+			continue;
+		}
+		if (buf[i] == a[0] && !memcmp (buf + i, a, m)) {
+			if (ac_emit (w, ac->anode, pos + i + m - 1) == -1)
+				return false;
+		}
+		i++;
+	}
+	return true;
+}
+
+static void ac_keep_tail(RSearchAC *ac, ut64 from, const ut8 *buf, int len) {
+	int keep = ac->maxlen - 1;
+	if (keep < 1) {
+		ac->tlen = 0;
+	} else if (len >= keep) {
+		memcpy (ac->tail, buf + len - keep, keep);
+		ac->tlen = keep;
+	} else {
+		int old = R_MIN (ac->tlen, keep - len);
+		memmove (ac->tail, ac->tail + ac->tlen - old, old);
+		memcpy (ac->tail + old, buf, len);
+		ac->tlen = old + len;
+	}
+	ac->tend = from + len;
+}
+
+static int ac_window_scan(ACWindow *w) {
+	RSearchAC *ac = w->ac;
+	int state = 0;
+	if (ac->anchor) {
+		/* the anchors ending in the first alen-1 bytes of the block
+		 * started in the tail, walk the trie there */
+		return ac_scan (w, ac->tail, ac->tlen, 0, &state)
+			&& ac_scan (w, w->buf, R_MIN (w->len, ac->alen - 1), ac->tlen, &state)
+			&& ac_scan_single (w, w->buf, w->len, ac->tlen);
+	}
+	return ac_scan (w, ac->tail, ac->tlen, 0, &state)
+		&& ac_scan (w, w->buf, w->len, ac->tlen, &state);
+}
+
+R_API int r_search_ac_update(RSearch *s, ut64 from, const ut8 *buf, int len) {
+	RSearchAC *ac;
+	ACWindow w = {0};
+	int ret;
+	if (!s->ac && !(s->ac = r_search_ac_new (s->kws)))
+		return -1;
+	ac = s->ac;
+	if (len < 1)
+		return 0;
+	if (ac->tend != from) {
+		// not contiguous with the previous block
+		r_search_ac_reset (ac);
+	}
+	w.s = s;
+	w.ac = ac;
+	w.buf = buf;
+	w.len = len;
+	w.addr = from - ac->tlen;
+	ret = ac_window_scan (&w);
+	ac_keep_tail (ac, from, buf, len);
+	return ret? w.count: -1;
+}
+
+static int ac_worker(RThread *th) {
+	ACWindow *w = th->user;
+	w->ok = ac_window_scan (w);
+	return false; // do not loop
+}
+
+/* patterns are numbered in keyword order */
+static int achit_cmp(const void *a, const void *b) {
+	const ACHit *ha = a, *hb = b;
+	if (ha->end != hb->end)
+		return (ha->end < hb->end)? -1: 1;
+	return ha->pat - hb->pat;
+}
+
+static int ac_workers(RSearch *s, int n) {
+	RSearchAC *ac = s->ac;
+	RSearchAC **w;
+	if (ac->nworkers >= n)
+		return true;
+	w = realloc (ac->workers, sizeof (RSearchAC*) * n);
+	if (!w) return false;
+	ac->workers = w;
+	for (; ac->nworkers < n; ac->nworkers++) {
+		if (!(w[ac->nworkers] = r_search_ac_new (s->kws)))
+			return false;
+	}
+	return true;
+}
+
+/* same as r_search_ac_update, with buf searched by n threads */
+R_API int r_search_ac_update_threads(RSearch *s, ut64 from, const ut8 *buf, int len, int n) {
+	RSearchAC *ac;
+	RThread **th;
+	ACWindow *w;
+	ACHit *all = NULL;
+	int i, j, seg, nall = 0, ret = 0;
+	if (!s->ac && !(s->ac = r_search_ac_new (s->kws)))
+		return -1;
+	ac = s->ac;
+	seg = (n > 1)? (len + n - 1) / n: len;
+	// not worth it for small blocks
+	if (n < 2 || seg < 4 * ac->maxlen || seg < 0x1000)
+		return r_search_ac_update (s, from, buf, len);
+	if (!ac_workers (s, n))
+		return -1;
+	if (ac->tend != from)
+		r_search_ac_reset (ac);
+	w = calloc (n, sizeof (ACWindow));
+	th = calloc (n, sizeof (RThread*));
+	if (!w || !th) {
+		free (w);
+		free (th);
+		return -1;
+	}
+	for (i = 0; i < n; i++) {
+		RSearchAC *wac = ac->workers[i];
+		int at = i * seg;
+		if (at >= len) break;
+		if (i) {
+			// the bytes before this part play the tail
+			wac->tlen = R_MIN (at, ac->maxlen - 1);
+			memcpy (wac->tail, buf + at - wac->tlen, wac->tlen);
+		} else {
+			wac->tlen = ac->tlen;
+			memcpy (wac->tail, ac->tail, ac->tlen);
+		}
+		w[i].ac = wac;
+		w[i].buf = buf + at;
+		w[i].len = R_MIN (seg, len - at);
+		w[i].addr = from + at - wac->tlen;
+		w[i].collect = true;
+		if (i && !(th[i] = r_th_new (ac_worker, &w[i], 0)))
+			w[i].ok = ac_window_scan (&w[i]);
+	}
+	w[0].ok = ac_window_scan (&w[0]);
+	for (i = 1; i < n; i++) {
+		if (th[i]) {
+			r_th_wait (th[i]);
+			r_th_free (th[i]);
+		}
+	}
+	/* unused parts have no hits */
+	for (i = 0; i < n; i++) {
+		if (w[i].ac && !w[i].ok)
+			ret = -1;
+		nall += w[i].nfound;
+	}
+	if (ret != -1 && nall) {
+		/* the anchor of a hit found in a part may end in the bytes of
+		 * the previous one, so all the parts are merged */
+		all = malloc (sizeof (ACHit) * nall);
+		if (!all)
+			ret = -1;
+	}
+	if (ret != -1 && all) {
+		for (i = j = 0; i < n; i++) {
+			memcpy (all + j, w[i].found, sizeof (ACHit) * w[i].nfound);
+			j += w[i].nfound;
+		}
+		qsort (all, nall, sizeof (ACHit), achit_cmp);
+		for (j = 0; j < nall; j++) {
+			ACPattern *pat = &ac->pats[all[j].pat];
+			ut64 addr = all[j].addr;
+			if (addr < pat->nexthit)
+				continue;
+			pat->nexthit = addr + pat->kw->keyword_length;
+			if (!r_search_hit_new (s, pat->kw, addr)) {
+				ret = -1;
+				break;
+			}
+			pat->kw->count++;
+			ret++;
+		}
+	}
+	free (all);
+	for (i = 0; i < n; i++)
+		free (w[i].found);
+	free (w);
+	free (th);
+	ac_keep_tail (ac, from, buf, len);
+	return ret;
+}
@@ -1,4 +1,4 @@
-/* radare - LGPL - Copyright 2008-2014 pancake */
+/* radare - LGPL - Copyright 2008-2015 pancake */
 
 #include <r_search.h>
 #include <r_list.h>
@@ -38,6 +38,7 @@ R_API RSearch *r_search_free(RSearch *s) {
 	if (!s) return NULL;
 	// TODO: it leaks
 	r_mem_pool_free (s->pool);
+	r_search_ac_free (s->ac);
 	r_list_free (s->hits);
 	r_list_free (s->kws);
 	//r_io_free(s->iob.io); this is suposed to be a weak reference
@@ -73,6 +74,9 @@ R_API int r_search_set_mode(RSearch *s, int mode) {
 R_API int r_search_begin(RSearch *s) {
 	RListIter *iter;
 	RSearchKeyword *kw;
+	// keywords may have changed, rebuild the automaton on next update
+	r_search_ac_free (s->ac);
+	s->ac = NULL;
 	r_list_foreach (s->kws, iter, kw) {
 		kw->count = 0;
 		kw->idx[0] = 0;
@@ -227,6 +231,10 @@ R_API int r_search_mybinparse_update(void *_s, ut64 from, const ut8 *buf, int le
 	RListIter *iter;
 	int count = 0;
 
+	/* all the keywords in one pass, the byte walk below is only
+	 * needed for the fuzzy and inverse searches */
+	if (!s->distance && !s->inverse)
+		return r_search_ac_update (s, from, buf, len);
 #if USE_BMH
 	ut64 offset;
 	ut64 match_pos;
@@ -384,6 +392,15 @@ R_API int r_search_update_i(RSearch *s, ut64 from, const ut8 *buf, long len) {
 	return r_search_update (s, &from, buf, len);
 }
 
+/* keyword searches are split between n threads, other modes are serial.
+ * Hits are reported from the calling thread in the serial order */
+R_API int r_search_update_threads(RSearch *s, ut64 from, const ut8 *buf, long len, int n) {
+	n = R_MIN (n, R_SEARCH_THREADS_MAX);
+	if (s->mode == R_SEARCH_KEYWORD && !s->distance && !s->inverse && n > 1)
+		return r_search_ac_update_threads (s, from, buf, len, n);
+	return r_search_update (s, &from, buf, len);
+}
+
 static int listcb(RSearchKeyword *k, void *user, ut64 addr) {
 	RSearchHit *hit = R_NEW (RSearchHit);
 	hit->kw = k;
@@ -404,10 +421,14 @@ R_API int r_search_kw_add(RSearch *s, RSearchKeyword *kw) {
 	if (!kw) return false;
 	kw->kwidx = s->n_kws++;
 	r_list_append (s->kws, kw);
+	r_search_ac_free (s->ac);
+	s->ac = NULL;
 	return true;
 }
 
 R_API void r_search_kw_reset(RSearch *s) {
+	r_search_ac_free (s->ac);
+	s->ac = NULL;
 	r_list_free (s->kws);
 	s->kws = r_list_new ();
 }
@@ -1,4 +1,4 @@
-/* radare - LGPL - Copyright 2006-2009 pancake<nopcode.org> */
+/* radare - LGPL - Copyright 2006-2015 pancake<nopcode.org> */
 
 #include "r_search.h"
 
@@ -21,80 +21,32 @@ R_API int r_search_get_encoding(const char *name) {
 	return ENCODING_ASCII;
 }
 
-static int is_encoded(int encoding, unsigned char c) {
-	switch (encoding) {
-	case ENCODING_ASCII:
-		break;
-	case ENCODING_CP850:
-		switch (c) {
-		// CP850
-		case 128: // cedilla
-		case 133: // a grave
-		case 135: // minicedilla
-		case 160: // a acute
-		case 161: // i acute
-		case 129: // u dieresi
-		case 130: // e acute
-		case 139: // i dieresi
-		case 162: // o acute
-		case 163: // u acute
-		case 164: // enye
-		case 165: // enyemay
-		case 181: // A acute
-		case 144: // E acute
-		case 214: // I acute
-		case 224: // O acute
-		case 233: // U acute
-			return 1;
-		}
-		break;
-	}
-	return 0;
+typedef struct {
+	RSearch *s;
+	RSearchKeyword *kw;
+	ut64 from;
+} StringsQuery;
+
+static int strings_hit(void *user, int off, int len, int size, int enc) {
+	StringsQuery *q = user;
+	q->kw->count++;
+	return r_search_hit_new (q->s, q->kw, q->from + off);
 }
 
+/* ascii and utf16 strings, wide ones are reported at their first byte */
 R_API int r_search_strings_update(void *_s, ut64 from, const ut8 *buf, int len) {
 	RSearch *s = (RSearch *)_s;
-	const int enc = 0; // hardcoded
-	int i = 0;
-	int widechar = 0;
-	int matches = 0;
-	char str[4096];
+	StringsQuery q = { s, NULL, from };
+	// strings shorter than 3 chars were never reported
+	int min = R_MAX (s->string_min, 3);
 	RListIter *iter;
 	RSearchKeyword *kw;
 
 	r_list_foreach (s->kws, iter, kw) {
-	for (i=0; i<len; i++) {
-		char ch = buf[i];
-		if (IS_PRINTABLE(ch) || IS_WHITESPACE(ch) || is_encoded (enc, ch)) {
-			str[matches] = ch;
-			if (matches < sizeof(str))
-				matches++;
-		} else {
-			/* wide char check \x??\x00\x??\x00 */
-			if (matches && buf[i+2]=='\0' && buf[i]=='\0' && buf[i+1]!='\0') {
-				widechar = 1;
-				return 1; // widechar
-			}
-			/* check if the length fits on our request */
-			if (matches >= s->string_min && (s->string_max == 0 || matches <= s->string_max)) {
-				str[matches] = '\0';
-				int len = strlen(str);
-				if (len>2) {
-					kw->count++;
-					if (widechar) {
-						ut64 off = (ut64)from+i-(len*2)+1;
-						r_search_hit_new (s, kw, off);
-					} else {
-						ut64 off = (ut64)from+i-matches;
-						r_search_hit_new (s, kw, off);
-					}
-				}
-				fflush(stdout);
-			}
-			matches = 0;
-			widechar = 0;
-		}
-	}
+		q.kw = kw;
+		if (r_str_scan (buf, len, min, s->string_max,
+				R_STRSCAN_ASCII | R_STRSCAN_UTF16LE, strings_hit, &q) == -1)
+			return -1;
 	}
 	return 0;
 }
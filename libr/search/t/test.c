@@ -44,5 +44,24 @@ int main(int argc, char **argv) {
 	printf ("Searching for '%s' with binmask 'ff00ff' in '%s'\n", "lib", buffer);
 	r_search_update_i (rs, 0LL, (ut8*)buffer, strlen(buffer));
 	rs = r_search_free (rs);
+
+	printf("--\n");
+
+	/* test many keywords fed in small blocks */
+	rs = r_search_new (R_SEARCH_KEYWORD);
+	r_search_kw_add (rs, r_search_keyword_new_str ("lib", "", NULL, 0));
+	r_search_kw_add (rs, r_search_keyword_new_str ("ICE", "", NULL, 1));
+	r_search_kw_add (rs, r_search_keyword_new_str ("coolib", "", NULL, 0));
+	r_search_kw_add (rs, r_search_keyword_new_str ("l.b", "ff00ff", NULL, 0));
+	r_search_set_callback (rs, &hit, buffer);
+	r_search_begin (rs);
+	printf ("Searching for 'lib', 'ICE', 'coolib' and 'l.b' in blocks of 4\n");
+	{
+		int i, len = strlen (buffer);
+		for (i = 0; i < len; i += 4) {
+			r_search_update_i (rs, i, (ut8*)buffer + i, R_MIN (4, len - i));
+		}
+	}
+	rs = r_search_free (rs);
 	return 0;
 }
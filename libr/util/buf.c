@@ -116,6 +116,19 @@ R_API RBuffer *r_buf_new_with_bytes (const ut8 *bytes, ut64 len) {
 	return b;
 }
 
+/* buffer over bytes owned by someone else, which must outlive it.
+ * They are never freed here and get copied before being modified */
+R_API RBuffer *r_buf_new_with_pointers (const ut8 *bytes, ut64 len) {
+	RBuffer *b = r_buf_new ();
+	if (!b) return NULL;
+	if (bytes && (len > 0 && len <= ST32_MAX)) {
+		b->buf = (ut8*)bytes;
+		b->length = len;
+		b->ro = 1;
+	}
+	return b;
+}
+
 R_API RBuffer *r_buf_new_sparse() {
 	RBuffer *b = r_buf_new ();
 	b->sparse = r_list_newf ((RListFree)free);
@@ -156,6 +169,7 @@ R_API RBuffer *r_buf_mmap (const char *file, int flags) {
 	if (b->mmap) {
 		b->buf = b->mmap->buf;
 		b->length = b->mmap->len;
+		b->ro = !rw;
 		if (b->length == 0) b->empty = 1;
 		return b;
 	}
@@ -204,6 +218,30 @@ R_API int r_buf_seek (RBuffer *b, st64 addr, int whence) {
 	return (int)b->cur;
 }
 
+/* release the bytes, unless they are borrowed */
+static void buf_drop(RBuffer *b) {
+	if (b->mmap) {
+		r_file_mmap_free (b->mmap);
+		b->mmap = NULL;
+	} else if (!b->ro) {
+		free (b->buf);
+	}
+	b->buf = NULL;
+	b->ro = 0;
+}
+
+/* get a private copy of borrowed or read-only bytes before modifying them */
+static int buf_own(RBuffer *b) {
+	ut8 *p;
+	if (!b->ro) return R_TRUE;
+	if (!(p = malloc (b->length + 1)))
+		return R_FALSE;
+	memcpy (p, b->buf, b->length);
+	buf_drop (b);
+	b->buf = p;
+	return R_TRUE;
+}
+
 R_API int r_buf_set_bits(RBuffer *b, int bitoff, int bitsize, ut64 value) {
 	// TODO: implement r_buf_set_bits
 	// TODO: get the implementation from reg/value.c ?
@@ -212,7 +250,7 @@ R_API int r_buf_set_bits(RBuffer *b, int bitoff, int bitsize, ut64 value) {
 
 R_API int r_buf_set_bytes(RBuffer *b, const ut8 *buf, int length) {
 	if (length<=0 || !buf) return R_FALSE;
-	free (b->buf);
+	buf_drop (b);
 	if (!(b->buf = malloc (length)))
 		return R_FALSE;
 	memmove (b->buf, buf, length);
@@ -222,6 +260,7 @@ R_API int r_buf_set_bytes(RBuffer *b, const ut8 *buf, int length) {
 }
 
 R_API int r_buf_prepend_bytes(RBuffer *b, const ut8 *buf, int length) {
+	if (!buf_own (b)) return R_FALSE;
 	if (!(b->buf = realloc (b->buf, b->length+length)))
 		return R_FALSE;
 	memmove (b->buf+length, b->buf, b->length);
@@ -244,7 +283,7 @@ R_API char *r_buf_to_string(RBuffer *b) {
 }
 
 R_API int r_buf_append_bytes(RBuffer *b, const ut8 *buf, int length) {
-	if (!b) return R_FALSE;
+	if (!b || !buf_own (b)) return R_FALSE;
 	if (b->empty) b->length = b->empty = 0;
 	if (!(b->buf = realloc (b->buf, 1+b->length+length))) {
 		return R_FALSE;
@@ -256,7 +295,7 @@ R_API int r_buf_append_bytes(RBuffer *b, const ut8 *buf, int length) {
 }
 
 R_API int r_buf_append_nbytes(RBuffer *b, int length) {
-	if (!b) return R_FALSE;
+	if (!b || !buf_own (b)) return R_FALSE;
 	if (b->empty) b->length = b->empty = 0;
 	if (!(b->buf = realloc (b->buf, b->length+length)))
 		return R_FALSE;
@@ -266,7 +305,7 @@ R_API int r_buf_append_nbytes(RBuffer *b, int length) {
 }
 
 R_API int r_buf_append_ut16(RBuffer *b, ut16 n) {
-	if (!b) return R_FALSE;
+	if (!b || !buf_own (b)) return R_FALSE;
 	if (b->empty) b->length = b->empty = 0;
 	if (!(b->buf = realloc (b->buf, b->length+sizeof (n))))
 		return R_FALSE;
@@ -276,6 +315,7 @@ R_API int r_buf_append_ut16(RBuffer *b, ut16 n) {
 }
 
 R_API int r_buf_append_ut32(RBuffer *b, ut32 n) {
+	if (!b || !buf_own (b)) return R_FALSE;
 	if (b->empty) b->length = b->empty = 0;
 	if (!(b->buf = realloc (b->buf, b->length+sizeof (n))))
 		return R_FALSE;
@@ -285,7 +325,7 @@ R_API int r_buf_append_ut32(RBuffer *b, ut32 n) {
 }
 
 R_API int r_buf_append_ut64(RBuffer *b, ut64 n) {
-	if (!b) return R_FALSE;
+	if (!b || !buf_own (b)) return R_FALSE;
 	if (b->empty) b->length = b->empty = 0;
 	if (!(b->buf = realloc (b->buf, b->length+sizeof (n))))
 		return R_FALSE;
@@ -295,7 +335,7 @@ R_API int r_buf_append_ut64(RBuffer *b, ut64 n) {
 }
 
 R_API int r_buf_append_buf(RBuffer *b, RBuffer *a) {
-	if (!b) return R_FALSE;
+	if (!b || !buf_own (b)) return R_FALSE;
 	if (b->empty) {
 		b->length = 0;
 		b->empty = 0;
@@ -444,8 +484,10 @@ R_API int r_buf_write_at(RBuffer *b, ut64 addr, const ut8 *buf, int len) {
 	if (!b) return 0;
 	if (b->empty) {
 		b->empty = 0;
-		free (b->buf);
+		buf_drop (b);
 		b->buf = (ut8 *) malloc (addr + len);
+	} else if (!buf_own (b)) {
+		return -1;
 	}
 	return r_buf_cpy (b, addr, b->buf, buf, len, R_TRUE);
 }
@@ -460,10 +502,7 @@ R_API void r_buf_deinit(RBuffer *b) {
 		r_list_free (b->sparse);
 		b->sparse = NULL;
 	}
-	if (b->mmap) {
-		r_file_mmap_free (b->mmap);
-		b->mmap = NULL;
-	} else free (b->buf);
+	buf_drop (b);
 }
 
 R_API void r_buf_free(RBuffer *b) {
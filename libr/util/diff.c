@@ -189,47 +189,175 @@ R_API int r_diff_buffers(RDiff *d, const ut8 *a, ut32 la, const ut8 *b, ut32 lb)
 	return r_diff_buffers_static (d, a, la, b, lb);
 }
 
-/* TODO: Move into r_util maybe? */
-R_API int r_diff_buffers_distance(RDiff *d, const ut8 *a, ut32 la, const ut8 *b, ut32 lb,
-		ut32 *distance, double *similarity) {
-	int i, j, cost, tmin, **m;
+/* Levenshtein distance with Myers' bit-parallel algorithm, in the block
+ * based form described by Hyyro: the shorter buffer is split in blocks
+ * of 64 rows, which keep the vertical deltas of a column of the matrix
+ * in two bitmasks (Pv for +1, Mv for -1), so a column costs one step
+ * per block. Only the blocks crossing the diagonal band that can hold
+ * a path of cost <= k are computed. Cells left out of the band are
+ * overestimated, so the result is exact whenever it is <= k */
 
-	if (!a || !b || la < 1 || lb < 1)
-		return R_FALSE;
+typedef struct {
+	const ut8 *a; // rows, the shorter buffer
+	const ut8 *b; // columns
+	ut32 m, n;
+	int nblocks;
+	ut64 *peq; // peq[c * nblocks + block]: rows of a equal to c
+	ut64 *pv, *mv;
+	ut32 *score; // value at the last row of each block
+} DiffDistance;
 
-	if ((m = malloc ((la+1) * sizeof(int*))) == NULL)
-		return R_FALSE;
-	for(i = 0; i <= la; i++)
-		if ((m[i] = malloc ((lb+1) * sizeof(int))) == NULL) {
-			while (i--)
-				free (m[i]);
-			free (m);
-			return R_FALSE;
+static inline int block_rows(DiffDistance *dd, int b) {
+	return (b == dd->nblocks - 1)? dd->m - b * 64: 64;
+}
+
+/* computes a new column of the block, hin is the horizontal delta
+ * entering by its top, returns the one leaving by its bottom */
+static inline int block_advance(ut64 *pv, ut64 *mv, ut64 eq, int hin, ut64 hibit) {
+	ut64 Pv = *pv, Mv = *mv;
+	ut64 xv, xh, ph, mh;
+	int hout = 0;
+	xv = eq | Mv;
+	if (hin < 0) eq |= 1;
+	xh = (((eq & Pv) + Pv) ^ Pv) | eq;
+	ph = Mv | ~(xh | Pv);
+	mh = Pv & xh;
+	if (ph & hibit) hout = 1;
+	else if (mh & hibit) hout = -1;
+	ph <<= 1;
+	mh <<= 1;
+	if (hin < 0) mh |= 1;
+	else if (hin > 0) ph |= 1;
+	*pv = mh | ~(xv | ph);
+	*mv = ph & xv;
+	return hout;
+}
+
+/* distance between a and b if it is <= k, or something bigger */
+static ut32 distance_band(DiffDistance *dd, ut32 k) {
+	st64 dlo, dhi, lo, hi;
+	ut32 j, delta = dd->n - dd->m;
+	int b, first = 0, last, nfirst, nlast;
+	ut64 lastbit = 1ULL << ((dd->m - 1) % 64);
+	/* a path by diagonal d = j - i costs |d| + |delta - d| at least */
+	dlo = ((st64)delta - (st64)k) / 2;
+	dhi = ((st64)delta + (st64)k + 1) / 2;
+	hi = R_MIN ((st64)dd->m, -dlo);
+	last = (hi < 1)? 0: (int)((hi - 1) / 64);
+	for (b = 0; b <= last; b++) {
+		dd->pv[b] = UT64_MAX;
+		dd->mv[b] = 0;
+		dd->score[b] = b * 64 + block_rows (dd, b);
+	}
+	for (j = 1; j <= dd->n; j++) {
+		const ut64 *eq = dd->peq + dd->b[j - 1] * dd->nblocks;
+		int hin = 1;
+		lo = R_MAX (1, (st64)j - dhi);
+		hi = R_MIN ((st64)dd->m, (st64)j - dlo);
+		if (lo > hi) {
+			// the band left the matrix, nothing below k
+			return UT32_MAX;
+		}
+		nfirst = (int)((lo - 1) / 64);
+		nlast = (int)((hi - 1) / 64);
+		for (b = last + 1; b <= nlast; b++) {
+			dd->pv[b] = UT64_MAX;
+			dd->mv[b] = 0;
+			dd->score[b] = dd->score[b - 1] + block_rows (dd, b);
 		}
+		first = R_MAX (first, nfirst);
+		last = R_MAX (last, nlast);
+		for (b = first; b <= last; b++) {
+			ut64 hibit = (b == dd->nblocks - 1)? lastbit: 1ULL << 63;
+			hin = block_advance (&dd->pv[b], &dd->mv[b], eq[b], hin, hibit);
+			dd->score[b] += hin;
+		}
+	}
+	return (last == dd->nblocks - 1)? dd->score[last]: UT32_MAX;
+}
 
-	for (i = 0; i <= la; i++)
-		m[i][0] = i;
-	for (j = 0; j <= lb; j++)
-		m[0][j] = j;
-
-	for (i = 1; i <= la; i++) {
-		for (j = 1; j <= lb; j++) {
-			if (a[i-1] == b[j-1])
-				cost = 0;
-			else cost = 1;
-			tmin = R_MIN (m[i-1][j] + 1, m[i][j-1] + 1);
-			m[i][j] = R_MIN (tmin, m[i-1][j-1] + cost);
+static int distance(const ut8 *a, ut32 la, const ut8 *b, ut32 lb, ut32 maxk, ut32 *res) {
+	DiffDistance dd = {0};
+	ut32 i, k, d;
+	int ret = R_FALSE;
+	if (la > lb) {
+		const ut8 *t = a; a = b; b = t;
+		k = la; la = lb; lb = k;
+	}
+	if (lb - la > maxk)
+		return R_FALSE;
+	dd.a = a;
+	dd.b = b;
+	dd.m = la;
+	dd.n = lb;
+	dd.nblocks = (la + 63) / 64;
+	dd.peq = calloc (256 * dd.nblocks, sizeof (ut64));
+	dd.pv = malloc (dd.nblocks * sizeof (ut64));
+	dd.mv = malloc (dd.nblocks * sizeof (ut64));
+	dd.score = malloc (dd.nblocks * sizeof (ut32));
+	if (!dd.peq || !dd.pv || !dd.mv || !dd.score)
+		goto beach;
+	for (i = 0; i < la; i++)
+		dd.peq[a[i] * dd.nblocks + i / 64] |= 1ULL << (i % 64);
+	/* widen the band until the distance fits in it */
+	for (k = R_MIN (R_MAX (lb - la, 64), maxk);; k = R_MIN (k * 2, maxk)) {
+		d = distance_band (&dd, k);
+		if (d <= k) {
+			*res = d;
+			ret = R_TRUE;
+			break;
 		}
+		if (k >= maxk)
+			break;
 	}
+beach:
+	free (dd.peq);
+	free (dd.pv);
+	free (dd.mv);
+	free (dd.score);
+	return ret;
+}
 
-	if (distance != NULL)
-		*distance = m[la][lb];
-	if (similarity != NULL)
-		*similarity = (double)1 - (double)(m[la][lb])/(double)(R_MAX(la, lb));
+static double similarity(ut32 distance, ut32 la, ut32 lb) {
+	return (double)1 - (double)distance / (double)R_MAX (la, lb);
+}
 
-	for(i = 0; i <= la; i++)
-		free (m[i]);
-	free (m);
+R_API int r_diff_buffers_distance(RDiff *d, const ut8 *a, ut32 la, const ut8 *b, ut32 lb,
+		ut32 *distance_, double *similarity_) {
+	ut32 dist;
+	if (!a || !b || la < 1 || lb < 1)
+		return R_FALSE;
+	// the distance is never above the longest length
+	if (!distance (a, la, b, lb, R_MAX (la, lb), &dist))
+		return R_FALSE;
+	if (distance_ != NULL)
+		*distance_ = dist;
+	if (similarity_ != NULL)
+		*similarity_ = similarity (dist, la, lb);
+	return R_TRUE;
+}
 
+/* like r_diff_buffers_distance, but gives up as soon as the similarity
+ * can not be above threshold, returning false */
+R_API int r_diff_buffers_distance_limit(RDiff *d, const ut8 *a, ut32 la, const ut8 *b, ut32 lb,
+		ut32 *distance_, double *similarity_, double threshold) {
+	ut32 dist, maxk, lm = R_MAX (la, lb);
+	if (!a || !b || la < 1 || lb < 1)
+		return R_FALSE;
+	/* biggest distance with a similarity above the threshold */
+	if (similarity (0, la, lb) <= threshold)
+		return R_FALSE;
+	maxk = (threshold > 0)? (ut32)((1 - threshold) * lm): lm;
+	maxk = R_MIN (maxk, lm);
+	while (maxk > 0 && similarity (maxk, la, lb) <= threshold)
+		maxk--;
+	while (maxk < lm && similarity (maxk + 1, la, lb) > threshold)
+		maxk++;
+	if (!distance (a, la, b, lb, maxk, &dist))
+		return R_FALSE;
+	if (distance_ != NULL)
+		*distance_ = dist;
+	if (similarity_ != NULL)
+		*similarity_ = similarity (dist, la, lb);
 	return R_TRUE;
 }
@@ -0,0 +1,294 @@
+/* radare - LGPL - Copyright 2015 - pancake */
+
+/* interval tree: AVL tree sorted by (from, seq) and augmented with the
+ * greatest 'to' of every subtree, so stabbing queries only walk the
+ * branches that can contain the requested address */
+
+#include <r_util.h>
+
+#define HEIGHT(x) ((x)? (x)->height: 0)
+#define MAXTO(x) ((x)? (x)->max: 0)
+
+static int cmpkey(ut64 from, ut32 seq, RITreeNode *n) {
+	if (from != n->from) {
+		return (from < n->from)? -1: 1;
+	}
+	if (seq != n->seq) {
+		return (seq < n->seq)? -1: 1;
+	}
+	return 0;
+}
+
+static void node_update(RITreeNode *n) {
+	int hl = HEIGHT (n->child[0]);
+	int hr = HEIGHT (n->child[1]);
+	n->height = 1 + R_MAX (hl, hr);
+	n->max = n->to;
+	if (MAXTO (n->child[0]) > n->max) {
+		n->max = n->child[0]->max;
+	}
+	if (MAXTO (n->child[1]) > n->max) {
+		n->max = n->child[1]->max;
+	}
+}
+
+static RITreeNode *node_rotate(RITreeNode *n, int dir) {
+	RITreeNode *c = n->child[!dir];
+	n->child[!dir] = c->child[dir];
+	c->child[dir] = n;
+	node_update (n);
+	node_update (c);
+	return c;
+}
+
+static RITreeNode *node_balance(RITreeNode *n) {
+	int bal;
+	node_update (n);
+	bal = HEIGHT (n->child[0]) - HEIGHT (n->child[1]);
+	if (bal > 1) {
+		if (HEIGHT (n->child[0]->child[0]) < HEIGHT (n->child[0]->child[1])) {
+			n->child[0] = node_rotate (n->child[0], 0);
+		}
+		return node_rotate (n, 1);
+	}
+	if (bal < -1) {
+		if (HEIGHT (n->child[1]->child[1]) < HEIGHT (n->child[1]->child[0])) {
+			n->child[1] = node_rotate (n->child[1], 1);
+		}
+		return node_rotate (n, 0);
+	}
+	return n;
+}
+
+static RITreeNode *node_insert(RITreeNode *root, RITreeNode *n) {
+	int dir;
+	if (!root) {
+		return n;
+	}
+	dir = cmpkey (n->from, n->seq, root) > 0;
+	root->child[dir] = node_insert (root->child[dir], n);
+	return node_balance (root);
+}
+
+/* unlink the leftmost node of the subtree, returned in *min */
+static RITreeNode *node_unlink_min(RITreeNode *root, RITreeNode **min) {
+	if (!root->child[0]) {
+		*min = root;
+		return root->child[1];
+	}
+	root->child[0] = node_unlink_min (root->child[0], min);
+	return node_balance (root);
+}
+
+static RITreeNode *node_delete(RITreeNode *root, ut64 from, ut32 seq, RITreeNode **del) {
+	RITreeNode *min;
+	int cmp;
+	if (!root) {
+		return NULL;
+	}
+	cmp = cmpkey (from, seq, root);
+	if (cmp) {
+		root->child[cmp > 0] = node_delete (root->child[cmp > 0], from, seq, del);
+		return node_balance (root);
+	}
+	*del = root;
+	if (!root->child[1]) {
+		return root->child[0];
+	}
+	root->child[1] = node_unlink_min (root->child[1], &min);
+	min->child[0] = root->child[0];
+	min->child[1] = root->child[1];
+	return node_balance (min);
+}
+
+static void node_free(RITreeNode *n, RListFree freefn) {
+	if (!n) return;
+	node_free (n->child[0], freefn);
+	node_free (n->child[1], freefn);
+	if (freefn) {
+		freefn (n->data);
+	}
+	free (n);
+}
+
+static int node_stab(RITreeNode *n, ut64 addr, RITreeCallback cb, void *user) {
+	while (n && n->max > addr) {
+		if (!node_stab (n->child[0], addr, cb, user)) {
+			return false;
+		}
+		if (n->from > addr) {
+			break;
+		}
+		if (addr < n->to && !cb (n, user)) {
+			return false;
+		}
+		n = n->child[1];
+	}
+	return true;
+}
+
+static int node_foreach(RITreeNode *n, RITreeCallback cb, void *user) {
+	while (n) {
+		if (!node_foreach (n->child[0], cb, user)) {
+			return false;
+		}
+		if (!cb (n, user)) {
+			return false;
+		}
+		n = n->child[1];
+	}
+	return true;
+}
+
+R_API RITree *r_itree_new(RListFree freefn) {
+	RITree *t = R_NEW0 (RITree);
+	if (!t) return NULL;
+	t->free = freefn;
+	return t;
+}
+
+R_API void r_itree_purge(RITree *t) {
+	if (!t) return;
+	node_free (t->root, t->free);
+	t->root = NULL;
+	t->length = 0;
+	t->seq = 0;
+}
+
+R_API void r_itree_free(RITree *t) {
+	r_itree_purge (t);
+	free (t);
+}
+
+R_API RITreeNode *r_itree_insert(RITree *t, ut64 from, ut64 to, void *data) {
+	RITreeNode *n;
+	if (!t) return NULL;
+	n = R_NEW0 (RITreeNode);
+	if (!n) return NULL;
+	n->from = from;
+	/* wrapped around the end of the address space */
+	n->to = (to < from)? UT64_MAX: to;
+	n->seq = t->seq++;
+	n->data = data;
+	n->height = 1;
+	n->max = n->to;
+	t->root = node_insert (t->root, n);
+	t->length++;
+	return n;
+}
+
+R_API RITreeNode *r_itree_find(RITree *t, ut64 from, void *data) {
+	RITreeNode *n;
+	for (n = r_itree_first (t, from); n && n->from == from; n = r_itree_next (t, n)) {
+		if (n->data == data) {
+			return n;
+		}
+	}
+	return NULL;
+}
+
+/* does not call t->free on the data, the caller still owns it */
+R_API int r_itree_delete(RITree *t, ut64 from, void *data) {
+	RITreeNode *del = NULL, *n = r_itree_find (t, from, data);
+	if (!n) {
+		return false;
+	}
+	t->root = node_delete (t->root, n->from, n->seq, &del);
+	free (del);
+	t->length--;
+	return true;
+}
+
+/* change the end of an interval without moving it in the tree */
+R_API int r_itree_resize(RITree *t, RITreeNode *node, ut64 to) {
+	RITreeNode *path[128], *n;
+	int cmp, depth = 0;
+	if (!t || !node) return false;
+	for (n = t->root; n && depth < 128; ) {
+		path[depth++] = n;
+		cmp = cmpkey (node->from, node->seq, n);
+		if (!cmp) break;
+		n = n->child[cmp > 0];
+	}
+	if (n != node) {
+		return false;
+	}
+	node->to = (to < node->from)? UT64_MAX: to;
+	while (depth--) {
+		node_update (path[depth]);
+	}
+	return true;
+}
+
+/* first node whose 'from' is >= the given address */
+R_API RITreeNode *r_itree_first(RITree *t, ut64 from) {
+	RITreeNode *n, *ret = NULL;
+	if (!t) return NULL;
+	for (n = t->root; n; ) {
+		if (n->from >= from) {
+			ret = n;
+			n = n->child[0];
+		} else {
+			n = n->child[1];
+		}
+	}
+	return ret;
+}
+
+/* last node whose 'from' is <= the given address */
+R_API RITreeNode *r_itree_last(RITree *t, ut64 from) {
+	RITreeNode *n, *ret = NULL;
+	if (!t) return NULL;
+	for (n = t->root; n; ) {
+		if (n->from <= from) {
+			ret = n;
+			n = n->child[1];
+		} else {
+			n = n->child[0];
+		}
+	}
+	return ret;
+}
+
+R_API RITreeNode *r_itree_next(RITree *t, RITreeNode *node) {
+	RITreeNode *n, *ret = NULL;
+	if (!t || !node) return NULL;
+	for (n = t->root; n; ) {
+		if (cmpkey (node->from, node->seq, n) < 0) {
+			ret = n;
+			n = n->child[0];
+		} else {
+			n = n->child[1];
+		}
+	}
+	return ret;
+}
+
+R_API RITreeNode *r_itree_prev(RITree *t, RITreeNode *node) {
+	RITreeNode *n, *ret = NULL;
+	if (!t || !node) return NULL;
+	for (n = t->root; n; ) {
+		if (cmpkey (node->from, node->seq, n) > 0) {
+			ret = n;
+			n = n->child[1];
+		} else {
+			n = n->child[0];
+		}
+	}
+	return ret;
+}
+
+/* visit all the intervals containing addr sorted by 'from', stops when cb returns false */
+R_API int r_itree_stab(RITree *t, ut64 addr, RITreeCallback cb, void *user) {
+	if (!t || !cb) return false;
+	return node_stab (t->root, addr, cb, user);
+}
+
+R_API int r_itree_foreach(RITree *t, RITreeCallback cb, void *user) {
+	if (!t || !cb) return false;
+	return node_foreach (t->root, cb, user);
+}
+
+R_API int r_itree_length(RITree *t) {
+	return t? t->length: 0;
+}
@@ -0,0 +1,176 @@
+/* radare - LGPL - Copyright 2015 - pancake */
+
+/* find runs of printable characters in a buffer, in ASCII or UTF-8 and
+ * in the UTF-16 and UTF-32 encodings (both endians). Bytes are tested 8 at a
+ * time while inside long ASCII runs and long zero fills, which are
+ * the common cases in binaries and memory dumps */
+
+#include <r_util.h>
+
+#define ONES 0x0101010101010101ULL
+#define HIGHS 0x8080808080808080ULL
+/* nonzero when some byte of x is below n (n <= 128) */
+#define HASLESS(x,n) (((x) - ONES * (n)) & ~(x) & HIGHS)
+/* nonzero when some byte of x is above n (n <= 127) */
+#define HASMORE(x,n) ((((x) + ONES * (127 - (n))) | (x)) & HIGHS)
+
+#define ISTEXT(c) (((c) >= ' ' && (c) <= '~') || (c) == '\t')
+/* control characters used in strings: \a\b\t\n\v\f\r\e */
+#define TEXT_CTRL ((1<<7)|(1<<8)|(1<<9)|(1<<10)|(1<<11)|(1<<12)|(1<<13)|(1<<27))
+#define ISESC(c) ((c) < 32 && ((1U << (c)) & TEXT_CTRL))
+
+static inline ut64 load64(const ut8 *p) {
+	ut64 v;
+	memcpy (&v, p, sizeof (v));
+	return v;
+}
+
+/* ascii run starting at buf[0] */
+static int run_ascii(const ut8 *buf, int len) {
+	int i = 0;
+	while (i + 8 <= len) {
+		ut64 x = load64 (buf + i);
+		if (HASLESS (x, ' ') || HASMORE (x, '~'))
+			break;
+		i += 8;
+	}
+	while (i < len && ISTEXT (buf[i]))
+		i++;
+	return i;
+}
+
+/* ascii, escapes and printable utf-8 run starting at buf[0], returns
+ * its size and the number of characters in chars */
+static int run_utf8(const ut8 *buf, int len, int *chars) {
+	int i = 0, n = 0, rc;
+	RRune r;
+	while (i < len) {
+		if (i + 8 <= len) {
+			ut64 x = load64 (buf + i);
+			if (!HASLESS (x, ' ') && !HASMORE (x, '~')) {
+				i += 8;
+				n += 8;
+				continue;
+			}
+		}
+		if ((buf[i] >= ' ' && buf[i] <= '~') || ISESC (buf[i])) {
+			i++;
+		} else if (buf[i] >= 0x80 && (rc = r_utf8_decode (buf + i, len - i, &r)) && r_isprint (r)) {
+			i += rc;
+		} else break;
+		n++;
+	}
+	*chars = n;
+	return i;
+}
+
+/* run of characters in units of size 'unit', little endian if 'at' is
+ * 0 and big endian if it is the last byte. The units may hold any
+ * printable rune, returns the number of characters */
+static int run_wide(const ut8 *buf, int len, int unit, int at) {
+	int i, j, n = 0;
+	ut32 r;
+	for (i = 0; i + unit <= len; i += unit, n++) {
+		for (r = j = 0; j < unit; j++)
+			r = (r << 8) | buf[i + (at? j: unit - 1 - j)];
+		if (r < 0x80) {
+			if (!ISTEXT (r))
+				break;
+		} else if ((r >= 0xd800 && r <= 0xdfff) || r > 0x10ffff || !r_isprint (r)) {
+			break;
+		}
+	}
+	return n;
+}
+
+/* utf-16le strings start with an ascii character followed by a latin-1
+ * one, the characters after them may be any printable rune */
+static inline int wide_start(const ut8 *p, int left) {
+	return left >= 4 && ISTEXT (p[0]) && !p[1] && p[2] && !p[3];
+}
+
+/* bytes at buf that can not be part of any text: NUL and the control
+ * characters not used in strings (\a\b\t\n\v\f\r\e are kept) */
+R_API int r_str_scan_skip(const ut8 *buf, int len) {
+	int i = 0;
+	for (;;) {
+		while (i + 8 <= len && !load64 (buf + i))
+			i += 8;
+		if (i >= len || buf[i] >= 0x20 || ISESC (buf[i]))
+			break;
+		i++;
+	}
+	return R_MIN (i, len);
+}
+
+/* report the runs of at least min characters (and at most max if not 0)
+ * found in the encodings selected in encs, stops when cb returns false.
+ * Returns the number of runs or -1 if stopped */
+R_API int r_str_scan(const ut8 *buf, int len, int min, int max, int encs, RStrScanCallback cb, void *user) {
+	int i = 0, n, count = 0, size, enc;
+	if (!buf || !cb || min < 1)
+		return 0;
+	while (i < len) {
+		const ut8 *p = buf + i;
+		int left = len - i;
+		if (!*p) {
+			// only big endian wide strings start with zero
+			if (left >= 8 && !load64 (p)) {
+				i += 5;
+				continue;
+			}
+			// but not right after text, that is the little endian one
+			if (i && ISTEXT (p[-1])) {
+				i++;
+				continue;
+			}
+			n = 0;
+			if ((encs & R_STRSCAN_UTF16BE) && (n = run_wide (p, left, 2, 1)) >= min) {
+				enc = R_STRSCAN_UTF16BE;
+				size = n * 2;
+			} else if ((encs & R_STRSCAN_UTF32BE) && (n = run_wide (p, left, 4, 3)) >= min) {
+				enc = R_STRSCAN_UTF32BE;
+				size = n * 4;
+			} else {
+				i++;
+				continue;
+			}
+		} else if (ISTEXT (*p) || ((encs & R_STRSCAN_UTF8) && (ISESC (*p) || *p >= 0x80))) {
+			n = 0;
+			enc = 0;
+			if ((encs & R_STRSCAN_UTF16LE) && wide_start (p, left) &&
+					(n = run_wide (p, left, 2, 0)) >= min) {
+				enc = R_STRSCAN_UTF16LE;
+				size = n * 2;
+			} else if ((encs & R_STRSCAN_UTF32LE) && ISTEXT (*p) && left > 1 && !p[1] &&
+					(n = run_wide (p, left, 4, 0)) >= min) {
+				enc = R_STRSCAN_UTF32LE;
+				size = n * 4;
+			}
+			if (!enc) {
+				if (encs & R_STRSCAN_UTF8) {
+					size = run_utf8 (p, left, &n);
+					enc = R_STRSCAN_UTF8;
+				} else {
+					size = n = run_ascii (p, left);
+					enc = (encs & R_STRSCAN_ASCII)? R_STRSCAN_ASCII: 0;
+				}
+				if (!enc || n < min) {
+					// the last character may start a wide string
+					i += (size > 1)? size - 1: 1;
+					continue;
+				}
+			}
+		} else {
+			i++;
+			continue;
+		}
+		if (!max || n <= max) {
+			count++;
+			if (!cb (user, i, n, size, enc))
+				return -1;
+		}
+		i += size;
+	}
+	return count;
+}
@@ -71,6 +71,26 @@ int test_distance()
 	return 1;
 }
 
+int test_distance_limit()
+{
+	char *bufa = "hello";
+	char *bufb = "heprpworld";
+	ut32 distance = 0;
+	double similarity = 0;
+	int ret;
+
+	printf("Similarity above 0.5: '%s' vs '%s'\n", bufa, bufb);
+	ret = r_diff_buffers_distance_limit(NULL, (ut8*)bufa, strlen(bufa), (ut8*)bufb, strlen(bufb),
+		&distance, &similarity, 0.5);
+	printf("%s\n", ret? "yes": "no");
+	printf("Similarity above 0.2: '%s' vs '%s'\n", bufa, bufb);
+	ret = r_diff_buffers_distance_limit(NULL, (ut8*)bufa, strlen(bufa), (ut8*)bufb, strlen(bufb),
+		&distance, &similarity, 0.2);
+	printf("%s: Levenshtein distance = %i\nSimilarity = %f\n",
+			ret? "yes": "no", distance, similarity);
+	return 1;
+}
+
 #if 0
 int test_lines(char *file1, char *file2)
 {
@@ -102,6 +122,8 @@ int main()
 	printf("--\n");
 	test_distance();
 	printf("--\n");
+	test_distance_limit();
+	printf("--\n");
 //	test_lines("file1", "file2");
 
 
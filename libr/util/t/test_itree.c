@@ -0,0 +1,61 @@
+#include <r_util.h>
+
+void check (int n, int exp) {
+	if (n == exp) {
+		printf("[+] test passed (actual: %d; expected: %d)\n", n, exp);
+	} else {
+		printf("[-] test failed (actual: %d; expected: %d)\n", n, exp);
+	}
+}
+
+static int count_cb (RITreeNode *n, void *user) {
+	(*(int *)user)++;
+	return R_TRUE;
+}
+
+static int stab (RITree *t, ut64 addr) {
+	int n = 0;
+	r_itree_stab (t, addr, count_cb, &n);
+	return n;
+}
+
+int main(int argc, char **argv) {
+	RITree *t = r_itree_new (NULL);
+	RITreeNode *n;
+	int i;
+
+	for (i = 0; i < 1000; i++) {
+		r_itree_insert (t, i * 0x10, i * 0x10 + 0x10, (void *)(size_t)(i + 1));
+	}
+	r_itree_insert (t, 0x100, 0x400, (void *)0x1000);
+	r_itree_insert (t, 0x100, 0x110, (void *)0x1001);
+	check (r_itree_length (t), 1002);
+	check (stab (t, 0x105), 3);
+	check (stab (t, 0x3ff), 2);
+	check (stab (t, 0x400), 1);
+	check (stab (t, 0x10000), 0);
+
+	n = r_itree_first (t, 0x100);
+	check ((int)(size_t)n->data, 0x11);
+	n = r_itree_next (t, n);
+	check ((int)(size_t)n->data, 0x1000);
+	n = r_itree_last (t, 0x105);
+	check ((int)(size_t)n->data, 0x1001);
+	n = r_itree_prev (t, n);
+	check ((int)(size_t)n->data, 0x1000);
+
+	r_itree_resize (t, r_itree_find (t, 0x100, (void *)0x1000), 0x800);
+	check (stab (t, 0x7ff), 2);
+	check (r_itree_delete (t, 0x100, (void *)0x1000), R_TRUE);
+	check (r_itree_delete (t, 0x100, (void *)0x1000), R_FALSE);
+	check (stab (t, 0x105), 2);
+	for (i = 0; i < 1000; i += 2) {
+		r_itree_delete (t, i * 0x10, (void *)(size_t)(i + 1));
+	}
+	check (r_itree_length (t), 501);
+	check (stab (t, 0x105), 1);
+	check (stab (t, 0x115), 1);
+
+	r_itree_free (t);
+	return 0;
+}
@@ -0,0 +1,48 @@
+#include <r_util.h>
+
+void check (int n, int exp) {
+	if (n == exp) {
+		printf("[+] test passed (actual: %d; expected: %d)\n", n, exp);
+	} else {
+		printf("[-] test failed (actual: %d; expected: %d)\n", n, exp);
+	}
+}
+
+typedef struct {
+	int off, len, size, enc;
+} Run;
+
+static int run_cb (void *user, int off, int len, int size, int enc) {
+	Run *r = user;
+	r->off = off;
+	r->len = len;
+	r->size = size;
+	r->enc = enc;
+	return R_FALSE;
+}
+
+static void scan (const ut8 *buf, int len, int encs, int off, int chars, int size, int enc) {
+	Run r = { -1, 0, 0, 0 };
+	r_str_scan (buf, len, 3, 0, encs, run_cb, &r);
+	check (r.off, off);
+	check (r.len, chars);
+	check (r.size, size);
+	check (r.enc, enc);
+}
+
+int main(int argc, char **argv) {
+	/* "héllo" and "- Привет" in utf-16le, "été" in utf-32be */
+	const ut8 w16[] = "\x01\x02h\0\xe9\0l\0l\0o\0\0\0";
+	const ut8 cyr[] = "\xff-\0 \0\x1f\x04\x40\x04\x38\x04\x32\x04\x35\x04\x42\x04\0\0";
+	const ut8 w32[] = "\x01\0\0\0\xe9\0\0\0t\0\0\0\xe9\0\0";
+	const ut8 utf8[] = "\x01h\xc3\xa9llo\0";
+	const ut8 bad[] = "\x01h\0i\0\0\xd8l\0l\0o\0\0\0";
+
+	scan (w16, sizeof (w16), R_STRSCAN_ALL, 2, 5, 10, R_STRSCAN_UTF16LE);
+	scan (cyr, sizeof (cyr), R_STRSCAN_ALL, 1, 8, 16, R_STRSCAN_UTF16LE);
+	scan (w32, sizeof (w32), R_STRSCAN_ALL, 1, 3, 12, R_STRSCAN_UTF32BE);
+	scan (utf8, sizeof (utf8), R_STRSCAN_UTF8, 1, 5, 6, R_STRSCAN_UTF8);
+	/* lone surrogates are not text */
+	scan (bad, sizeof (bad), R_STRSCAN_UTF16LE, 7, 3, 6, R_STRSCAN_UTF16LE);
+	return 0;
+}
@@ -1,4 +1,4 @@
-/* radare - LGPL - Copyright 2009-2012 - pancake */
+/* radare - LGPL - Copyright 2009-2015 - pancake */
 
 #include <r_th.h>
 
@@ -62,11 +62,13 @@ R_API int r_th_kill(struct r_th_t *th, int force) {
 	r_th_break(th);
 	r_th_wait(th);
 #if HAVE_PTHREAD
+	if (th->tid) {
 #ifdef __ANDROID__
-	pthread_kill (th->tid, 9);
+		pthread_kill (th->tid, 9);
 #else
-	pthread_cancel (th->tid);
+		pthread_cancel (th->tid);
 #endif
+	}
 #endif
 	return 0;
 }
@@ -94,9 +96,11 @@ R_API int r_th_wait(struct r_th_t *th) {
 	int ret = R_FALSE;
 #if HAVE_PTHREAD
 	void *thret;
-	if (th) {
+	// a thread can only be joined once
+	if (th && th->tid) {
 		ret = pthread_join (th->tid, &thret);
 		th->running = R_FALSE;
+		th->tid = 0;
 	}
 #endif
 	return ret;
@@ -281,6 +281,10 @@ R_API int r_utf8_strlen (const ut8 *str) {
 R_API int r_isprint (const RRune c) {
 	int low, hi, mid;
 
+	// most runes are ascii, no need to look at the table for them
+	if (c >= 0 && c < 0x80)
+		return c >= 0x20 && c < 0x7f;
+
 	low = 0;
 	hi = nonprintable_ranges_count - 1;
 
@@ -38,27 +38,31 @@ void cdb_findstart(struct cdb *c) {
 	c->loop = 0;
 }
 
+/* the previous map of c, if any, is released */
 int cdb_init(struct cdb *c, int fd) {
 	struct stat st;
-	c->map = NULL;
+	cdb_free (c);
+	c->size = 0;
 	c->fd = fd;
 	cdb_findstart (c);
-	if (fd != -1 && !fstat (fd, &st) && st.st_size>4 && st.st_size != (off_t)UT64_MAX) {
+	if (fd != -1 && !fstat (fd, &st) && st.st_size>4 && st.st_size <= UT32_MAX) {
 #if USE_MMAN
 		char *x = mmap (0, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		if (x == MAP_FAILED)
+			x = NULL;
 #else
 		char *x = malloc (st.st_size);
-		if (!x) return 0;
-		read (fd, x, st.st_size); // TODO: handle return value
+		if (x && (!seek_set (fd, 0) || read (fd, x, st.st_size) != st.st_size)) {
+			free (x);
+			x = NULL;
+		}
 #endif
-		if (x + 1) {
+		if (x) {
 			c->size = st.st_size;
 			c->map = x;
 		}
 		return 1;
 	}
-	c->map = NULL;
-	c->size = 0;
 	return 0;
 }
 
@@ -83,9 +87,31 @@ int cdb_read(struct cdb *c, char *buf, ut32 len, ut32 pos) {
 	return 1;
 }
 
+/* lengths of the record at pos */
+int cdb_kvlen(struct cdb *c, ut32 *klen, ut32 *vlen, ut32 pos) {
+	const ut8 *p;
+	if (!c->map) {
+		if (!seek_set (c->fd, pos))
+			return 0;
+		return cdb_getkvlen (c->fd, klen, vlen);
+	}
+	*klen = *vlen = 0;
+	if (pos > c->size || c->size - pos < KVLSZ)
+		return 0;
+	p = (const ut8 *)c->map + pos;
+	*klen = (ut32)p[0];
+	*vlen = (ut32)(p[1] | ((ut32)p[2]<<8) | ((ut32)p[3]<<16));
+	return 1;
+}
+
 static int match(struct cdb *c, const char *key, ut32 len, ut32 pos) {
 	char buf[32];
 	const size_t szb = sizeof buf;
+	if (c->map) {
+		if (pos > c->size || c->size - pos < len)
+			return -1;
+		return !memcmp (c->map + pos, key, len);
+	}
 	while (len > 0) {
 		int n = (szb>len)? len: szb;
 		if (!cdb_read (c, buf, n, pos))
@@ -130,10 +156,7 @@ int cdb_findnext(struct cdb *c, ut32 u, const char *key, ut32 len) {
 			c->kpos = c->hpos;
 		ut32_unpack (buf, &u);
 		if (u == c->khash) {
-			if (!seek_set (c->fd, pos)) {
-				return -1;
-			}
-			if (!cdb_getkvlen (c->fd, &u, &c->dlen)) {
+			if (!cdb_kvlen (c, &u, &c->dlen, pos)) {
 				return -1;
 			}
 			if (u == 0) {
@@ -31,6 +31,7 @@ void cdb_free(struct cdb *);
 int cdb_init(struct cdb *, int fd);
 void cdb_findstart(struct cdb *);
 int cdb_read(struct cdb *, char *, unsigned int, ut32);
+int cdb_kvlen(struct cdb *, ut32 *, ut32 *, ut32);
 int cdb_findnext(struct cdb *, ut32 u, const char *, ut32);
 
 #define cdb_datapos(c) ((c)->dpos)
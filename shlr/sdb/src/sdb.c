@@ -74,9 +74,8 @@ SDB_API Sdb* sdb_new (const char *path, const char *name, int lock) {
 		goto fail;
 	s->ns->free = NULL;
 	if (!s->ns) goto fail;
-	s->ht = ht_new ((SdbListFree)sdb_kv_free);
+	s->ht = ht_new ();
 	s->lock = lock;
-	// s->ht->list->free = (SdbListFree)sdb_kv_free;
 	// if open fails ignore
 	if (global_hook)
 		sdb_hook (s, global_hook, global_user);
@@ -123,7 +122,10 @@ static void sdb_fini(Sdb* s, int donull) {
 	}
 	free (s->ndump);
 	free (s->dir);
+	free (s->tmpkv.key);
 	free (s->tmpkv.value);
+	s->tmpkv.key = NULL;
+	s->tmpkv.value = NULL;
 	s->tmpkv.value_len = 0;
 	if (donull)
 		memset (s, 0, sizeof (Sdb));
@@ -154,7 +156,7 @@ SDB_API const char *sdb_const_get_len (Sdb* s, const char *key, int *vlen, ut32
 	keylen = strlen (key)+1;
 	hash = sdb_hash (key);
 	/* search in memory */
-	kv = (SdbKv*)ht_lookup (s->ht, hash);
+	kv = ht_lookup (s->ht, key, hash);
 	if (kv) {
 		if (!*kv->value)
 			return NULL;
@@ -178,6 +180,8 @@ SDB_API const char *sdb_const_get_len (Sdb* s, const char *key, int *vlen, ut32
 	len = cdb_datalen (&s->db);
 	if (len == 0)
 		return NULL;
+	if (!s->db.map)
+		return NULL;
 	if (vlen) *vlen = len;
 	pos = cdb_datapos (&s->db);
 	return s->db.map+pos;
@@ -202,7 +206,7 @@ SDB_API char *sdb_get_len (Sdb* s, const char *key, int *vlen, ut32 *cas) {
 	hash = sdb_hash (key);
 
 	/* search in memory */
-	kv = (SdbKv*)ht_lookup (s->ht, hash);
+	kv = ht_lookup (s->ht, key, hash);
 	if (kv) {
 		if (!*kv->value)
 			return NULL;
@@ -248,10 +252,9 @@ SDB_API int sdb_unset (Sdb* s, const char *key, ut32 cas) {
 SDB_API int sdb_remove(Sdb *s, const char *key, ut32 cas) {
 	SdbHashEntry *e;
 	ut32 hash = sdb_hash (key);
-	e = ht_search (s->ht, hash);
+	e = ht_search (s->ht, key, hash);
 	if (e) {
 		ht_delete_entry (s->ht, e);
-		ls_delete (s->ht->list, e->iter);
 		return 1;
 	}
 	return 0;
@@ -303,7 +306,7 @@ SDB_API int sdb_exists (Sdb* s, const char *key) {
 	SdbKv *kv;
 	int klen = strlen (key)+1;
 	ut32 pos, hash = sdb_hash (key);
-	kv = (SdbKv*)ht_lookup (s->ht, hash);
+	kv = ht_lookup (s->ht, key, hash);
 	if (kv) return (*kv->value)? 1: 0;
 	if (s->fd == -1)
 		return 0;
@@ -349,6 +352,7 @@ SDB_API int sdb_open (Sdb *s, const char *file) {
 
 SDB_API void sdb_close (Sdb *s) {
 	if (!s) return;
+	cdb_free (&s->db);
 	if (s->fd != -1) {
 		close (s->fd);
 		s->fd = -1;
@@ -367,13 +371,14 @@ SDB_API void sdb_reset (Sdb* s) {
 	/* empty memory hashtable */
 	if (s->ht)
 		ht_free (s->ht);
-	s->ht = ht_new ((SdbListFree)sdb_kv_free);
+	s->ht = ht_new ();
 }
 
-// TODO: too many allocs here. use slices
+/* the kvs of the sdb are allocated by its hashtable, these are for the
+ * ones outside of it and keep the key in the same block */
 SDB_API SdbKv* sdb_kv_new (const char *k, const char *v) {
 	SdbKv *kv;
-	int vl;
+	int kl, vl;
 	if (!sdb_check_key (k))
 		return NULL;
 	if (v) {
@@ -383,8 +388,11 @@ SDB_API SdbKv* sdb_kv_new (const char *k, const char *v) {
 	} else {
 		vl = 0;
 	}
-	kv = R_NEW (SdbKv);
-	strncpy (kv->key, k, sizeof (kv->key)-1);
+	kl = strlen (k)+1;
+	if (!(kv = malloc (sizeof (SdbKv) + kl)))
+		return NULL;
+	kv->key = (char *)(kv + 1);
+	memcpy (kv->key, k, kl);
 	kv->value_len = vl;
 	if (vl) {
 		kv->value = malloc (vl);
@@ -401,9 +409,8 @@ SDB_API void sdb_kv_free (SdbKv *kv) {
 }
 
 static int sdb_set_internal (Sdb* s, const char *key, char *val, int owned, ut32 cas) {
-	ut32 hash, klen;
-	SdbHashEntry *e;
 	SdbKv *kv;
+	ut32 hash;
 	int vlen;
 	if (!s || !key)
 		return 0;
@@ -415,52 +422,49 @@ static int sdb_set_internal (Sdb* s, const char *key, char *val, int owned, ut32
 	if (s->journal != -1) {
 		sdb_journal_log (s, key, val);
 	}
-	klen = strlen (key)+1;
 	vlen = strlen (val)+1;
 	hash = sdb_hash (key);
-	cdb_findstart (&s->db);
-	e = ht_search (s->ht, hash);
-	if (e) {
-		if (cdb_findnext (&s->db, hash, key, klen)) {
-			kv = e->data;
-			if (cas && kv->cas != cas)
-				return 0;
-			kv->cas = cas = nextcas ();
-			if (owned) {
-				kv->value_len = vlen;
+	kv = ht_lookup (s->ht, key, hash);
+	if (kv) {
+		if (cas && kv->cas != cas)
+			return 0;
+		kv->cas = cas = nextcas ();
+		if (owned) {
+			kv->value_len = vlen;
+			free (kv->value);
+			kv->value = val; // owned
+		} else {
+			if (vlen>kv->value_len) {
 				free (kv->value);
-				kv->value = val; // owned
+				kv->value = strdup (val);
 			} else {
-				if (vlen>kv->value_len) {
-					free (kv->value);
-					kv->value = strdup (val);
-				} else {
-					memcpy (kv->value, val, vlen);
-				}
-				kv->value_len = vlen;
+				memcpy (kv->value, val, vlen);
 			}
-		} else ht_delete_entry (s->ht, e);
+			kv->value_len = vlen;
+		}
 		sdb_hook_call (s, key, val);
 		return cas;
 	}
 	// empty values are also stored
 	// TODO store only the ones that are in the CDB
-	if (owned) {
-		kv = sdb_kv_new (key, NULL);
-		if (kv) {
+	kv = ht_insert (s->ht, key, hash);
+	if (kv) {
+		if (owned) {
 			kv->value = val;
-			kv->value_len = vlen;
+		} else if (!(kv->value = malloc (vlen))) {
+			sdb_remove (s, key, 0);
+			return 0;
+		} else {
+			memcpy (kv->value, val, vlen);
 		}
-	} else {
-		kv = sdb_kv_new (key, val);
-	}
-	if (kv) {
+		kv->value_len = vlen;
 		kv->cas = nextcas ();
-		ht_insert (s->ht, hash, kv, NULL);
 		sdb_hook_call (s, key, val);
 		return kv->cas;
 	}
 	sdb_hook_call (s, key, val);
+	if (owned)
+		free (val);
 	return 0;
 }
 
@@ -472,11 +476,55 @@ SDB_API int sdb_set (Sdb* s, const char *key, const char *val, ut32 cas) {
 	return sdb_set_internal (s, key, (char*)val, 0, cas);
 }
 
+/* next record of the disk database from s->pos. Key and value point into
+ * the map when the file is mapped, or to buffers in s->tmpkv that are
+ * reused by the next call. The lengths include the trailing nul */
+static int dump_next(Sdb *s, const char **key, ut32 *klen, const char **val, ut32 *vlen) {
+	ut32 kl, vl, p;
+	char *v;
+	if (s->fd == -1)
+		return 0;
+	if (!cdb_kvlen (&s->db, &kl, &vl, s->pos) || kl<1 || vl<1)
+		return 0;
+	if (s->eod && (ut64)s->pos + KVLSZ + kl + vl > s->eod)
+		return 0;
+	p = s->pos + KVLSZ;
+	if (s->db.map && (ut64)p + kl + vl <= s->db.size
+			&& !s->db.map[p + kl - 1] && !s->db.map[p + kl + vl - 1]) {
+		*key = s->db.map + p;
+		*val = s->db.map + p + kl;
+	} else {
+		char *k;
+		if (kl >= SDB_KSZ)
+			return 0;
+		if (!(k = realloc (s->tmpkv.key, kl + 1)))
+			return 0;
+		s->tmpkv.key = k;
+		if (!(v = realloc (s->tmpkv.value, vl + 1)))
+			return 0;
+		s->tmpkv.value = v;
+		if (!cdb_read (&s->db, k, kl, p) || !cdb_read (&s->db, v, vl, p + kl))
+			return 0;
+		k[kl] = 0;
+		v[vl] = 0;
+		*key = k;
+		*val = v;
+	}
+	*klen = kl;
+	*vlen = vl;
+	s->pos = p + kl + vl;
+	return 1;
+}
+
 static int sdb_foreach_list_cb(void *user, const char *k, const char *v) {
 	SdbList *list = (SdbList *)user;
+	int kl = strlen (k)+1;
+	SdbKv *kv = calloc (1, sizeof (SdbKv) + kl);
 	list->free = free;
-	SdbKv *kv = R_NEW0 (SdbKv);
-	strncpy (kv->key, k, sizeof (kv->key)-1);
+	if (!kv)
+		return 0;
+	kv->key = (char *)(kv + 1);
+	memcpy (kv->key, k, kl);
 	kv->value = (char*)v;
 	ls_append (list, kv);
 	return 1;
@@ -490,17 +538,14 @@ SDB_API SdbList *sdb_foreach_list (Sdb* s) {
 
 SDB_API int sdb_foreach (Sdb* s, SdbForeachCallback cb, void *user) {
 	SdbListIter *iter;
-	char *k, *v;
+	const char *k, *v;
+	ut32 klen, vlen;
 	SdbKv *kv;
 	if (!s) return 0;
 	sdb_dump_begin (s);
-	while (sdb_dump_dupnext (s, &k, &v, NULL)) {
-		ut32 hash = sdb_hash (k);
-		SdbHashEntry *hte = ht_search (s->ht, hash);
-		if (hte) {
-			free (k);
-			free (v);
-			kv = (SdbKv*)hte->data;
+	while (dump_next (s, &k, &klen, &v, &vlen)) {
+		kv = ht_lookup (s->ht, k, sdb_hash (k));
+		if (kv) {
 			if (!*kv->value) {
 				// deleted = 1;
 				continue;
@@ -508,10 +553,8 @@ SDB_API int sdb_foreach (Sdb* s, SdbForeachCallback cb, void *user) {
 			if (!cb (user, kv->key, kv->value))
 				return 0;
 		} else {
-			int ret = cb (user, k, v);
-			free (k);
-			free (v);
-			if (!ret) return 0;
+			if (!cb (user, k, v))
+				return 0;
 		}
 	}
 	ls_foreach (s->ht->list, iter, kv) {
@@ -536,37 +579,34 @@ SDB_API void sdb_list (Sdb* s) {
 	}
 }
 
+/* the records are streamed from the current file (from its map when
+ * possible) into the new one, taking the value from memory for the keys
+ * that are there, then the keys only in memory are appended */
 SDB_API int sdb_sync (Sdb* s) {
 	SdbListIter it, *iter;
-	char *k, *v;
+	const char *k, *v;
+	ut32 klen, vlen;
 	SdbKv *kv;
 
 	if (!s || !sdb_disk_create (s)) {
 		return 0;
 	}
-// TODO: use sdb_foreach here
 	sdb_dump_begin (s);
 	/* iterate over all keys in disk database */
-	while (sdb_dump_dupnext (s, &k, &v, NULL)) {
-		ut32 hash = sdb_hash (k);
+	while (dump_next (s, &k, &klen, &v, &vlen)) {
 		/* find that key in the memory storage */
-		SdbHashEntry *hte = ht_search (s->ht, hash);
+		SdbHashEntry *hte = ht_search (s->ht, k, sdb_hash (k));
 		if (hte) {
-			kv = (SdbKv*)hte->data;
-			if (kv && *kv->value) {
-				/* asume k = kv->key */
+			kv = hte->kv;
+			if (*kv->value) {
 				sdb_disk_insert (s, k, kv->value);
 			}
 			// XXX: This fails if key is dupped
 			//else printf ("remove (%s)\n", kv->key);
-			ls_delete (s->ht->list, hte->iter);
-			hte->iter = NULL;
 			ht_delete_entry (s->ht, hte);
-		} else if (v && *v) {
+		} else if (*v) {
 			sdb_disk_insert (s, k, v);
 		}
-		free (k);
-		free (v);
 	}
 	/* append new keyvalues */
 	ls_foreach (s->ht->list, iter, kv) {
@@ -585,18 +625,15 @@ SDB_API int sdb_sync (Sdb* s) {
 	return 1;
 }
 
-// TODO: optimize: do not use syscalls here. we can just do mmap and pointer arithmetics
-static int getbytes(Sdb *s, char *b, int len) {
-	if (read (s->fd, b, len) != len)
-		return -1;
-	s->pos += len;
-	return len;
-}
-
 SDB_API void sdb_dump_begin (Sdb* s) {
-	if (s->fd != -1)
-		seek_set (s->fd, (s->pos=2048));
-	else s->pos = 0;
+	char buf[4];
+	s->eod = 0;
+	if (s->fd != -1) {
+		s->pos = 2048;
+		/* the first hash table starts right after the records */
+		if (cdb_read (&s->db, buf, sizeof (buf), 0))
+			ut32_unpack (buf, &s->eod);
+	} else s->pos = 0;
 }
 
 SDB_API SdbKv *sdb_dump_next (Sdb* s) {
@@ -606,9 +643,8 @@ SDB_API SdbKv *sdb_dump_next (Sdb* s) {
 	if (!sdb_dump_dupnext (s, &k, &v, &vl))
 		return NULL;
 	vl--;
-	strncpy (s->tmpkv.key, k, SDB_KSZ-1);
-	s->tmpkv.key[SDB_KSZ-1] = '\0';
-	free (k);
+	free (s->tmpkv.key);
+	s->tmpkv.key = k;
 	free (s->tmpkv.value);
 	s->tmpkv.value = v;
 	s->tmpkv.value_len = vl;
@@ -619,14 +655,13 @@ SDB_API int sdb_dump_hasnext (Sdb* s) {
 	ut32 k, v;
 	if (s->fd==-1)
 		return 0;
-	if (!cdb_getkvlen (s->fd, &k, &v))
+	if (!cdb_kvlen (&s->db, &k, &v, s->pos))
 		return 0;
 	if (k<1 || v<1)
 		return 0;
-	if (lseek (s->fd, k+v, SEEK_CUR) == -1) {
+	if (s->eod && (ut64)s->pos + KVLSZ + k + v > s->eod)
 		return 0;
-	}
-	s->pos += k + v + 4;
+	s->pos += k + v + KVLSZ;
 	return 1;
 }
 
@@ -650,59 +685,33 @@ SDB_API int sdb_stats(Sdb *s, ut32 *disk, ut32 *mem) {
 
 // TODO: make it static? internal api?
 SDB_API int sdb_dump_dupnext (Sdb* s, char **key, char **value, int *_vlen) {
-	ut32 vlen = 0, klen = 0;
+	const char *k, *v;
+	ut32 klen, vlen;
 	if (key) *key = NULL;
 	if (value) *value = NULL;
 	if (_vlen)
 		*_vlen = 0;
-	if (s->fd==-1)
-		return 0;
-	if (!cdb_getkvlen (s->fd, &klen, &vlen))
+	if (!dump_next (s, &k, &klen, &v, &vlen))
 		return 0;
-	if (klen<1 || vlen<1) {
-		return 0;
-	}
 	if (_vlen)
 		*_vlen = vlen;
-	if (key) {
-		*key = 0;
-		if (klen>=SDB_MIN_KEY && klen<SDB_MAX_KEY) {
-			*key = malloc (klen+1);
-			if (!*key) {
-				return 0;
-			}
-			if (getbytes (s, *key, klen) == -1) {
+	if (key && klen>=SDB_MIN_KEY && klen<SDB_MAX_KEY) {
+		if (!(*key = malloc (klen+1)))
+			return 0;
+		memcpy (*key, k, klen);
+		(*key)[klen] = 0;
+	}
+	if (value && vlen>=SDB_MIN_VALUE && vlen<SDB_MAX_VALUE) {
+		if (!(*value = malloc (vlen+10))) {
+			if (key) {
 				free (*key);
 				*key = NULL;
-				return 0;
 			}
-			(*key)[klen] = 0;
-		}
-	}
-	if (value) {
-		*value = 0;
-		if (vlen>=SDB_MIN_VALUE && vlen<SDB_MAX_VALUE) {
-			*value = malloc (vlen+10);
-			if (!*value) {
-				if (key) {
-					free (*key);
-					*key = NULL;
-				}
-				return 0;
-			}
-			if (getbytes (s, *value, vlen)==-1) {
-				if (key) {
-					free (*key);
-					*key = NULL;
-				}
-				free (*value);
-				*value = NULL;
-				return 0;
-			}
-			(*value)[vlen] = 0;
+			return 0;
 		}
+		memcpy (*value, v, vlen);
+		(*value)[vlen] = 0;
 	}
-	s->pos += 4; // XXX no.
 	return 1;
 }
 
@@ -721,7 +730,7 @@ SDB_API int sdb_expire_set(Sdb* s, const char *key, ut64 expire, ut32 cas) {
 		return 1;
 	}
 	hash = sdb_hash (key);
-	kv = (SdbKv*)ht_lookup (s->ht, hash);
+	kv = ht_lookup (s->ht, key, hash);
 	if (kv) {
 		if (*kv->value) {
 			if (!cas || cas == kv->cas) {
@@ -751,7 +760,7 @@ SDB_API int sdb_expire_set(Sdb* s, const char *key, ut64 expire, ut32 cas) {
 SDB_API ut64 sdb_expire_get(Sdb* s, const char *key, ut32 *cas) {
 	SdbKv *kv;
 	ut32 hash = sdb_hash (key);
-	kv = (SdbKv*)ht_lookup (s->ht, hash);
+	kv = ht_lookup (s->ht, key, hash);
 	if (kv && *kv->value) {
 		if (cas) *cas = kv->cas;
 		return kv->expire;
@@ -56,14 +56,6 @@ extern char *strdup (const char *);
 // This size implies trailing zero terminator, this is 254 chars + 0
 #define SDB_KSZ 0xff
 
-typedef struct sdb_kv {
-	char key[SDB_KSZ];
-	char *value;
-	int value_len;
-	ut64 expire;
-	ut32 cas;
-} SdbKv;
-
 typedef struct sdb_t {
 	char *dir; // path+name
 	char *path;